@@ -0,0 +1,1294 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <thread>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "bench.h"
+#include "shader.h"
+#include "shadervariants.h"
+#include "mesh.h"
+#include "impostor.h"
+#include "nbody.h"
+#include "collision.h"
+#include "kepler.h"
+#include "scenegraph.h"
+#include "generate.h"
+#include "poisson.h"
+#include "camerapath.h"
+#include "cluster.h"
+#include "deferred.h"
+#include "shadow.h"
+#include "ssao.h"
+#include "oit.h"
+#include "rng.h"
+
+/*Benchmark variables
+*
+* @benchmarkFrames is how many frames are timed for every case, the first frame is drawn before and not counted
+* @benchmarkResolutions are the resolutions of the tessellated Spheres, the ray casting doesn't depend on it
+*
+*/
+const int benchmarkFrames = 3;
+const double benchmarkResolutions[] = { 8, 32 };
+
+/*
+* Wall clock time in seconds for the CPU benchmarks, they run before any window is created
+*
+*/
+static double benchmarkClock() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+* Bodies spread uniformly inside a ball of radius 50 with a fixed seed, so every run measures the same scene
+*
+*/
+static std::vector<Planet> benchmarkBodies(size_t count) {
+
+	std::vector<Planet> bodies(count);
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+	for (size_t i = 0; i < count; i++) {
+		glm::dvec3 p;
+		do {
+			p = glm::dvec3(coordinate(generator), coordinate(generator), coordinate(generator));
+		} while (glm::dot(p, p) > 1.0);
+		bodies[i].xpos = p.x * 50.0;
+		bodies[i].ypos = p.y * 50.0;
+		bodies[i].zpos = p.z * 50.0;
+		bodies[i].id = (int)i;
+	}
+	return bodies;
+}
+
+/*
+* The Spheres are placed on a spiral in front of the default camera, their size shrinks as the count grows
+* so the covered area of the screen stays about the same for each count.
+*
+*/
+static std::vector<SphereInstance> benchmarkSpheres(int count) {
+
+	std::vector<SphereInstance> spheres(count);
+	float radius = 20.0f / sqrtf((float)count);
+	for (int i = 0; i < count; i++) {
+		float distance = 20.0f * sqrtf((float)i / count);
+		glm::vec3 center(cosf((float)i) * distance, 0.0f, sinf((float)i) * distance);
+		spheres[i].centerRadius = glm::vec4(center, radius);
+		spheres[i].objectColor = glm::vec3(0.8f, 0.5f, 0.3f);
+		spheres[i].lightColor = glm::vec3(1.0f);
+		spheres[i].lightPos = center;
+	}
+	return spheres;
+}
+
+static void drawTessellated(GLuint meshShader, const Mesh& sphere, const std::vector<SphereInstance>& spheres) {
+
+	glUseProgram(meshShader);
+	GLint objectColorLoc = glGetUniformLocation(meshShader, "objectColor");
+	GLint lightColorLoc = glGetUniformLocation(meshShader, "lightColor");
+	GLint lightPosLoc = glGetUniformLocation(meshShader, "lightPos");
+	GLint centerLoc = glGetUniformLocation(meshShader, "center");
+	GLint radiusLoc = glGetUniformLocation(meshShader, "radius");
+	for (size_t i = 0; i < spheres.size(); i++) {
+		const SphereInstance& s = spheres[i];
+		glUniform3f(objectColorLoc, s.objectColor.r, s.objectColor.g, s.objectColor.b);
+		glUniform3f(lightColorLoc, s.lightColor.r, s.lightColor.g, s.lightColor.b);
+		glUniform3f(lightPosLoc, s.lightPos.x, s.lightPos.y, s.lightPos.z);
+		glUniform3f(centerLoc, s.centerRadius.x, s.centerRadius.y, s.centerRadius.z);
+		glUniform1f(radiusLoc, s.centerRadius.w);
+		drawMesh(sphere);
+	}
+}
+
+/*
+* Returns the average milliseconds of a frame, glFinish() makes sure the GPU (or llvmpipe) is done before reading the clock
+*
+*/
+static double timeFrames(GLFWwindow* window, GLuint meshShader, GLuint raycastShader, const Mesh* sphere, const std::vector<SphereInstance>& spheres) {
+
+	double start = 0;
+	for (int frame = 0; frame <= benchmarkFrames; frame++) {
+		if (frame == 1) {
+			glFinish();
+			start = glfwGetTime();
+		}
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (sphere != NULL) {
+			drawTessellated(meshShader, *sphere, spheres);
+		}
+		else
+		{
+			drawRaycastSpheres(raycastShader, spheres);
+		}
+		glfwSwapBuffers(window);
+	}
+	glFinish();
+	return (glfwGetTime() - start) * 1000.0 / benchmarkFrames;
+}
+
+void benchmarkSphereRendering(GLFWwindow* window, GLuint meshShader, GLuint raycastShader) {
+
+	const int counts[] = { 10000, 100000, 1000000 };
+
+	glm::vec3 cameraPos(0.0f, 40.0f, 20.0f);
+	glm::mat4 model;
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(45.0f, 1.0f, 0.1f, 100.0f);
+	setCameraUniforms(raycastShader, model, view, projection);
+	setCameraUniforms(meshShader, model, view, projection);
+	glUniform3f(glGetUniformLocation(meshShader, "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+
+	// Make the swaps return right away so only the drawing is timed
+	glfwSwapInterval(0);
+
+	std::cout << "BENCHMARK::RENDER " << (const char*)glGetString(GL_RENDERER) << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (int c = 0; c < 3; c++) {
+		std::vector<SphereInstance> spheres = benchmarkSpheres(counts[c]);
+		std::cout << counts[c] << " Spheres:";
+		for (int r = 0; r < 2; r++) {
+			const Mesh& sphere = getSphereMesh(benchmarkResolutions[r]);
+			double milliseconds = timeFrames(window, meshShader, raycastShader, &sphere, spheres);
+			std::cout << " tessellated(" << benchmarkResolutions[r] << ") " << milliseconds << " ms,";
+		}
+		double milliseconds = timeFrames(window, meshShader, raycastShader, NULL, spheres);
+		std::cout << " raycast " << milliseconds << " ms" << std::endl;
+	}
+}
+
+/*
+* The time per body divided by log2(N) should stay about constant if the tree scales as O(N log N).
+* The exact sum is only timed while it is affordable, the error is always measured on a sample of 1000 bodies.
+*
+*/
+void benchmarkGravity() {
+
+	const size_t counts[] = { 1000, 10000, 100000, 1000000 };
+	const size_t exactLimit = 20000;
+	const size_t sampleSize = 1000;
+	GravitySimulation simulation;
+
+	std::cout << "BENCHMARK::GRAVITY theta " << simulation.openingAngle << ", leaf size " << simulation.leafSize << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	for (int c = 0; c < 4; c++) {
+		size_t count = counts[c];
+		std::vector<Planet> bodies = benchmarkBodies(count);
+		std::vector<glm::dvec3> accelerations;
+
+		double start = benchmarkClock();
+		computeGravityBarnesHut(bodies.data(), count, simulation, accelerations);
+		double treeSeconds = benchmarkClock() - start;
+
+		std::cout << count << " bodies: Barnes-Hut " << treeSeconds * 1000.0 << " ms ("
+			<< treeSeconds * 1e9 / (count * log2((double)count)) << " ns per N log N)";
+
+		if (count <= exactLimit) {
+			std::vector<glm::dvec3> exact;
+			start = benchmarkClock();
+			computeGravityExact(bodies.data(), count, simulation, exact);
+			std::cout << ", exact " << (benchmarkClock() - start) * 1000.0 << " ms";
+		}
+
+		double errorSum = 0.0;
+		double maximumError = 0.0;
+		size_t stride = std::max<size_t>(1, count / sampleSize);
+		size_t samples = 0;
+		for (size_t i = 0; i < count; i += stride) {
+			glm::dvec3 reference = exactGravity(bodies.data(), count, i, simulation);
+			double error = glm::length(accelerations[i] - reference) / std::max(glm::length(reference), 1e-12);
+			errorSum += error * error;
+			maximumError = std::max(maximumError, error);
+			samples++;
+		}
+		std::cout << ", relative error rms " << sqrt(errorSum / samples) << " max " << maximumError << std::endl;
+	}
+}
+
+/*
+* Every kernel is checked against the double precision exact sum, the float kernels should stay below 1e-3 relative error.
+* An interaction is one pair of bodies, the direct sum does N^2 of them per step.
+*
+*/
+void benchmarkDirectGravity() {
+
+	const size_t counts[] = { 1000, 5000, 20000 };
+	const double tolerance = 1e-3;
+	GravitySimulation simulation;
+	SimdISA best = detectSimdISA();
+
+	std::cout << "BENCHMARK::DIRECT_GRAVITY best instruction set " << simdISAName(best) << std::endl;
+	for (int c = 0; c < 3; c++) {
+		size_t count = counts[c];
+		std::vector<Planet> bodies = benchmarkBodies(count);
+		std::vector<glm::dvec3> exact;
+		computeGravityExact(bodies.data(), count, simulation, exact);
+
+		std::cout << count << " bodies:";
+		for (int isa = SIMD_SCALAR; isa <= best; isa++) {
+			std::vector<glm::dvec3> accelerations;
+			double start = benchmarkClock();
+			computeGravityDirect(bodies.data(), count, simulation, accelerations, (SimdISA)isa);
+			double seconds = benchmarkClock() - start;
+
+			double maximumError = 0.0;
+			for (size_t i = 0; i < count; i++)
+				maximumError = std::max(maximumError, glm::length(accelerations[i] - exact[i]) / std::max(glm::length(exact[i]), 1e-12));
+
+			std::cout << std::fixed << std::setprecision(3) << " " << simdISAName((SimdISA)isa) << " " << seconds * 1000.0 << " ms "
+				<< std::setprecision(2) << (double)count * count / seconds / 1e9 << " G interactions/s"
+				<< std::scientific << std::setprecision(1) << " error " << maximumError
+				<< (maximumError < tolerance ? "" : " FAILED") << ",";
+		}
+
+		double start = benchmarkClock();
+		std::vector<glm::dvec3> tree;
+		computeGravityBarnesHut(bodies.data(), count, simulation, tree);
+		std::cout << std::fixed << std::setprecision(3) << " Barnes-Hut " << (benchmarkClock() - start) * 1000.0 << " ms" << std::endl;
+	}
+}
+
+/*
+* The radii shrink with the count so every body touches about the same amount of others at every scale,
+* they vary by a factor of 4 so the cell size (the biggest diameter) is bigger than most bodies.
+* The pairs of the smallest count are compared with a brute force check of every pair.
+*
+*/
+void benchmarkCollisions() {
+
+	const size_t counts[] = { 10000, 100000, 1000000 };
+	const size_t bruteForceLimit = 10000;
+	SpatialHash hash;
+
+	std::cout << "BENCHMARK::COLLISIONS" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	for (int c = 0; c < 3; c++) {
+		size_t count = counts[c];
+		std::vector<Planet> bodies = benchmarkBodies(count);
+		std::mt19937 generator(5678);
+		std::uniform_real_distribution<double> size(0.25, 1.0);
+		double spacing = 50.0 / cbrt((double)count);
+		for (size_t i = 0; i < count; i++)
+			bodies[i].radius = spacing * 0.5 * size(generator);
+
+		std::vector<CollisionPair> candidates;
+		std::vector<CollisionPair> overlaps;
+		double start = benchmarkClock();
+		buildSpatialHash(hash, bodies.data(), count);
+		double buildSeconds = benchmarkClock() - start;
+		start = benchmarkClock();
+		findCandidatePairs(hash, count, candidates);
+		double broadSeconds = benchmarkClock() - start;
+		start = benchmarkClock();
+		findOverlaps(bodies.data(), candidates, overlaps);
+		double narrowSeconds = benchmarkClock() - start;
+
+		std::cout << count << " bodies: build " << buildSeconds * 1000.0 << " ms, broad phase " << broadSeconds * 1000.0 << " ms, "
+			<< "narrow phase " << narrowSeconds * 1000.0 << " ms, " << candidates.size() << " candidates, " << overlaps.size() << " overlaps, "
+			<< std::setprecision(2) << candidates.size() / (broadSeconds + narrowSeconds) / 1e6 << " M pairs/s, "
+			<< (double)spatialHashBytes(hash) / count << " bytes per body" << std::setprecision(3);
+
+		if (count <= bruteForceLimit) {
+			size_t bruteForce = 0;
+			for (size_t i = 0; i < count; i++) {
+				for (size_t j = i + 1; j < count; j++) {
+					glm::dvec3 d(bodies[i].xpos - bodies[j].xpos, bodies[i].ypos - bodies[j].ypos, bodies[i].zpos - bodies[j].zpos);
+					double radii = bodies[i].radius + bodies[j].radius;
+					if (glm::dot(d, d) < radii * radii)
+						bruteForce++;
+				}
+			}
+			std::cout << ", brute force " << bruteForce << (bruteForce == overlaps.size() ? " overlaps (match)" : " overlaps (MISMATCH)");
+		}
+		std::cout << std::endl;
+	}
+}
+
+/*
+* Moves the bodies for one step of the sweep and prune benchmark, either a slow random drift
+* or an orbit around the Y axis that is faster close to the center like the planets of a galaxy.
+*
+*/
+static void moveBenchmarkBodies(std::vector<Planet>& bodies, const std::vector<glm::dvec3>& drift, bool orbit) {
+
+	for (size_t i = 0; i < bodies.size(); i++) {
+		Planet& body = bodies[i];
+		if (orbit) {
+			double distance = std::max(sqrt(body.xpos * body.xpos + body.zpos * body.zpos), 1.0);
+			double angle = 0.002 * pow(distance / 50.0, -1.5);
+			double x = body.xpos * cos(angle) - body.zpos * sin(angle);
+			body.zpos = body.xpos * sin(angle) + body.zpos * cos(angle);
+			body.xpos = x;
+		}
+		else
+		{
+			body.xpos += drift[i].x;
+			body.ypos += drift[i].y;
+			body.zpos += drift[i].z;
+		}
+	}
+}
+
+/*
+* Every variant starts from the same bodies and does the same moves, the first update builds the order and isn't timed.
+* The overlaps of the last step are compared with the spatial hash.
+*
+*/
+void benchmarkSweepAndPrune() {
+
+	const size_t counts[] = { 10000, 100000 };
+	const int steps = 20;
+	const char* variantNames[] = { "full sort", "insertion sort", "multi axis" };
+
+	std::cout << "BENCHMARK::SWEEP_AND_PRUNE " << steps << " steps" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	for (int c = 0; c < 2; c++) {
+		size_t count = counts[c];
+		std::vector<Planet> start = benchmarkBodies(count);
+		std::mt19937 generator(91011);
+		std::uniform_real_distribution<double> logSize(log(0.05), log(2.0));
+		std::uniform_real_distribution<double> direction(-1.0, 1.0);
+		double spacing = 50.0 / cbrt((double)count);
+		std::vector<glm::dvec3> drift(count);
+		for (size_t i = 0; i < count; i++) {
+			start[i].radius = spacing * 0.5 * exp(logSize(generator));
+			drift[i] = glm::dvec3(direction(generator), direction(generator), direction(generator)) * spacing * 0.02;
+		}
+
+		for (int motion = 0; motion < 2; motion++) {
+			std::cout << count << " bodies, " << (motion == 1 ? "orbit" : "drift") << ":";
+			for (int variant = 0; variant < 3; variant++) {
+				std::vector<Planet> bodies = start;
+				SweepAndPrune sweep;
+				sweep.coherent = variant > 0;
+				sweep.multiAxis = variant == 2;
+				std::vector<CollisionPair> candidates;
+				std::vector<CollisionPair> overlaps;
+				updateSweepAndPrune(sweep, bodies.data(), count);
+
+				double updateSeconds = 0.0;
+				double sweepSeconds = 0.0;
+				size_t swaps = 0;
+				for (int step = 0; step < steps; step++) {
+					moveBenchmarkBodies(bodies, drift, motion == 1);
+					double time = benchmarkClock();
+					updateSweepAndPrune(sweep, bodies.data(), count);
+					updateSeconds += benchmarkClock() - time;
+					time = benchmarkClock();
+					findSweepPairs(sweep, candidates);
+					sweepSeconds += benchmarkClock() - time;
+					swaps += sweep.swaps;
+				}
+				findOverlaps(bodies.data(), candidates, overlaps);
+
+				std::cout << " " << variantNames[variant] << " update " << updateSeconds * 1000.0 / steps << " ms sweep "
+					<< sweepSeconds * 1000.0 / steps << " ms";
+				if (sweep.coherent)
+					std::cout << " " << swaps / steps << " swaps";
+				if (variant == 2) {
+					SpatialHash hash;
+					std::vector<CollisionPair> hashCandidates;
+					std::vector<CollisionPair> hashOverlaps;
+					buildSpatialHash(hash, bodies.data(), count);
+					findCandidatePairs(hash, count, hashCandidates);
+					findOverlaps(bodies.data(), hashCandidates, hashOverlaps);
+					std::cout << ", " << overlaps.size() << " overlaps" << (overlaps.size() == hashOverlaps.size() ? " (match)" : " (MISMATCH)");
+				}
+				else
+				{
+					std::cout << ",";
+				}
+			}
+			std::cout << std::endl;
+		}
+	}
+}
+
+/*
+* The time is different for every evaluation so no orbit is solved from the answer of the last one.
+* The error is the distance to the double precision solution divided by the semi-major axis.
+*
+*/
+void benchmarkOrbits() {
+
+	const size_t count = 1000000;
+	const int evaluations = 10;
+	const size_t sampleSize = 1000;
+	SimdISA best = detectSimdISA();
+
+	std::vector<Planet> bodies(count);
+	std::mt19937 generator(4321);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	for (size_t i = 0; i < count; i++) {
+		OrbitalElements& orbit = bodies[i].orbit;
+		orbit.semiMajorAxis = 1.0 + 49.0 * unit(generator);
+		orbit.eccentricity = 0.9 * unit(generator);
+		orbit.period = pow(orbit.semiMajorAxis, 1.5);
+		orbit.phase = 6.283185307179586 * unit(generator);
+		orbit.periapsisAngle = 6.283185307179586 * unit(generator);
+		bodies[i].hasOrbit = true;
+	}
+	KeplerOrbits orbits;
+	setKeplerOrbits(orbits, bodies.data(), count);
+
+	std::cout << "BENCHMARK::ORBITS " << count << " orbits, " << std::thread::hardware_concurrency() << " threads" << std::endl;
+	std::cout << std::fixed;
+	for (int isa = SIMD_SCALAR; isa <= best; isa++) {
+		if (isa == SIMD_SSE)
+			continue;
+		double seconds = 0.0;
+		double time = 0.0;
+		for (int evaluation = 0; evaluation < evaluations; evaluation++) {
+			time = 1000.0 + evaluation * 0.37;
+			double start = benchmarkClock();
+			evaluateKeplerOrbits(orbits, time, (SimdISA)isa);
+			seconds += benchmarkClock() - start;
+		}
+
+		double maximumError = 0.0;
+		for (size_t k = 0; k < count; k += count / sampleSize) {
+			glm::dvec2 reference = keplerPosition(bodies[k].orbit, time);
+			double error = glm::length(glm::dvec2(orbits.x[k], orbits.z[k]) - reference) / bodies[k].orbit.semiMajorAxis;
+			maximumError = std::max(maximumError, error);
+		}
+		std::cout << simdISAName((SimdISA)isa) << ": " << std::setprecision(3) << seconds * 1000.0 / evaluations << " ms per update, "
+			<< std::setprecision(1) << count * evaluations / seconds / 1e6 << " M orbits/s, error "
+			<< std::scientific << maximumError << std::fixed << std::endl;
+	}
+}
+
+/*
+* Builds 100 stars with 100 planets each and 99 moons per planet, about 1M nodes. The nodes are added in a shuffled order
+* so the unsorted arrays show how much the breadth first order helps. A copy of the scene is
+* kept in the order the nodes were added, it is still valid because parents are always added first.
+*
+*/
+void benchmarkSceneGraph() {
+
+	const int stars = 100;
+	const int planetsPerStar = 100;
+	const int moonsPerPlanet = 99;
+	const int updates = 10;
+
+	std::mt19937 generator(2468);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	SceneGraph scene;
+	std::vector<int> starNodes, planetNodes;
+	for (int s = 0; s < stars; s++)
+		starNodes.push_back(addSceneNode(scene, -1, glm::translate(glm::mat4(), glm::vec3(unit(generator), 0.0f, unit(generator)) * 1000.0f)));
+	for (int p = 0; p < stars * planetsPerStar; p++) {
+		glm::mat4 local = glm::rotate(glm::translate(glm::mat4(), glm::vec3(unit(generator), 0.0f, unit(generator)) * 50.0f), unit(generator), glm::vec3(0.0f, 1.0f, 0.0f));
+		planetNodes.push_back(addSceneNode(scene, starNodes[generator() % stars], local));
+	}
+	for (int m = 0; m < stars * planetsPerStar * moonsPerPlanet; m++)
+		addSceneNode(scene, planetNodes[generator() % planetNodes.size()], glm::translate(glm::mat4(), glm::vec3(unit(generator), unit(generator), unit(generator)) * 3.0f));
+
+	SceneGraph unsorted = scene;
+	unsorted.sorted = true;
+	updateWorldTransforms(unsorted);
+	double start = benchmarkClock();
+	sortSceneGraph(scene);
+	double sortSeconds = benchmarkClock() - start;
+	updateWorldTransforms(scene);
+
+	double maximumError = 0.0;
+	for (size_t node = 0; node < scene.nodes.size(); node += 997) {
+		const glm::mat4& a = worldTransform(scene, (int)node);
+		const glm::mat4& b = worldTransform(unsorted, (int)node);
+		for (int c = 0; c < 4; c++)
+			maximumError = std::max(maximumError, (double)glm::length(a[c] - b[c]));
+	}
+	std::cout << "BENCHMARK::SCENE_GRAPH " << scene.nodes.size() << " nodes, breadth first sort " << std::fixed << std::setprecision(3)
+		<< sortSeconds * 1000.0 << " ms, difference between the orders " << std::scientific << std::setprecision(1) << maximumError << std::fixed << std::setprecision(3) << std::endl;
+
+	const char* names[] = { "insertion order, glm", "breadth first, glm", "breadth first, SSE2", "breadth first, SSE2, 1% of planets moving" };
+	for (int variant = 0; variant < 4; variant++) {
+		SceneGraph& graph = variant == 0 ? unsorted : scene;
+		graph.useSimd = variant >= 2;
+		double seconds = 0.0;
+		size_t updated = 0;
+		for (int update = 0; update < updates; update++) {
+			if (variant == 3) {
+				for (int p = 0; p < (int)planetNodes.size(); p += 100)
+					setLocalTransform(graph, planetNodes[p], glm::rotate(graph.locals[graph.slots[planetNodes[p]]], 0.01f, glm::vec3(0.0f, 1.0f, 0.0f)));
+			}
+			else
+			{
+				std::fill(graph.dirty.begin(), graph.dirty.end(), 1);
+			}
+			start = benchmarkClock();
+			updateWorldTransforms(graph);
+			seconds += benchmarkClock() - start;
+			updated += graph.updatedCount;
+		}
+		std::cout << names[variant] << ": " << seconds * 1000.0 / updates << " ms per update, " << updated / updates << " matrices, "
+			<< std::setprecision(1) << updated / seconds / 1e6 << " M matrices/s" << std::setprecision(3) << std::endl;
+	}
+}
+
+/*
+* The colours of 10M Planets are generated with 1 to 8 threads, a hash of all the colours has to be the same for every amount
+*
+*/
+void benchmarkGeneration() {
+
+	const size_t count = 10000000;
+	const unsigned threadCounts[] = { 1, 2, 4, 8 };
+	const uint64_t seed = 42;
+	std::vector<Planet> bodies(count);
+
+	std::cout << "BENCHMARK::GENERATION " << count << " Planets" << std::endl;
+	uint64_t reference = 0;
+	for (int t = 0; t < 4; t++) {
+		double start = benchmarkClock();
+		generatePlanetColors(bodies.data(), count, seed, threadCounts[t]);
+		double seconds = benchmarkClock() - start;
+
+		uint64_t hash = 1469598103934665603ull;
+		for (size_t i = 0; i < count; i++) {
+			const float channels[3] = { bodies[i].red, bodies[i].green, bodies[i].blue };
+			const unsigned char* bytes = (const unsigned char*)channels;
+			for (size_t b = 0; b < sizeof(channels); b++)
+				hash = (hash ^ bytes[b]) * 1099511628211ull;
+		}
+		if (t == 0)
+			reference = hash;
+		std::cout << threadCounts[t] << " threads: " << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms, "
+			<< std::setprecision(1) << count / seconds / 1e6 << " M Planets/s, hash " << std::hex << hash << std::dec
+			<< (hash == reference ? " (identical)" : " (DIFFERENT)") << std::endl;
+	}
+}
+
+/*
+* The positions of 10M Planets are generated for every layout with 1 and 4 threads. The hash of the positions has to be the same
+* for both, and the Planet furthest from the centre shows the layout kept to its radius
+*
+*/
+void benchmarkLayouts() {
+
+	const size_t count = 10000000;
+	const unsigned threadCounts[] = { 1, 4 };
+	const LayoutType types[] = { LAYOUT_SPIRAL, LAYOUT_LOG_SPIRAL, LAYOUT_CLUSTERS, LAYOUT_SHELLS, LAYOUT_LATTICE };
+	std::vector<Planet> bodies(count);
+
+	std::cout << "BENCHMARK::LAYOUTS " << count << " Planets" << std::endl;
+	for (int l = 0; l < 5; l++) {
+		uint64_t reference = 0;
+		for (int t = 0; t < 2; t++) {
+			LayoutSettings layout;
+			layout.type = types[l];
+			layout.seed = 42;
+			layout.threadCount = threadCounts[t];
+			double start = benchmarkClock();
+			generateLayout(bodies.data(), count, layout);
+			double seconds = benchmarkClock() - start;
+
+			uint64_t hash = 1469598103934665603ull;
+			double maxDistance = 0.0;
+			for (size_t i = 0; i < count; i++) {
+				const double position[3] = { bodies[i].xpos, bodies[i].ypos, bodies[i].zpos };
+				const unsigned char* bytes = (const unsigned char*)position;
+				for (size_t b = 0; b < sizeof(position); b++)
+					hash = (hash ^ bytes[b]) * 1099511628211ull;
+				maxDistance = std::max(maxDistance, sqrt(position[0] * position[0] + position[1] * position[1] + position[2] * position[2]));
+			}
+			if (t == 0)
+				reference = hash;
+			std::cout << layoutName(types[l]) << ", " << threadCounts[t] << " threads: " << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms, "
+				<< std::setprecision(1) << count / seconds / 1e6 << " M Planets/s, furthest " << maxDistance
+				<< (hash == reference ? " (identical)" : " (DIFFERENT)") << std::endl;
+		}
+	}
+}
+
+/*
+* Overlapping pairs found with the spatial hash, the Poisson disk layouts must have none
+*
+*/
+static size_t benchmarkOverlaps(const std::vector<Planet>& bodies) {
+
+	SpatialHash hash;
+	std::vector<CollisionPair> candidates, overlaps;
+	buildSpatialHash(hash, bodies.data(), bodies.size());
+	findCandidatePairs(hash, bodies.size(), candidates);
+	findOverlaps(bodies.data(), candidates, overlaps);
+	return overlaps.size();
+}
+
+void benchmarkPoisson() {
+
+	const size_t counts[] = { 100000, 1000000 };
+	std::cout << "BENCHMARK::POISSON" << std::endl;
+	for (int dimensions = 2; dimensions <= 3; dimensions++) {
+		for (int c = 0; c < 2; c++) {
+			for (int variant = 0; variant < 3; variant++) {
+				// variant 0 is one Planet at a time with mixed radii, 1 the same with radius 1, 2 the tiles
+				size_t count = counts[c];
+				if (variant < 2 && count > 100000 && dimensions == 3)
+					continue;
+				std::vector<Planet> bodies(count);
+				for (size_t i = 0; i < count; i++)
+					bodies[i].radius = variant == 0 ? 0.5 + 1.5 * randomDouble(7, i, 0) : 1.0;
+				PoissonSettings settings;
+				settings.dimensions = dimensions;
+				settings.seed = 42;
+				settings.tiled = variant == 2;
+
+				double start = benchmarkClock();
+				if (settings.tiled)
+					poissonDiskLayoutTiled(bodies.data(), count, settings);
+				else
+					poissonDiskLayout(bodies.data(), count, settings);
+				double seconds = benchmarkClock() - start;
+
+				double maxDistance = 0.0;
+				for (size_t i = 0; i < count; i++)
+					maxDistance = std::max(maxDistance, sqrt(bodies[i].xpos * bodies[i].xpos + bodies[i].ypos * bodies[i].ypos + bodies[i].zpos * bodies[i].zpos));
+				const char* names[] = { "mixed radii", "radius 1", "tiled" };
+				std::cout << dimensions << "D " << names[variant] << ", " << count << " Planets: " << std::fixed << std::setprecision(3)
+					<< seconds * 1000.0 << " ms, " << std::setprecision(2) << count / seconds / 1e6 << " M Planets/s, furthest "
+					<< std::setprecision(1) << maxDistance << ", overlaps " << benchmarkOverlaps(bodies) << std::endl;
+			}
+		}
+	}
+}
+
+void benchmarkCameraPath() {
+
+	const int keyframeCount = 64;
+	const size_t lookups = 10000000;
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> interval(1.0f, 3.0f);
+	CameraPath path;
+	float time = 0.0f;
+	for (int k = 0; k < keyframeCount; k++) {
+		glm::vec3 position(coordinate(generator), coordinate(generator) * 0.5f + 30.0f, coordinate(generator));
+		glm::vec3 target(coordinate(generator), 0.0f, coordinate(generator));
+		addCameraKeyframe(path, time, position, target - position, glm::vec3(0.0f, 1.0f, 0.0f));
+		time += interval(generator);
+	}
+
+	double start = benchmarkClock();
+	bakeCameraPath(path);
+	double bakeSeconds = benchmarkClock() - start;
+	float duration = cameraPathDuration(path);
+	std::cout << "BENCHMARK::CAMERA_PATH " << keyframeCount << " keyframes, " << duration << " s, " << path.positions.size()
+		<< " table entries baked in " << std::fixed << std::setprecision(3) << bakeSeconds * 1000.0 << " ms" << std::endl;
+
+	// The lookups walk the path at an odd step so they fall between the entries of the table
+	glm::vec3 position;
+	glm::quat orientation;
+	float sink = 0.0f;
+	start = benchmarkClock();
+	for (size_t i = 0; i < lookups; i++) {
+		evaluateCameraPath(path, fmod(i * 0.0137f, duration), position, orientation);
+		sink += position.x + orientation.w;
+	}
+	double evaluateSeconds = benchmarkClock() - start;
+	start = benchmarkClock();
+	for (size_t i = 0; i < lookups; i++) {
+		sampleCameraPath(path, fmod(i * 0.0137f, duration), position, orientation);
+		sink += position.x + orientation.w;
+	}
+	double sampleSeconds = benchmarkClock() - start;
+	std::cout << "splines: " << evaluateSeconds * 1e9 / lookups << " ns per lookup, table: " << sampleSeconds * 1e9 / lookups
+		<< " ns per lookup (" << sink * 0.0f << ")" << std::endl;
+
+	// Between the entries the table is only a blend, on the entries it is exactly the splines
+	float maxError = 0.0f, maxAngle = 0.0f, entryError = 0.0f;
+	for (size_t i = 0; i + 1 < path.positions.size(); i++) {
+		glm::vec3 exactPosition, tablePosition;
+		glm::quat exactOrientation, tableOrientation;
+		float t = (i + 0.5f) / path.sampleRate;
+		evaluateCameraPath(path, t, exactPosition, exactOrientation);
+		sampleCameraPath(path, t, tablePosition, tableOrientation);
+		maxError = std::max(maxError, glm::length(exactPosition - tablePosition));
+		maxAngle = std::max(maxAngle, 2.0f * std::acos(std::min(1.0f, std::abs(glm::dot(exactOrientation, tableOrientation)))));
+		sampleCameraPath(path, i / path.sampleRate, tablePosition, tableOrientation);
+		entryError = std::max(entryError, glm::length(path.positions[i] - tablePosition));
+	}
+	std::cout << "table error between entries: " << std::setprecision(5) << maxError << " units, " << glm::degrees(maxAngle)
+		<< " degrees, on the entries: " << entryError << " units" << std::endl;
+}
+
+/*
+* Builds the three programs of the scene and returns the milliseconds it took, the programs are deleted again
+*
+*/
+static double timeShaderStartup() {
+
+	const GLchar* programs[3][3] = { { "vert.glsl", NULL, "frag.glsl" },
+		{ "impostor_vert.glsl", NULL, "impostor_frag.glsl" },
+		{ "raycast_vert.glsl", "raycast_geom.glsl", "impostor_frag.glsl" } };
+	double start = glfwGetTime();
+	GLuint built[3];
+	for (int p = 0; p < 3; p++)
+		built[p] = initShader(programs[p][0], programs[p][1], programs[p][2]);
+	glFinish();
+	double milliseconds = (glfwGetTime() - start) * 1000.0;
+	for (int p = 0; p < 3; p++)
+		glDeleteProgram(built[p]);
+	return milliseconds;
+}
+
+void benchmarkShaderCache() {
+
+	std::cout << "BENCHMARK::SHADER_CACHE " << (const char*)glGetString(GL_RENDERER) << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	// The driver may keep its own cache, so the compile without our cache can already be faster than a real cold start
+	const char* names[] = { "compiled", "first run with the cache", "second run with the cache" };
+	for (int run = 0; run < 3; run++) {
+		shaderCache.enabled = run > 0;
+		unsigned hits = shaderCache.hits, misses = shaderCache.misses;
+		double milliseconds = timeShaderStartup();
+		std::cout << names[run] << ": " << milliseconds << " ms, " << shaderCache.hits - hits << " loaded, "
+			<< shaderCache.misses - misses << " compiled" << std::endl;
+	}
+
+	// Every variant of the mesh shaders, one after the other and all started at once.
+	// The last feature name differs between the two so the driver can't answer the second from its own cache.
+	shaderCache.enabled = false;
+	const char* modes[] = { "lazily", "precompiled" };
+	for (int mode = 0; mode < 2; mode++) {
+		std::vector<std::string> features = { "INSTANCED", "SPECULAR", mode == 0 ? "BENCHMARK_LAZY" : "BENCHMARK_PRECOMPILED" };
+		ShaderVariants variants;
+		initShaderVariants(variants, "vert.glsl", NULL, "frag.glsl", features);
+		std::vector<unsigned> keys;
+		for (unsigned lights = 1; lights <= 4; lights++) {
+			for (unsigned bits = 0; bits < 4; bits++)
+				keys.push_back(shaderVariantKey(bits, lights));
+		}
+		double start = glfwGetTime();
+		if (mode == 0) {
+			for (size_t k = 0; k < keys.size(); k++)
+				getShaderVariant(variants, keys[k]);
+		}
+		else
+		{
+			precompileShaderVariants(variants, keys);
+		}
+		glFinish();
+		std::cout << keys.size() << " variants " << modes[mode] << ": " << (glfwGetTime() - start) * 1000.0 << " ms" << std::endl;
+		deleteShaderVariants(variants);
+	}
+	shaderCache.enabled = true;
+}
+
+/*
+* Lights on the galaxy arms layout seen from the start position of the camera, with the projection main() draws with.
+* Every instruction set has to put the same lights in the same clusters as the scalar code.
+*
+*/
+void benchmarkClusters() {
+
+	const size_t counts[] = { 1000, 10000, 100000 };
+	const int builds = 20;
+	// The widest kernel is AVX2, a row of clusters is only 16 wide
+	SimdISA best = std::min(detectSimdISA(), SIMD_AVX2);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 40.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(45.0f, 1.0f, 0.1f, 100.0f);
+
+	std::cout << "BENCHMARK::CLUSTERS " << std::thread::hardware_concurrency() << " threads" << std::endl;
+	std::cout << std::fixed;
+	for (size_t c = 0; c < 3; c++) {
+		std::vector<Planet> bodies(counts[c]);
+		LayoutSettings layout;
+		layout.type = LAYOUT_LOG_SPIRAL;
+		layout.seed = 42;
+		generateLayout(bodies.data(), counts[c], layout);
+		std::vector<ClusterLight> lights(counts[c]);
+		for (size_t l = 0; l < counts[c]; l++) {
+			lights[l].position = glm::vec3((float)bodies[l].xpos, (float)bodies[l].ypos, (float)bodies[l].zpos);
+			lights[l].radius = 6.0f;
+			lights[l].color = glm::vec3(1.0f);
+		}
+
+		std::vector<unsigned> reference;
+		for (int isa = SIMD_SCALAR; isa <= best + 1; isa++) {
+			// The last run is the best instruction set with every core
+			bool threaded = isa > best;
+			ClusterGrid grid;
+			grid.threadCount = threaded ? 0 : 1;
+			setClusterProjection(grid, projection);
+			SimdISA used = threaded ? best : (SimdISA)isa;
+			double start = benchmarkClock();
+			for (int b = 0; b < builds; b++)
+				buildClusters(grid, lights, view, used);
+			double seconds = (benchmarkClock() - start) / builds;
+
+			if (isa == SIMD_SCALAR)
+				reference = grid.lightIndices;
+			size_t occupied = 0;
+			for (size_t k = 0; k < grid.ranges.size(); k++)
+				occupied += grid.ranges[k].y > 0 ? 1 : 0;
+			std::cout << counts[c] << " lights, " << simdISAName(used) << (threaded ? " every core" : " 1 thread") << ": "
+				<< std::setprecision(3) << seconds * 1000.0 << " ms, " << grid.references << " in " << occupied << " of " << grid.ranges.size()
+				<< " clusters, " << std::setprecision(1) << (occupied > 0 ? (double)grid.references / occupied : 0.0) << " per cluster, at most "
+				<< grid.maxCount << (grid.lightIndices == reference ? " (identical)" : " (DIFFERENT)") << std::endl;
+		}
+	}
+}
+
+/*
+* Same as timeFrames() for any drawing, the average milliseconds of a frame after the first one
+*
+*/
+template <typename Draw>
+static double timeDrawing(GLFWwindow* window, Draw draw) {
+
+	double start = 0;
+	for (int frame = 0; frame <= benchmarkFrames; frame++) {
+		if (frame == 1) {
+			glFinish();
+			start = glfwGetTime();
+		}
+		draw();
+		glfwSwapBuffers(window);
+	}
+	glFinish();
+	return (glfwGetTime() - start) * 1000.0 / benchmarkFrames;
+}
+
+/*
+* 10k Spheres of benchmarkSpheres() with 1 to 10k of them as lights, drawn with one instanced call in both paths.
+* Both get the same clusters, which are built once for every light count so only the drawing is timed.
+* The lights are a little above their Spheres so they light the Spheres around them.
+*
+*/
+void benchmarkDeferredShading(GLFWwindow* window, GLuint forwardShader, GLuint geometryShader, GLuint lightingShader) {
+
+	const int sphereCount = 10000;
+	const int lightCounts[] = { 1, 10, 100, 1000, 10000 };
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+
+	glm::vec3 cameraPos(0.0f, 40.0f, 20.0f);
+	glm::vec3 background(0.2f, 0.3f, 0.3f);
+	glm::mat4 model;
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(45.0f, (float)width / height, 0.1f, 100.0f);
+	GLuint geometryShaders[2] = { forwardShader, geometryShader };
+	for (int g = 0; g < 2; g++) {
+		setCameraUniforms(geometryShaders[g], model, view, projection);
+		glUniform3f(glGetUniformLocation(geometryShaders[g], "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+	}
+
+	std::vector<SphereInstance> spheres = benchmarkSpheres(sphereCount);
+	const Mesh& sphere = getSphereMesh(benchmarkResolutions[1]);
+	ClusterGrid grid;
+	// Enough room that no light is dropped, so both paths do all the work
+	grid.maxLightsPerCluster = 4096;
+	setClusterProjection(grid, projection);
+	Framebuffer gBuffer;
+	glfwSwapInterval(0);
+
+	std::cout << "BENCHMARK::DEFERRED " << (const char*)glGetString(GL_RENDERER) << ", " << sphereCount << " Spheres, "
+		<< width << "x" << height << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (int c = 0; c < 5; c++) {
+		std::vector<ClusterLight> lights(lightCounts[c]);
+		for (int l = 0; l < lightCounts[c]; l++) {
+			const SphereInstance& lit = spheres[l * (sphereCount / lightCounts[c])];
+			lights[l].position = glm::vec3(lit.centerRadius) + glm::vec3(0.0f, 2.0f * lit.centerRadius.w, 0.0f);
+			lights[l].radius = 3.0f;
+			lights[l].color = glm::vec3(0.3f);
+		}
+		double start = benchmarkClock();
+		buildClusters(grid, lights, view, detectSimdISA());
+		double clusterSeconds = benchmarkClock() - start;
+		uploadClusters(grid, lights);
+		bindClusters(grid, forwardShader, width, height);
+		bindClusters(grid, lightingShader, width, height);
+
+		double forward = timeDrawing(window, [&]() {
+			glClearColor(background.r, background.g, background.b, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glUseProgram(forwardShader);
+			drawMeshInstanced(sphere, spheres);
+		});
+		double deferred = timeDrawing(window, [&]() {
+			beginGBuffer(gBuffer, width, height, background);
+			glUseProgram(geometryShader);
+			drawMeshInstanced(sphere, spheres);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			drawDeferredLighting(gBuffer, lightingShader, view, projection, cameraPos);
+		});
+		std::cout << lightCounts[c] << " lights (" << grid.references << " in clusters, at most " << grid.maxCount << " in one): clusters "
+			<< clusterSeconds * 1000.0 << " ms, forward " << forward << " ms, deferred " << deferred << " ms" << std::endl;
+	}
+	deleteFramebuffer(gBuffer);
+	deleteClusters(grid);
+	deleteFullscreenTriangle();
+}
+
+/*
+* The 10k Spheres of benchmarkSpheres() drawn at the resolution of the main pass, while the shadow pass uses
+* the coarser mesh the program uses for it. The cost of the shadows is the shadow pass and the lookups in the main pass.
+*
+*/
+void benchmarkShadows(GLFWwindow* window, GLuint shadowShader, GLuint sceneShader, GLuint shadowedShader) {
+
+	const int sphereCount = 10000;
+	const double shadowResolution = 16;
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+
+	glm::vec3 cameraPos(0.0f, 40.0f, 20.0f);
+	glm::vec3 background(0.2f, 0.3f, 0.3f);
+	glm::mat4 model;
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(45.0f, (float)width / height, 0.1f, 100.0f);
+	GLuint sceneShaders[2] = { sceneShader, shadowedShader };
+	for (int s = 0; s < 2; s++) {
+		setCameraUniforms(sceneShaders[s], model, view, projection);
+		glUniform3f(glGetUniformLocation(sceneShaders[s], "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+	}
+
+	std::vector<SphereInstance> spheres = benchmarkSpheres(sphereCount);
+	const Mesh& sphere = getSphereMesh(benchmarkResolutions[1]);
+	const Mesh& shadowSphere = getSphereMesh(shadowResolution);
+	ShadowCascades shadows;
+	glfwSwapInterval(0);
+
+	std::cout << "BENCHMARK::SHADOWS " << (const char*)glGetString(GL_RENDERER) << ", " << sphereCount << " Spheres, "
+		<< width << "x" << height << ", " << shadows.resolution << "x" << shadows.resolution << " shadow maps" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	double plain = timeDrawing(window, [&]() {
+		glClearColor(background.r, background.g, background.b, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glUseProgram(sceneShader);
+		drawMeshInstanced(sphere, spheres);
+	});
+	std::cout << "No shadows: " << plain << " ms" << std::endl;
+	for (int c = 1; c <= maxShadowCascades; c++) {
+		shadows.cascades = c;
+		updateShadowCascades(shadows, model, view, projection);
+		double pass = timeDrawing(window, [&]() {
+			drawShadowCasters(shadows, shadowShader, model, shadowSphere, spheres);
+		});
+		bindShadows(shadows, shadowedShader, glm::mat4());
+		double shadowed = timeDrawing(window, [&]() {
+			drawShadowCasters(shadows, shadowShader, model, shadowSphere, spheres);
+			glClearColor(background.r, background.g, background.b, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glUseProgram(shadowedShader);
+			drawMeshInstanced(sphere, spheres);
+		});
+		unsigned casters = 0;
+		for (int k = 0; k < c; k++)
+			casters += shadows.casters[k];
+		std::cout << c << " cascades (" << casters << " casters): shadow pass " << pass << " ms (" << std::setprecision(0)
+			<< pass / plain * 100.0 << "% of the main pass), " << std::setprecision(2) << "with shadows " << shadowed << " ms" << std::endl;
+	}
+	deleteShadowCascades(shadows);
+}
+
+/*
+* The 10k Spheres of benchmarkSpheres() drawn into the depth prepass, then the occlusion of every preset.
+* The GPU timer of the last frame is printed next to the frame time, the budget is not used so the preset stays the same.
+*
+*/
+void benchmarkAmbientOcclusion(GLFWwindow* window, GLuint depthShader, AmbientOcclusion& ao) {
+
+	const int sphereCount = 10000;
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+
+	glm::mat4 model;
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 40.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(45.0f, (float)width / height, 0.1f, 100.0f);
+	glm::mat4 viewProjection = projection * view;
+	glUseProgram(depthShader);
+	glUniformMatrix4fv(glGetUniformLocation(depthShader, "model"), 1, GL_FALSE, glm::value_ptr(model));
+	glUniformMatrix4fv(glGetUniformLocation(depthShader, "lightViewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+	std::vector<SphereInstance> spheres = benchmarkSpheres(sphereCount);
+	const Mesh& sphere = getSphereMesh(benchmarkResolutions[1]);
+	ao.adaptQuality = false;
+	glfwSwapInterval(0);
+
+	std::cout << "BENCHMARK::SSAO " << (const char*)glGetString(GL_RENDERER) << ", " << sphereCount << " Spheres, "
+		<< width << "x" << height << ", budget " << ao.budget << " ms" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (int q = AO_LOW; q <= AO_HIGH; q++) {
+		ao.quality = (AOQuality)q;
+		AOPreset preset = aoPreset(ao.quality);
+		double frame = timeDrawing(window, [&]() {
+			beginDepthPrepass(ao, width, height);
+			glUseProgram(depthShader);
+			drawMeshInstanced(sphere, spheres);
+			drawAmbientOcclusion(ao, projection);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		});
+		std::cout << aoQualityName(ao.quality) << " (1/" << preset.divisor << " resolution, " << preset.samples << " samples, blur radius "
+			<< preset.blurRadius << "): frame " << frame << " ms, GPU timer " << ao.cost << " ms"
+			<< (ao.cost > ao.budget ? " (over the budget)" : "") << std::endl;
+	}
+}
+
+/*
+* The frame is cleared to a colour above the threshold so every pixel blooms, the cost doesn't depend on what was drawn.
+* The pixels written by the chain are given as a fraction of the screen, the down and the up pass both write every level but the last
+*
+*/
+void benchmarkBloom(GLFWwindow* window, Bloom& bloom) {
+
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	Framebuffer scene;
+	createFramebuffer(scene, width, height, { GL_RGBA16F }, false);
+	bindFramebuffer(scene);
+	glClearColor(2.0f, 1.5f, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glfwSwapInterval(0);
+
+	std::cout << "BENCHMARK::BLOOM " << (const char*)glGetString(GL_RENDERER) << ", " << width << "x" << height << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	double tonemap = timeDrawing(window, [&]() {
+		drawTonemap(bloom, scene, false, width, height);
+	});
+	std::cout << "Tonemapping only: " << tonemap << " ms" << std::endl;
+	for (int levels = 1; levels <= 6; levels++) {
+		bloom.levels = levels;
+		double frame = timeDrawing(window, [&]() {
+			drawBloom(bloom, scene);
+			drawTonemap(bloom, scene, true, width, height);
+		});
+		double written = 0.0;
+		for (int l = 0; l < levels; l++)
+			written += (double)bloom.chain[l].width * bloom.chain[l].height * (l < levels - 1 ? 2 : 1);
+		std::cout << levels << " levels down to " << bloom.chain.back().width << "x" << bloom.chain.back().height << ": " << frame
+			<< " ms, the chain writes " << written / ((double)width * height) << " screens of pixels" << std::endl;
+	}
+	deleteBloom(bloom);
+	deleteFramebuffer(scene);
+}
+
+/*
+* The shells of the Spheres of benchmarkSpheres() over an empty frame, every mode draws them with one instanced call.
+* The sorted mode sorts a copy in the order of the array every frame, like the program sorts the Planets it finds visible
+*
+*/
+void benchmarkTranslucency(GLFWwindow* window, GLuint weightedShader, GLuint sortedShader, GLuint listShader, TranslucentShells& shells) {
+
+	const int counts[] = { 1000, 10000, 100000 };
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+
+	glm::vec3 cameraPos(0.0f, 40.0f, 20.0f);
+	glm::mat4 model;
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(45.0f, (float)width / height, 0.1f, 100.0f);
+	GLuint shaders[3] = { weightedShader, listShader, sortedShader };
+	for (int m = 0; m < 3; m++) {
+		if (shaders[m] == 0)
+			continue;
+		setCameraUniforms(shaders[m], model, view, projection);
+		glUniform3f(glGetUniformLocation(shaders[m], "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+		glUniform1f(glGetUniformLocation(shaders[m], "shellOpacity"), 0.35f);
+	}
+
+	const Mesh& sphere = getSphereMesh(benchmarkResolutions[0]);
+	Framebuffer scene;
+	createFramebuffer(scene, width, height, { GL_RGBA16F }, true);
+	glfwSwapInterval(0);
+
+	std::cout << "BENCHMARK::OIT " << (const char*)glGetString(GL_RENDERER) << ", " << width << "x" << height
+		<< (listShader == 0 ? ", no linked lists without OpenGL 4.3" : "") << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	for (int c = 0; c < 3; c++) {
+		std::vector<SphereInstance> spheres = benchmarkSpheres(counts[c]);
+		for (size_t i = 0; i < spheres.size(); i++)
+			spheres[i].centerRadius.w *= 1.4f;
+		std::vector<SphereInstance> sorted;
+		double sortSeconds = 0.0;
+		std::cout << counts[c] << " shells:";
+		for (int m = 0; m < 3; m++) {
+			if (shaders[m] == 0)
+				continue;
+			shells.mode = (OITMode)m;
+			double frame = timeDrawing(window, [&]() {
+				bindFramebuffer(scene);
+				glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				const std::vector<SphereInstance>* drawn = &spheres;
+				if (shells.mode == OIT_SORTED) {
+					double start = benchmarkClock();
+					sorted = spheres;
+					sortShellsBackToFront(sorted, cameraPos);
+					sortSeconds = benchmarkClock() - start;
+					drawn = &sorted;
+				}
+				beginTranslucency(shells, scene);
+				glUseProgram(shaders[m]);
+				glUniform1ui(glGetUniformLocation(shaders[m], "nodeCapacity"), shells.nodeCapacity);
+				drawMeshInstanced(sphere, *drawn);
+				endTranslucency(shells, scene);
+			});
+			std::cout << " " << oitModeName(shells.mode) << " " << frame << " ms";
+			if (shells.mode == OIT_SORTED)
+				std::cout << " (" << sortSeconds * 1000.0 << " ms sorting)";
+			std::cout << (m < 2 ? "," : "");
+		}
+		std::cout << std::endl;
+	}
+	deleteTranslucentShells(shells);
+	deleteFramebuffer(scene);
+}
+
+/*
+* Thin lines like the ones of drawGrid() under the Spheres, drawn with the plain mesh program. The lines are @lineWidth pixels
+* wide so the supersampled reference can draw them as wide as they are in the frame
+*
+*/
+static void drawAliasingScene(GLuint meshShader, const Mesh& sphere, const std::vector<SphereInstance>& spheres, float lineWidth) {
+
+	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glUseProgram(meshShader);
+	glUniform3f(glGetUniformLocation(meshShader, "objectColor"), 1.0f, 1.0f, 1.0f);
+	glUniform3f(glGetUniformLocation(meshShader, "lightColor"), 1.0f, 1.0f, 1.0f);
+	glUniform3f(glGetUniformLocation(meshShader, "lightPos"), 0.0f, 10.0f, 0.0f);
+	glUniform3f(glGetUniformLocation(meshShader, "center"), 0.0f, 0.0f, 0.0f);
+	glUniform1f(glGetUniformLocation(meshShader, "radius"), 1.0f);
+	glLineWidth(lineWidth);
+	glBegin(GL_LINES);
+	for (int i = -40; i <= 40; i++) {
+		glVertex3f(i * 0.5f, -0.1f, -20.0f);
+		glVertex3f(i * 0.5f, -0.1f, 20.0f);
+		glVertex3f(-20.0f, -0.1f, i * 0.5f);
+		glVertex3f(20.0f, -0.1f, i * 0.5f);
+	}
+	glEnd();
+	glLineWidth(1.0f);
+	drawTessellated(meshShader, sphere, spheres);
+}
+
+// The RGB of the first colour attachment of @framebuffer, from the bottom row up
+static std::vector<float> readColors(GLuint framebuffer, int width, int height) {
+
+	std::vector<float> colors((size_t)width * height * 3);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_FLOAT, colors.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	return colors;
+}
+
+static double rootMeanSquareError(const std::vector<float>& colors, const std::vector<float>& reference) {
+
+	double sum = 0.0;
+	for (size_t i = 0; i < colors.size(); i++)
+		sum += ((double)colors[i] - reference[i]) * ((double)colors[i] - reference[i]);
+	return sqrt(sum / colors.size());
+}
+
+/*
+* The Grid and 1k low resolution Spheres of benchmarkSpheres() without anti-aliasing, with the highest MSAA up to 8x resolved by a
+* blit and with TAA, the sample count is printed.
+* The error is against the same frame drawn 4 times bigger and averaged down, 16 samples in a grid for every pixel.
+* TAA is measured after 32 frames of a still camera, when the history holds all the jitter positions
+*
+*/
+void benchmarkTemporalAA(GLFWwindow* window, GLuint meshShader, TemporalAA& taa) {
+
+	const int sphereCount = 1000;
+	const int referenceScale = 4;
+	const int settleFrames = 32;
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+
+	glm::vec3 cameraPos(0.0f, 40.0f, 20.0f);
+	glm::mat4 model;
+	glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(45.0f, (float)width / height, 0.1f, 100.0f);
+	setCameraUniforms(meshShader, model, view, projection);
+	glUniform3f(glGetUniformLocation(meshShader, "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+
+	std::vector<SphereInstance> spheres = benchmarkSpheres(sphereCount);
+	const Mesh& sphere = getSphereMesh(benchmarkResolutions[0]);
+	Framebuffer scene;
+	createFramebuffer(scene, width, height, { GL_RGBA16F }, true);
+	glfwSwapInterval(0);
+
+	// Every pixel of the frame is the average of a square of pixels of the reference
+	Framebuffer reference;
+	createFramebuffer(reference, width * referenceScale, height * referenceScale, { GL_RGBA16F }, true);
+	bindFramebuffer(reference);
+	drawAliasingScene(meshShader, sphere, spheres, (float)referenceScale);
+	std::vector<float> big = readColors(reference.fbo, reference.width, reference.height);
+	std::vector<float> expected((size_t)width * height * 3, 0.0f);
+	for (int y = 0; y < reference.height; y++)
+		for (int x = 0; x < reference.width; x++)
+			for (int c = 0; c < 3; c++)
+				expected[((size_t)(y / referenceScale) * width + x / referenceScale) * 3 + c] +=
+					big[((size_t)y * reference.width + x) * 3 + c] / (referenceScale * referenceScale);
+	big.clear();
+	deleteFramebuffer(reference);
+
+	std::cout << "BENCHMARK::TAA " << (const char*)glGetString(GL_RENDERER) << ", " << sphereCount << " Spheres and the Grid, "
+		<< width << "x" << height << ", error against " << referenceScale * referenceScale << " samples per pixel" << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	double plain = timeDrawing(window, [&]() {
+		bindFramebuffer(scene);
+		drawAliasingScene(meshShader, sphere, spheres, 1.0f);
+	});
+	double plainError = rootMeanSquareError(readColors(scene.fbo, width, height), expected);
+
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	int samples = std::min(8, (int)maxSamples);
+	GLuint msaaBuffers[2];
+	GLuint msaaFBO;
+	glGenRenderbuffers(2, msaaBuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, msaaBuffers[0]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA16F, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, msaaBuffers[1]);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &msaaFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, msaaBuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, msaaBuffers[1]);
+	double msaa = timeDrawing(window, [&]() {
+		glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+		glViewport(0, 0, width, height);
+		drawAliasingScene(meshShader, sphere, spheres, 1.0f);
+		// The resolve of the samples into one colour per pixel
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, scene.fbo);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	});
+	double msaaError = rootMeanSquareError(readColors(scene.fbo, width, height), expected);
+	glDeleteFramebuffers(1, &msaaFBO);
+	glDeleteRenderbuffers(2, msaaBuffers);
+
+	const Framebuffer* resolved = NULL;
+	auto drawTemporal = [&]() {
+		glm::mat4 jittered = jitterProjection(taa, projection, width, height);
+		setCameraUniforms(meshShader, model, view, jittered);
+		bindFramebuffer(scene);
+		drawAliasingScene(meshShader, sphere, spheres, 1.0f);
+		resolved = &resolveTemporalAA(taa, scene, model, projection * view);
+	};
+	double temporal = timeDrawing(window, drawTemporal);
+	resetTemporalAA(taa);
+	for (int frame = 0; frame < settleFrames; frame++)
+		drawTemporal();
+	double temporalError = rootMeanSquareError(readColors(resolved->fbo, width, height), expected);
+
+	std::cout << "No anti-aliasing: " << plain << " ms, error " << std::setprecision(4) << plainError << std::setprecision(2) << std::endl;
+	std::cout << samples << "x MSAA: " << msaa << " ms, error " << std::setprecision(4) << msaaError << std::setprecision(2) << std::endl;
+	std::cout << "TAA (" << taa.sequenceLength << " jitter positions): " << temporal << " ms, error " << std::setprecision(4)
+		<< temporalError << std::setprecision(2) << std::endl;
+	deleteTemporalAA(taa);
+	deleteFramebuffer(scene);
+}
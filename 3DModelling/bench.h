@@ -0,0 +1,77 @@
+#ifndef bench_H
+#define bench_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "ssao.h"
+#include "bloom.h"
+#include "oit.h"
+#include "taa.h"
+
+/*
+* Benchmarks that can be started from the command line, they print their results and return.
+*
+*/
+
+// Frame time of the tessellated Spheres at a few resolutions against the ray casted Spheres for 10k, 100k and 1M Spheres
+void benchmarkSphereRendering(GLFWwindow* window, GLuint meshShader, GLuint raycastShader);
+
+// Time of the Barnes-Hut forces from 1k to 1M bodies and their error against the exact sum
+void benchmarkGravity();
+
+// Interactions per second of the direct sum for every instruction set the CPU has, checked against the exact sum
+void benchmarkDirectGravity();
+
+// Build time, candidate pairs per second and memory per body of the spatial hash from 10k to 1M bodies
+void benchmarkCollisions();
+
+// Sweep and prune with the insertion sort against sorting every step, for drifting and orbiting bodies
+void benchmarkSweepAndPrune();
+
+// Time to evaluate 1M Kepler orbits for every instruction set and their error against the double precision solution
+void benchmarkOrbits();
+
+// World matrix updates of a 1M node scene graph in insertion and breadth first order, with and without dirty flags
+void benchmarkSceneGraph();
+
+// Random colours of 10M Planets with 1 to 8 threads, checking that the result doesn't depend on the amount of threads
+void benchmarkGeneration();
+
+// Positions of 10M Planets for every layout with 1 and 4 threads, in Planets per second
+void benchmarkLayouts();
+
+// Poisson disk sampling in 2D and 3D, one Planet at a time against the tiles, checking that no Planets overlap
+void benchmarkPoisson();
+
+// Baking a 64 keyframe camera path, the cost of a lookup in the table against evaluating the splines and the error of the table
+void benchmarkCameraPath();
+
+// Startup time of the shader programs compiled, then loaded from the program binary cache, needs the window to be created
+void benchmarkShaderCache();
+
+// Time to give 1k to 100k Planet lights to the clusters of the view frustum for every instruction set, checked against the scalar code
+void benchmarkClusters();
+
+// Frame time of forward against deferred shading of 10k Spheres with 1 to 10k clustered lights, needs the window to be created
+void benchmarkDeferredShading(GLFWwindow* window, GLuint forwardShader, GLuint geometryShader, GLuint lightingShader);
+
+// Frame time of 10k instanced Spheres with and without the shadows of 1 to 4 cascades, and of the shadow pass alone, needs the window to be created
+void benchmarkShadows(GLFWwindow* window, GLuint shadowShader, GLuint sceneShader, GLuint shadowedShader);
+
+// GPU time of the depth prepass and the ambient occlusion of 10k Spheres for every quality preset, needs the window to be created
+void benchmarkAmbientOcclusion(GLFWwindow* window, GLuint depthShader, AmbientOcclusion& ao);
+
+// Time of the tonemapping of a full HDR frame alone and with a bloom chain of 1 to 6 levels, needs the window to be created
+void benchmarkBloom(GLFWwindow* window, Bloom& bloom);
+
+// Frame time of 1k to 100k translucent shells weighted blended, in linked lists (0 for @listShader without OpenGL 4.3)
+// and sorted back to front on the CPU every frame, needs the window to be created
+void benchmarkTranslucency(GLFWwindow* window, GLuint weightedShader, GLuint sortedShader, GLuint listShader, TranslucentShells& shells);
+
+// Frame time and error against a supersampled frame of the Grid and the Spheres without anti-aliasing, with the highest MSAA up to 8x
+// and with TAA, needs the window to be created
+void benchmarkTemporalAA(GLFWwindow* window, GLuint meshShader, TemporalAA& taa);
+
+#endif
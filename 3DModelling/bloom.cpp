@@ -0,0 +1,100 @@
+// The dual filter is from Bjorge "Bandwidth-Efficient Rendering" (SIGGRAPH 2015), the soft threshold is the one of Unity's bloom
+
+#include <algorithm>
+
+#include "bloom.h"
+
+/*Bloom variables
+*
+* @bloomTextureUnit is the first texture unit of the passes after the lighting, the units before it hold the lighting inputs
+*
+*/
+const int bloomTextureUnit = 10;
+
+/*
+* Draws a fullscreen pass of @program from @source into @target, the sizes of both are given to the shader
+*
+*/
+static void drawBloomPass(GLuint program, GLuint source, const Framebuffer& sourceSize, const Framebuffer& target) {
+
+	glBindTexture(GL_TEXTURE_2D, source);
+	glUniform2f(glGetUniformLocation(program, "sourceTexel"), 1.0f / sourceSize.width, 1.0f / sourceSize.height);
+	glUniform2f(glGetUniformLocation(program, "targetTexel"), 1.0f / target.width, 1.0f / target.height);
+	bindFramebuffer(target);
+	drawFullscreenTriangle();
+}
+
+void drawBloom(Bloom& bloom, const Framebuffer& scene) {
+
+	bloom.chain.resize(bloom.levels);
+	int width = scene.width;
+	int height = scene.height;
+	for (int l = 0; l < bloom.levels; l++) {
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		resizeFramebuffer(bloom.chain[l], width, height, { GL_R11F_G11F_B10F }, false);
+	}
+
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glActiveTexture(GL_TEXTURE0 + bloomTextureUnit);
+
+	// Down, the first pass keeps only the light above the threshold
+	glUseProgram(bloom.downProgram);
+	glUniform1i(glGetUniformLocation(bloom.downProgram, "source"), bloomTextureUnit);
+	float knee = std::max(bloom.knee, 1e-4f);
+	glUniform4f(glGetUniformLocation(bloom.downProgram, "threshold"), bloom.threshold, bloom.threshold - knee, 2.0f * knee, 0.25f / knee);
+	GLint prefilterLoc = glGetUniformLocation(bloom.downProgram, "prefilter");
+	for (int l = 0; l < bloom.levels; l++) {
+		glUniform1i(prefilterLoc, l == 0);
+		if (l == 0)
+			drawBloomPass(bloom.downProgram, scene.colors[0], scene, bloom.chain[0]);
+		else
+			drawBloomPass(bloom.downProgram, bloom.chain[l - 1].colors[0], bloom.chain[l - 1], bloom.chain[l]);
+	}
+
+	// Up, every level is added to the one above it
+	glUseProgram(bloom.upProgram);
+	glUniform1i(glGetUniformLocation(bloom.upProgram, "source"), bloomTextureUnit);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	for (int l = bloom.levels - 1; l > 0; l--)
+		drawBloomPass(bloom.upProgram, bloom.chain[l].colors[0], bloom.chain[l], bloom.chain[l - 1]);
+	glDisable(GL_BLEND);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void drawTonemap(const Bloom& bloom, const Framebuffer& scene, bool withBloom, int width, int height) {
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	glUseProgram(bloom.tonemapProgram);
+	glActiveTexture(GL_TEXTURE0 + bloomTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, scene.colors[0]);
+	glActiveTexture(GL_TEXTURE0 + bloomTextureUnit + 1);
+	glBindTexture(GL_TEXTURE_2D, withBloom && !bloom.chain.empty() ? bloom.chain[0].colors[0] : 0);
+	glUniform1i(glGetUniformLocation(bloom.tonemapProgram, "scene"), bloomTextureUnit);
+	glUniform1i(glGetUniformLocation(bloom.tonemapProgram, "bloom"), bloomTextureUnit + 1);
+	glUniform1f(glGetUniformLocation(bloom.tonemapProgram, "bloomStrength"), withBloom ? bloom.strength : 0.0f);
+	glUniform1f(glGetUniformLocation(bloom.tonemapProgram, "exposure"), bloom.exposure);
+	drawFullscreenTriangle();
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void deleteBloom(Bloom& bloom) {
+
+	for (size_t l = 0; l < bloom.chain.size(); l++)
+		deleteFramebuffer(bloom.chain[l]);
+	bloom.chain.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef bloom_H
+#define bloom_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "framebuffer.h"
+
+/* Bloom
+*
+* The HDR frame is tonemapped to the window with the light above @threshold spread around it. The bloom is a dual filter chain:
+* the frame is halved @levels times, the first level is already half the screen, with 5 bilinear taps every time,
+* then every level is upsampled with 8 taps and added to the one above it. Every pass reads a texture half or twice the size of
+* the one it writes and the levels are R11F_G11F_B10F, which is about a third of the bandwidth of a blur at the full resolution.
+* @threshold is the brightness where the bloom starts and @knee how softly it starts
+* @strength is how much of the bloom is added to the frame
+* @exposure scales the frame before the filmic curve, the curve maps any brightness into the range of the screen
+* @downProgram, @upProgram and @tonemapProgram are built from deferred_vert.glsl and bloom_down_frag.glsl, bloom_up_frag.glsl
+* and tonemap_frag.glsl
+* @chain are the levels of the bloom, from the biggest to the smallest
+*
+*/
+struct Bloom
+{
+	int levels = 5;
+	float threshold = 1.0f;
+	float knee = 0.5f;
+	float strength = 0.3f;
+	float exposure = 1.0f;
+
+	GLuint downProgram = 0;
+	GLuint upProgram = 0;
+	GLuint tonemapProgram = 0;
+	std::vector<Framebuffer> chain;
+};
+
+// Builds the bloom of the HDR frame into the first level of the chain
+void drawBloom(Bloom& bloom, const Framebuffer& scene);
+
+// Tonemaps the HDR frame and its bloom into the window, which is @width by @height, without the bloom when @withBloom is false
+void drawTonemap(const Bloom& bloom, const Framebuffer& scene, bool withBloom, int width, int height);
+
+void deleteBloom(Bloom& bloom);
+
+#endif
@@ -0,0 +1,33 @@
+#version 330 core
+layout (location = 0) out vec3 color;
+
+// One downsample of the dual filter bloom, see bloom.h
+uniform sampler2D source;
+uniform vec2 sourceTexel;
+uniform vec2 targetTexel;
+uniform bool prefilter;
+uniform vec4 threshold;     //threshold, threshold - knee, 2 * knee, 0.25 / knee
+
+// Keeps the light above the threshold, with a quadratic curve around it so the bloom doesn't start with a hard edge
+vec3 brightPart(vec3 c)
+{
+    float brightness = max(c.r, max(c.g, c.b));
+    float soft = clamp(brightness - threshold.y, 0.0f, threshold.z);
+    soft = soft * soft * threshold.w;
+    return c * max(soft, brightness - threshold.x) / max(brightness, 1e-4f);
+}
+
+void main()
+{
+    // The center of this pixel is the corner of 4 pixels of the source, the bilinear taps average 4 of them each
+    vec2 uv = gl_FragCoord.xy * targetTexel;
+    vec2 halfPixel = sourceTexel * 0.5f;
+    vec3 sum = texture(source, uv).rgb * 4.0f;
+    sum += texture(source, uv - halfPixel).rgb;
+    sum += texture(source, uv + halfPixel).rgb;
+    sum += texture(source, uv + vec2(halfPixel.x, -halfPixel.y)).rgb;
+    sum += texture(source, uv - vec2(halfPixel.x, -halfPixel.y)).rgb;
+    color = sum / 8.0f;
+    if (prefilter)
+        color = brightPart(color);
+}
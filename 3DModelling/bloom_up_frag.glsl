@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) out vec3 color;
+
+// One upsample of the dual filter bloom, it is added to the level it is drawn into (see bloom.h)
+uniform sampler2D source;
+uniform vec2 sourceTexel;
+uniform vec2 targetTexel;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy * targetTexel;
+    vec2 halfPixel = sourceTexel * 0.5f;
+    // A tent of 8 bilinear taps, the diagonal ones count twice
+    vec3 sum = texture(source, uv + vec2(-halfPixel.x * 2.0f, 0.0f)).rgb;
+    sum += texture(source, uv + vec2(-halfPixel.x, halfPixel.y)).rgb * 2.0f;
+    sum += texture(source, uv + vec2(0.0f, halfPixel.y * 2.0f)).rgb;
+    sum += texture(source, uv + vec2(halfPixel.x, halfPixel.y)).rgb * 2.0f;
+    sum += texture(source, uv + vec2(halfPixel.x * 2.0f, 0.0f)).rgb;
+    sum += texture(source, uv + vec2(halfPixel.x, -halfPixel.y)).rgb * 2.0f;
+    sum += texture(source, uv + vec2(0.0f, -halfPixel.y * 2.0f)).rgb;
+    sum += texture(source, uv + vec2(-halfPixel.x, -halfPixel.y)).rgb * 2.0f;
+    color = sum / 12.0f;
+}
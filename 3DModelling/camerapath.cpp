@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtx/spline.hpp>
+
+#include "camerapath.h"
+
+void addCameraKeyframe(CameraPath& path, float time, const glm::vec3& position, const glm::vec3& front, const glm::vec3& up) {
+
+	// The columns of the rotation are the right, up and back directions of the camera
+	glm::vec3 back = -glm::normalize(front);
+	glm::vec3 right = glm::normalize(glm::cross(up, back));
+	glm::vec3 trueUp = glm::cross(back, right);
+	CameraKeyframe keyframe;
+	keyframe.time = time;
+	keyframe.position = position;
+	keyframe.orientation = glm::quat_cast(glm::mat3(right, trueUp, back));
+
+	std::vector<CameraKeyframe>::iterator at = std::upper_bound(path.keyframes.begin(), path.keyframes.end(), time,
+		[](float t, const CameraKeyframe& k) { return t < k.time; });
+	path.keyframes.insert(at, keyframe);
+}
+
+float cameraPathDuration(const CameraPath& path) {
+
+	if (path.keyframes.empty())
+		return 0.0f;
+	float duration = path.keyframes.back().time - path.keyframes.front().time;
+	return path.loop ? duration + path.loopDuration : duration;
+}
+
+/*
+* Keyframe i of the path with its time, the indices past the ends wrap around when looping and repeat the end otherwise
+*
+*/
+static CameraKeyframe pathKeyframe(const CameraPath& path, int i) {
+
+	int count = (int)path.keyframes.size();
+	if (!path.loop)
+		return path.keyframes[std::min(std::max(i, 0), count - 1)];
+	float duration = cameraPathDuration(path);
+	int wraps = i >= 0 ? i / count : -((count - 1 - i) / count);
+	CameraKeyframe keyframe = path.keyframes[i - wraps * count];
+	keyframe.time += wraps * duration;
+	return keyframe;
+}
+
+/*
+* The tangents of Catmull-Rom are the differences between the neighbour keyframes, divided by their time apart
+* so the speed doesn't jump at a keyframe when the keyframes are not evenly spaced in time
+*
+*/
+static glm::vec3 catmullRomTangent(const CameraKeyframe& previous, const CameraKeyframe& next) {
+
+	float dt = next.time - previous.time;
+	return dt > 0.0f ? (next.position - previous.position) / dt : glm::vec3(0.0f);
+}
+
+void evaluateCameraPath(const CameraPath& path, float time, glm::vec3& position, glm::quat& orientation) {
+
+	if (path.keyframes.empty()) {
+		position = glm::vec3(0.0f);
+		orientation = glm::quat();
+		return;
+	}
+	int count = (int)path.keyframes.size();
+	float start = path.keyframes.front().time;
+	float duration = cameraPathDuration(path);
+	if (path.loop && duration > 0.0f)
+		time = start + fmod(fmod(time - start, duration) + duration, duration);
+	else
+		time = glm::clamp(time, start, start + duration);
+
+	int segment = (int)(std::upper_bound(path.keyframes.begin(), path.keyframes.end(), time,
+		[](float t, const CameraKeyframe& k) { return t < k.time; }) - path.keyframes.begin()) - 1;
+	segment = std::max(segment, 0);
+	if (!path.loop)
+		segment = std::min(segment, count - 2);
+	if (count == 1 || segment < 0) {
+		position = path.keyframes[0].position;
+		orientation = path.keyframes[0].orientation;
+		return;
+	}
+
+	CameraKeyframe k0 = pathKeyframe(path, segment - 1);
+	CameraKeyframe k1 = pathKeyframe(path, segment);
+	CameraKeyframe k2 = pathKeyframe(path, segment + 1);
+	CameraKeyframe k3 = pathKeyframe(path, segment + 2);
+	float length = k2.time - k1.time;
+	float s = length > 0.0f ? glm::clamp((time - k1.time) / length, 0.0f, 1.0f) : 0.0f;
+
+	// The Hermite form of the spline takes the tangents per segment, so they are scaled from per second to per segment
+	glm::vec3 t1 = catmullRomTangent(k0.time < k1.time ? k0 : k1, k2) * length;
+	glm::vec3 t2 = catmullRomTangent(k1, k3.time > k2.time ? k3 : k2) * length;
+	position = glm::hermite(k1.position, t1, k2.position, t2, s);
+	orientation = glm::slerp(k1.orientation, k2.orientation, s);
+}
+
+void bakeCameraPath(CameraPath& path) {
+
+	path.positions.clear();
+	path.orientations.clear();
+	if (path.keyframes.empty())
+		return;
+	size_t samples = (size_t)ceil(cameraPathDuration(path) * path.sampleRate) + 1;
+	path.positions.resize(samples);
+	path.orientations.resize(samples);
+	// Every entry is computed from its index instead of adding up a step, so the error doesn't grow along the path
+	for (size_t i = 0; i < samples; i++)
+		evaluateCameraPath(path, path.keyframes.front().time + i / path.sampleRate, path.positions[i], path.orientations[i]);
+}
+
+void sampleCameraPath(const CameraPath& path, float time, glm::vec3& position, glm::quat& orientation) {
+
+	if (path.positions.empty()) {
+		evaluateCameraPath(path, time, position, orientation);
+		return;
+	}
+	size_t last = path.positions.size() - 1;
+	float index = (time - path.keyframes.front().time) * path.sampleRate;
+	float period = cameraPathDuration(path) * path.sampleRate;
+	if (path.loop && period > 0.0f)
+		index = fmod(fmod(index, period) + period, period);
+	index = glm::clamp(index, 0.0f, (float)last);
+	size_t i = std::min((size_t)index, last);
+	size_t next = std::min(i + 1, last);
+	float blend = index - i;
+
+	position = glm::mix(path.positions[i], path.positions[next], blend);
+	// The entries are close together, so a normalized linear blend is as good as a slerp and much cheaper
+	glm::quat a = path.orientations[i];
+	glm::quat b = path.orientations[next];
+	if (glm::dot(a, b) < 0.0f)
+		b = -b;
+	orientation = glm::normalize(glm::quat(glm::mix(a.w, b.w, blend), glm::mix(a.x, b.x, blend), glm::mix(a.y, b.y, blend), glm::mix(a.z, b.z, blend)));
+}
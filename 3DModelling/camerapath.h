@@ -0,0 +1,56 @@
+#ifndef camerapath_H
+#define camerapath_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/* Camera Keyframe
+*
+* Where the camera is at @time seconds after the start of the path and where it looks, @orientation turns -Z into the front
+*
+*/
+struct CameraKeyframe
+{
+	float time;
+	glm::vec3 position;
+	glm::quat orientation;
+};
+
+/* Camera Path
+*
+* Fly-through made of keyframes, the position follows a Catmull-Rom spline through them and the orientation is slerped.
+* The path is baked into a table at a fixed rate, so playing it back only reads two entries per frame
+* and rendering at that same rate reads the exact entries every time.
+* @keyframes are sorted by time, addCameraKeyframe() keeps them sorted
+* @loop joins the end back to the start, the last keyframe then leads into the first one
+* @loopDuration is how long the way from the last keyframe back to the first one takes when looping
+* @sampleRate is how many entries of the table there are per second
+* @positions and @orientations are the table made by bakeCameraPath()
+*
+*/
+struct CameraPath
+{
+	std::vector<CameraKeyframe> keyframes;
+	bool loop = false;
+	float loopDuration = 2.0f;
+	float sampleRate = 60.0f;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::quat> orientations;
+};
+
+// Adds a keyframe for a camera at @position looking along @front with @up as its up direction
+void addCameraKeyframe(CameraPath& path, float time, const glm::vec3& position, const glm::vec3& front, const glm::vec3& up);
+float cameraPathDuration(const CameraPath& path);
+
+// Evaluates the splines at any time, this is what the table is made of
+void evaluateCameraPath(const CameraPath& path, float time, glm::vec3& position, glm::quat& orientation);
+
+// Fills the table with evaluateCameraPath() at every step of 1 / sampleRate
+void bakeCameraPath(CameraPath& path);
+
+// Reads the table, between two entries they are blended linearly
+void sampleCameraPath(const CameraPath& path, float time, glm::vec3& position, glm::quat& orientation);
+
+#endif
@@ -0,0 +1,295 @@
+// Clustered shading based on Olsson, Billeter and Assarsson "Clustered Deferred and Forward Shading"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cluster.h"
+#include "parallel.h"
+#include "cull.h"
+
+void setClusterProjection(ClusterGrid& grid, const glm::mat4& projection) {
+
+	grid.tilesX = std::max(1, std::min(grid.tilesX, 32));
+	grid.tilesY = std::max(1, grid.tilesY);
+	grid.slices = std::max(1, grid.slices);
+	size_t clusterCount = (size_t)grid.tilesX * grid.tilesY * grid.slices;
+	if (projection == grid.projection && grid.ranges.size() == clusterCount)
+		return;
+
+	grid.projection = projection;
+	// The planes come from the matrix so the clusters always match the projection that is drawn with
+	grid.nearPlane = projectionNearPlane(projection);
+	grid.farPlane = projectionFarPlane(projection);
+	// Half the width and height of the frustum at a depth of 1
+	float scaleX = 1.0f / projection[0][0];
+	float scaleY = 1.0f / projection[1][1];
+
+	// The rows are padded to the widest SIMD width with empty boxes that no light can touch
+	grid.rowStride = (grid.tilesX + 7) / 8 * 8;
+	size_t rows = (size_t)grid.tilesY * grid.slices;
+	grid.minX.assign(rows * grid.rowStride, 1e30f);
+	grid.minY.assign(rows * grid.rowStride, 1e30f);
+	grid.minZ.assign(rows * grid.rowStride, 1e30f);
+	grid.maxX.assign(rows * grid.rowStride, -1e30f);
+	grid.maxY.assign(rows * grid.rowStride, -1e30f);
+	grid.maxZ.assign(rows * grid.rowStride, -1e30f);
+
+	float depthRatio = grid.farPlane / grid.nearPlane;
+	for (int s = 0; s < grid.slices; s++) {
+		float nearDepth = grid.nearPlane * pow(depthRatio, (float)s / grid.slices);
+		float farDepth = grid.nearPlane * pow(depthRatio, (float)(s + 1) / grid.slices);
+		for (int y = 0; y < grid.tilesY; y++) {
+			float bottom = (-1.0f + 2.0f * y / grid.tilesY) * scaleY;
+			float top = (-1.0f + 2.0f * (y + 1) / grid.tilesY) * scaleY;
+			size_t base = ((size_t)s * grid.tilesY + y) * grid.rowStride;
+			for (int x = 0; x < grid.tilesX; x++) {
+				float left = (-1.0f + 2.0f * x / grid.tilesX) * scaleX;
+				float right = (-1.0f + 2.0f * (x + 1) / grid.tilesX) * scaleX;
+				// The sides of a cluster are slanted, so the box takes the widest of its near and far faces
+				grid.minX[base + x] = std::min(left * nearDepth, left * farDepth);
+				grid.maxX[base + x] = std::max(right * nearDepth, right * farDepth);
+				grid.minY[base + x] = std::min(bottom * nearDepth, bottom * farDepth);
+				grid.maxY[base + x] = std::max(top * nearDepth, top * farDepth);
+				grid.minZ[base + x] = -farDepth;
+				grid.maxZ[base + x] = -nearDepth;
+			}
+		}
+	}
+
+	grid.ranges.assign(clusterCount, glm::uvec2(0));
+	grid.lists.assign(clusterCount, std::vector<unsigned>());
+}
+
+/* Light Bounds
+*
+* @light is the view space position of the light and its radius squared
+* The light can only touch the clusters between the tiles [x0, x1] x [y0, y1] and the slices [s0, s1], s0 > s1 when it touches none
+*
+*/
+struct LightBounds
+{
+	glm::vec4 light;
+	int x0, x1, y0, y1, s0, s1;
+};
+
+static int clusterSlice(const ClusterGrid& grid, float depth) {
+
+	float sliceScale = grid.slices / log(grid.farPlane / grid.nearPlane);
+	int slice = (int)(log(depth / grid.nearPlane) * sliceScale);
+	return std::max(0, std::min(slice, grid.slices - 1));
+}
+
+static int clusterTile(float ndc, int tiles) {
+	return std::max(0, std::min((int)floor((ndc + 1.0f) * 0.5f * tiles), tiles - 1));
+}
+
+static LightBounds lightBounds(const ClusterGrid& grid, const ClusterLight& light, const glm::mat4& view) {
+
+	LightBounds bounds;
+	glm::vec4 p = view * glm::vec4(light.position, 1.0f);
+	float r = light.radius;
+	float depth = -p.z;
+	bounds.light = glm::vec4(p.x, p.y, p.z, r * r);
+	bounds.s0 = 1;
+	bounds.s1 = 0;
+	if (r <= 0.0f || depth - r > grid.farPlane || depth + r < grid.nearPlane)
+		return bounds;
+
+	bounds.x0 = bounds.y0 = 0;
+	bounds.x1 = grid.tilesX - 1;
+	bounds.y1 = grid.tilesY - 1;
+	if (depth - r > grid.nearPlane) {
+		// x / depth of a box is largest and smallest at its corners, so the box around the sphere gives a safe screen rectangle
+		float nearDepth = depth - r, farDepth = depth + r;
+		float left = std::min((p.x - r) / nearDepth, (p.x - r) / farDepth) * grid.projection[0][0];
+		float right = std::max((p.x + r) / nearDepth, (p.x + r) / farDepth) * grid.projection[0][0];
+		float bottom = std::min((p.y - r) / nearDepth, (p.y - r) / farDepth) * grid.projection[1][1];
+		float top = std::max((p.y + r) / nearDepth, (p.y + r) / farDepth) * grid.projection[1][1];
+		if (left > 1.0f || right < -1.0f || bottom > 1.0f || top < -1.0f)
+			return bounds;
+		bounds.x0 = clusterTile(left, grid.tilesX);
+		bounds.x1 = clusterTile(right, grid.tilesX);
+		bounds.y0 = clusterTile(bottom, grid.tilesY);
+		bounds.y1 = clusterTile(top, grid.tilesY);
+	}
+	bounds.s0 = clusterSlice(grid, std::max(depth - r, grid.nearPlane));
+	bounds.s1 = clusterSlice(grid, std::min(depth + r, grid.farPlane));
+	return bounds;
+}
+
+/*
+* One bit per cluster of the row whose box is within the radius of the light
+*
+*/
+static unsigned rowMaskScalar(const ClusterGrid& grid, size_t base, const glm::vec4& light) {
+
+	unsigned mask = 0;
+	for (int x = 0; x < grid.tilesX; x++) {
+		float dx = std::max(std::max(grid.minX[base + x] - light.x, light.x - grid.maxX[base + x]), 0.0f);
+		float dy = std::max(std::max(grid.minY[base + x] - light.y, light.y - grid.maxY[base + x]), 0.0f);
+		float dz = std::max(std::max(grid.minZ[base + x] - light.z, light.z - grid.maxZ[base + x]), 0.0f);
+		if (dx * dx + dy * dy + dz * dz <= light.w)
+			mask |= 1u << x;
+	}
+	return mask;
+}
+
+#if SIMD_X86
+static unsigned rowMaskSSE(const ClusterGrid& grid, size_t base, const glm::vec4& light) {
+
+	__m128 px = _mm_set1_ps(light.x), py = _mm_set1_ps(light.y), pz = _mm_set1_ps(light.z), r2 = _mm_set1_ps(light.w);
+	__m128 zero = _mm_setzero_ps();
+	unsigned mask = 0;
+	for (int x = 0; x < grid.tilesX; x += 4) {
+		size_t i = base + x;
+		__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&grid.minX[i]), px), _mm_sub_ps(px, _mm_loadu_ps(&grid.maxX[i]))), zero);
+		__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&grid.minY[i]), py), _mm_sub_ps(py, _mm_loadu_ps(&grid.maxY[i]))), zero);
+		__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&grid.minZ[i]), pz), _mm_sub_ps(pz, _mm_loadu_ps(&grid.maxZ[i]))), zero);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		mask |= (unsigned)_mm_movemask_ps(_mm_cmple_ps(d2, r2)) << x;
+	}
+	return mask;
+}
+
+TARGET_AVX2 static unsigned rowMaskAVX2(const ClusterGrid& grid, size_t base, const glm::vec4& light) {
+
+	__m256 px = _mm256_set1_ps(light.x), py = _mm256_set1_ps(light.y), pz = _mm256_set1_ps(light.z), r2 = _mm256_set1_ps(light.w);
+	__m256 zero = _mm256_setzero_ps();
+	unsigned mask = 0;
+	for (int x = 0; x < grid.tilesX; x += 8) {
+		size_t i = base + x;
+		__m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(&grid.minX[i]), px), _mm256_sub_ps(px, _mm256_loadu_ps(&grid.maxX[i]))), zero);
+		__m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(&grid.minY[i]), py), _mm256_sub_ps(py, _mm256_loadu_ps(&grid.maxY[i]))), zero);
+		__m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(&grid.minZ[i]), pz), _mm256_sub_ps(pz, _mm256_loadu_ps(&grid.maxZ[i]))), zero);
+		// No FMA, so the sums are rounded like the scalar code and a light on the edge of a cluster gets the same answer
+		__m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		mask |= (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ)) << x;
+	}
+	return mask;
+}
+#endif
+
+static unsigned rowMask(const ClusterGrid& grid, size_t base, const glm::vec4& light, SimdISA isa) {
+
+	switch (isa) {
+#if SIMD_X86
+	case SIMD_SSE: return rowMaskSSE(grid, base, light);
+	case SIMD_AVX2:
+	case SIMD_AVX512: return rowMaskAVX2(grid, base, light);
+#endif
+	default: return rowMaskScalar(grid, base, light);
+	}
+}
+
+void buildClusters(ClusterGrid& grid, const std::vector<ClusterLight>& lights, const glm::mat4& view, SimdISA isa) {
+
+	std::vector<LightBounds> bounds(lights.size());
+	parallelFor(lights.size(), [&](size_t begin, size_t end) {
+		for (size_t l = begin; l < end; l++)
+			bounds[l] = lightBounds(grid, lights[l], view);
+	}, grid.threadCount);
+
+	// The lights are sorted into their slices in order, so every cluster gets its lights in the same order with any amount of threads
+	std::vector<std::vector<unsigned>> sliceLights(grid.slices);
+	for (size_t l = 0; l < bounds.size(); l++) {
+		for (int s = bounds[l].s0; s <= bounds[l].s1; s++)
+			sliceLights[s].push_back((unsigned)l);
+	}
+
+	// A cluster belongs to one slice, so the threads never write to the same list.
+	// A full list only counts the lights after it, they are never drawn
+	std::vector<unsigned> totals(grid.lists.size(), 0);
+	parallelFor((size_t)grid.slices, [&](size_t begin, size_t end) {
+		for (size_t s = begin; s < end; s++) {
+			size_t sliceFirst = s * grid.tilesY * grid.tilesX;
+			for (size_t c = sliceFirst; c < sliceFirst + (size_t)grid.tilesY * grid.tilesX; c++)
+				grid.lists[c].clear();
+			for (size_t k = 0; k < sliceLights[s].size(); k++) {
+				unsigned l = sliceLights[s][k];
+				const LightBounds& light = bounds[l];
+				unsigned range = (light.x1 - light.x0 == 31 ? ~0u : ((1u << (light.x1 - light.x0 + 1)) - 1)) << light.x0;
+				for (int y = light.y0; y <= light.y1; y++) {
+					size_t row = s * grid.tilesY + y;
+					unsigned mask = rowMask(grid, row * grid.rowStride, light.light, isa) & range;
+					for (int x = light.x0; mask != 0 && x <= light.x1; x++) {
+						if (mask & (1u << x)) {
+							size_t cluster = row * grid.tilesX + x;
+							if (totals[cluster]++ < grid.maxLightsPerCluster)
+								grid.lists[cluster].push_back(l);
+							mask &= ~(1u << x);
+						}
+					}
+				}
+			}
+		}
+	}, grid.threadCount);
+
+	grid.lightIndices.clear();
+	grid.dropped = 0;
+	grid.maxCount = 0;
+	for (size_t c = 0; c < grid.lists.size(); c++) {
+		const std::vector<unsigned>& list = grid.lists[c];
+		grid.ranges[c] = glm::uvec2((unsigned)grid.lightIndices.size(), (unsigned)list.size());
+		grid.lightIndices.insert(grid.lightIndices.end(), list.begin(), list.end());
+		grid.dropped += totals[c] - list.size();
+		grid.maxCount = std::max(grid.maxCount, totals[c]);
+	}
+	grid.references = grid.lightIndices.size();
+}
+
+static void uploadBufferTexture(GLuint buffer, GLuint texture, GLenum format, const void* data, size_t bytes) {
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	// Orphan the old storage every frame so the driver doesn't wait for the previous draw, an empty buffer still gets one texel
+	glBufferData(GL_TEXTURE_BUFFER, std::max(bytes, (size_t)16), NULL, GL_STREAM_DRAW);
+	if (bytes > 0)
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+/*
+* GLSL 330 has no storage buffers, so the lists are read with texelFetch() from buffer textures.
+* Every light is two texels, the position and radius then the colour.
+*
+*/
+void uploadClusters(ClusterGrid& grid, const std::vector<ClusterLight>& lights) {
+
+	if (grid.buffers[0] == 0) {
+		glGenBuffers(3, grid.buffers);
+		glGenTextures(3, grid.textures);
+	}
+	std::vector<glm::vec4> texels(lights.size() * 2);
+	for (size_t l = 0; l < lights.size(); l++) {
+		texels[2 * l] = glm::vec4(lights[l].position, lights[l].radius);
+		texels[2 * l + 1] = glm::vec4(lights[l].color, 0.0f);
+	}
+	uploadBufferTexture(grid.buffers[0], grid.textures[0], GL_RG32UI, grid.ranges.data(), grid.ranges.size() * sizeof(glm::uvec2));
+	uploadBufferTexture(grid.buffers[1], grid.textures[1], GL_R32UI, grid.lightIndices.data(), grid.lightIndices.size() * sizeof(unsigned));
+	uploadBufferTexture(grid.buffers[2], grid.textures[2], GL_RGBA32F, texels.data(), texels.size() * sizeof(glm::vec4));
+}
+
+void bindClusters(const ClusterGrid& grid, GLuint shader, int viewportWidth, int viewportHeight) {
+
+	static const char* samplers[3] = { "clusterRanges", "clusterIndices", "clusterLights" };
+	glUseProgram(shader);
+	for (int t = 0; t < 3; t++) {
+		glActiveTexture(GL_TEXTURE1 + t);
+		glBindTexture(GL_TEXTURE_BUFFER, grid.textures[t]);
+		glUniform1i(glGetUniformLocation(shader, samplers[t]), 1 + t);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glUniform3i(glGetUniformLocation(shader, "clusterTiles"), grid.tilesX, grid.tilesY, grid.slices);
+	glUniform2f(glGetUniformLocation(shader, "clusterTileSize"), (float)viewportWidth / grid.tilesX, (float)viewportHeight / grid.tilesY);
+	glUniform2f(glGetUniformLocation(shader, "clusterDepth"), grid.nearPlane, grid.slices / log(grid.farPlane / grid.nearPlane));
+}
+
+void deleteClusters(ClusterGrid& grid) {
+
+	glDeleteBuffers(3, grid.buffers);
+	glDeleteTextures(3, grid.textures);
+	for (int t = 0; t < 3; t++)
+		grid.buffers[t] = grid.textures[t] = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef cluster_H
+#define cluster_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "simd.h"
+
+/* Cluster Light
+*
+* A point light that fades to 0 at its radius, so it only has to be given to the clusters its sphere touches.
+* @position is in the same space as FragPos in frag.glsl
+*
+*/
+struct ClusterLight
+{
+	glm::vec3 position;
+	float radius;
+	glm::vec3 color;
+};
+
+/* Cluster Grid
+*
+* The view frustum split in @tilesX by @tilesY tiles on the screen and @slices in depth. The slices grow exponentially
+* with the distance, so a cluster is about as deep as it is wide everywhere.
+* Every frame the lights are given to the clusters they touch, and the fragment shader only loops over the lights of its cluster.
+* @tilesX can be at most 32, a row of clusters is tested at once with SIMD and the result is kept in a bit mask
+* @maxLightsPerCluster bounds the loop of the shader, the lights after it are dropped and counted in @dropped
+* @threadCount is how many threads assign the lights, each thread takes whole slices. 0 uses every core
+* @minX to @maxZ are the view space bounding boxes of the clusters, one row of @rowStride per tile row and slice
+* @ranges are the offset in @lightIndices and the amount of lights of every cluster
+* @lists are the lights of every cluster while they are assigned, kept between frames so they don't allocate again,
+* @lightIndices is all of them one cluster after the other
+* @references is the length of @lightIndices and @maxCount the most lights a cluster has
+* @buffers and @textures are the buffer textures created by uploadClusters(), 0 holds @ranges, 1 @lightIndices and 2 the lights,
+* two texels per light, and bindClusters() binds them to the texture units 1 to 3 in that order
+*
+*/
+struct ClusterGrid
+{
+	int tilesX = 16;
+	int tilesY = 16;
+	int slices = 24;
+	unsigned maxLightsPerCluster = 128;
+	unsigned threadCount = 0;
+
+	glm::mat4 projection;
+	float nearPlane = 0.0f;
+	float farPlane = 0.0f;
+	int rowStride = 0;
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+	std::vector<glm::uvec2> ranges;
+	std::vector<unsigned> lightIndices;
+	std::vector<std::vector<unsigned>> lists;
+	size_t references = 0;
+	size_t dropped = 0;
+	unsigned maxCount = 0;
+
+	GLuint buffers[3] = { 0, 0, 0 };
+	GLuint textures[3] = { 0, 0, 0 };
+};
+
+// Builds the bounding boxes of the clusters for a perspective projection, nothing is done if it is the one they were built for
+void setClusterProjection(ClusterGrid& grid, const glm::mat4& projection);
+
+// Gives every light to the clusters its sphere touches, setClusterProjection() has to be called first
+void buildClusters(ClusterGrid& grid, const std::vector<ClusterLight>& lights, const glm::mat4& view, SimdISA isa);
+
+// Copies the clusters and the lights into the buffer textures read by lighting.glsl
+void uploadClusters(ClusterGrid& grid, const std::vector<ClusterLight>& lights);
+
+// Binds the buffer textures to the texture units 1 to 3 and sets the uniforms of a program built with CLUSTERED
+void bindClusters(const ClusterGrid& grid, GLuint shader, int viewportWidth, int viewportHeight);
+
+void deleteClusters(ClusterGrid& grid);
+
+#endif
@@ -0,0 +1,252 @@
+// Spatial hash based on Teschner et al. "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+// Sweep and prune based on Cohen et al. "I-COLLIDE: An Interactive and Exact Collision Detection System"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "collision.h"
+#include "parallel.h"
+
+/*Spatial hash variables
+*
+* @maxHistogramChunks limits how many parts the counting sort is split in, every part has its own counter per bucket
+* so more parts use more temporary memory
+*
+*/
+const unsigned maxHistogramChunks = 8;
+
+static inline unsigned hashCell(const glm::ivec3& cell, unsigned mask) {
+	return (((unsigned)cell.x * 73856093u) ^ ((unsigned)cell.y * 19349663u) ^ ((unsigned)cell.z * 83492791u)) & mask;
+}
+
+void buildSpatialHash(SpatialHash& hash, const Planet* planets, size_t count) {
+
+	double maxRadius = 0.0;
+	for (size_t i = 0; i < count; i++)
+		maxRadius = std::max(maxRadius, planets[i].radius);
+	hash.cellSize = std::max(maxRadius * 2.0, 1e-6);
+
+	// A power of two with at least one bucket per Planet keeps the buckets short and the hash a simple mask
+	unsigned tableSize = 1;
+	while (tableSize < count)
+		tableSize <<= 1;
+	unsigned mask = tableSize - 1;
+
+	std::vector<glm::ivec3> cells(count);
+	hash.cells.resize(count);
+	hash.buckets.resize(count);
+	hash.bodies.resize(count);
+	hash.cellStart.assign(tableSize + 1, 0);
+
+	double inverseCell = 1.0 / hash.cellSize;
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			cells[i] = glm::ivec3((int)floor(planets[i].xpos * inverseCell), (int)floor(planets[i].ypos * inverseCell), (int)floor(planets[i].zpos * inverseCell));
+			hash.buckets[i] = hashCell(cells[i], mask);
+		}
+	}, hash.threadCount);
+
+	unsigned chunks = hash.threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : hash.threadCount;
+	chunks = (unsigned)std::max<size_t>(1, std::min<size_t>(std::min(chunks, maxHistogramChunks), count));
+	size_t chunkSize = (count + chunks - 1) / std::max(chunks, 1u);
+
+	// Every chunk counts its own Planets, then the counters become the offsets where each chunk writes its Planets.
+	// The chunks keep their order inside a bucket, so the result doesn't depend on the amount of threads.
+	std::vector<unsigned> histograms((size_t)chunks * tableSize, 0);
+	parallelFor(chunks, [&](size_t chunkBegin, size_t chunkEnd) {
+		for (size_t c = chunkBegin; c < chunkEnd; c++) {
+			unsigned* histogram = histograms.data() + c * tableSize;
+			size_t end = std::min(count, (c + 1) * chunkSize);
+			for (size_t i = c * chunkSize; i < end; i++)
+				histogram[hash.buckets[i]]++;
+		}
+	}, chunks);
+
+	unsigned offset = 0;
+	for (unsigned b = 0; b < tableSize; b++) {
+		hash.cellStart[b] = offset;
+		for (unsigned c = 0; c < chunks; c++) {
+			unsigned amount = histograms[(size_t)c * tableSize + b];
+			histograms[(size_t)c * tableSize + b] = offset;
+			offset += amount;
+		}
+	}
+	hash.cellStart[tableSize] = offset;
+
+	parallelFor(chunks, [&](size_t chunkBegin, size_t chunkEnd) {
+		for (size_t c = chunkBegin; c < chunkEnd; c++) {
+			unsigned* next = histograms.data() + c * tableSize;
+			size_t end = std::min(count, (c + 1) * chunkSize);
+			for (size_t i = c * chunkSize; i < end; i++) {
+				unsigned slot = next[hash.buckets[i]]++;
+				hash.bodies[slot] = (unsigned)i;
+				hash.cells[slot] = cells[i];
+			}
+		}
+	}, chunks);
+}
+
+/*
+* Every Planet pairs itself with the Planets of a bigger index in its own cell and with every Planet in 13 of its neighbour cells,
+* the other 13 neighbours find the same pairs from their side so each pair of cells is only read once.
+* Different cells can hash into the same bucket, so only the Planets whose cell is exactly the neighbour are used.
+* The Planets are visited in bucket order, so the cells of a bucket are read from memory next to each other.
+*
+*/
+void findCandidatePairs(const SpatialHash& hash, size_t count, std::vector<CollisionPair>& candidates) {
+
+	candidates.clear();
+	if (count == 0)
+		return;
+	unsigned mask = (unsigned)hash.cellStart.size() - 2;
+
+	glm::ivec3 neighbours[14];
+	int neighbourCount = 0;
+	for (int dz = -1; dz <= 1; dz++) {
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dx = -1; dx <= 1; dx++) {
+				if (dz > 0 || (dz == 0 && dy > 0) || (dz == 0 && dy == 0 && dx >= 0))
+					neighbours[neighbourCount++] = glm::ivec3(dx, dy, dz);
+			}
+		}
+	}
+
+	unsigned threadCount = hash.threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : hash.threadCount;
+	threadCount = (unsigned)std::min<size_t>(threadCount, count);
+	size_t chunkSize = (count + threadCount - 1) / threadCount;
+	std::vector<std::vector<CollisionPair>> threadPairs(threadCount);
+
+	parallelFor(threadCount, [&](size_t threadBegin, size_t threadEnd) {
+		for (size_t t = threadBegin; t < threadEnd; t++) {
+			std::vector<CollisionPair>& pairs = threadPairs[t];
+			size_t end = std::min(count, (t + 1) * chunkSize);
+			for (size_t slot = t * chunkSize; slot < end; slot++) {
+				unsigned i = hash.bodies[slot];
+				const glm::ivec3& cell = hash.cells[slot];
+				for (int n = 0; n < neighbourCount; n++) {
+					glm::ivec3 neighbour = cell + neighbours[n];
+					bool sameCell = n == 0;
+					unsigned bucket = hashCell(neighbour, mask);
+					for (unsigned k = hash.cellStart[bucket]; k < hash.cellStart[bucket + 1]; k++) {
+						unsigned j = hash.bodies[k];
+						if (hash.cells[k] != neighbour || (sameCell && j <= i))
+							continue;
+						CollisionPair pair = { std::min(i, j), std::max(i, j) };
+						pairs.push_back(pair);
+					}
+				}
+			}
+		}
+	}, threadCount);
+
+	for (unsigned t = 0; t < threadCount; t++)
+		candidates.insert(candidates.end(), threadPairs[t].begin(), threadPairs[t].end());
+}
+
+/*
+* Moves every entry back until the one before it starts earlier, O(N + swaps) so about O(N) when the order barely changed
+*
+*/
+static size_t insertionSort(std::vector<SweepEntry>& entries) {
+
+	size_t swaps = 0;
+	for (size_t i = 1; i < entries.size(); i++) {
+		SweepEntry entry = entries[i];
+		size_t j = i;
+		while (j > 0 && entries[j - 1].min > entry.min) {
+			entries[j] = entries[j - 1];
+			j--;
+		}
+		swaps += i - j;
+		entries[j] = entry;
+	}
+	return swaps;
+}
+
+static void sortAxis(SweepAndPrune& sweep, int axis, const Planet* planets, size_t count, bool rebuild) {
+
+	std::vector<SweepEntry>& entries = sweep.axes[axis];
+	if (rebuild) {
+		entries.resize(count);
+		for (size_t i = 0; i < count; i++)
+			entries[i].body = (unsigned)i;
+	}
+	for (size_t i = 0; i < count; i++) {
+		SweepEntry& entry = entries[i];
+		const Planet& planet = planets[entry.body];
+		glm::dvec3 center(planet.xpos, planet.ypos, planet.zpos);
+		entry.min = center[axis] - planet.radius;
+		entry.max = center[axis] + planet.radius;
+		for (int k = 0; k < 2; k++) {
+			entry.otherMin[k] = center[(axis + 1 + k) % 3] - planet.radius;
+			entry.otherMax[k] = center[(axis + 1 + k) % 3] + planet.radius;
+		}
+	}
+	if (sweep.coherent && !rebuild)
+		sweep.swaps += insertionSort(entries);
+	else
+		std::sort(entries.begin(), entries.end(), [](const SweepEntry& a, const SweepEntry& b) { return a.min < b.min; });
+}
+
+void updateSweepAndPrune(SweepAndPrune& sweep, const Planet* planets, size_t count) {
+
+	sweep.swaps = 0;
+	if (!sweep.multiAxis) {
+		sortAxis(sweep, sweep.axis, planets, count, sweep.axes[sweep.axis].size() != count);
+		return;
+	}
+
+	// Along the axis with the biggest variance the fewest intervals overlap by chance
+	if (count > 0) {
+		glm::dvec3 mean(0.0);
+		glm::dvec3 meanSquare(0.0);
+		for (size_t i = 0; i < count; i++) {
+			glm::dvec3 center(planets[i].xpos, planets[i].ypos, planets[i].zpos);
+			mean += center;
+			meanSquare += center * center;
+		}
+		mean /= (double)count;
+		glm::dvec3 variance = meanSquare / (double)count - mean * mean;
+		sweep.axis = variance.x >= variance.y && variance.x >= variance.z ? 0 : (variance.y >= variance.z ? 1 : 2);
+	}
+	for (int axis = 0; axis < 3; axis++)
+		sortAxis(sweep, axis, planets, count, sweep.axes[axis].size() != count);
+}
+
+void findSweepPairs(const SweepAndPrune& sweep, std::vector<CollisionPair>& candidates) {
+
+	candidates.clear();
+	const std::vector<SweepEntry>& entries = sweep.axes[sweep.axis];
+	for (size_t i = 0; i < entries.size(); i++) {
+		const SweepEntry& entry = entries[i];
+		for (size_t j = i + 1; j < entries.size() && entries[j].min <= entry.max; j++) {
+			const SweepEntry& other = entries[j];
+			if (other.otherMin[0] > entry.otherMax[0] || other.otherMax[0] < entry.otherMin[0]
+				|| other.otherMin[1] > entry.otherMax[1] || other.otherMax[1] < entry.otherMin[1])
+				continue;
+			CollisionPair pair = { std::min(entry.body, other.body), std::max(entry.body, other.body) };
+			candidates.push_back(pair);
+		}
+	}
+}
+
+void findOverlaps(const Planet* planets, const std::vector<CollisionPair>& candidates, std::vector<CollisionPair>& overlaps) {
+
+	overlaps.clear();
+	for (size_t p = 0; p < candidates.size(); p++) {
+		const Planet& a = planets[candidates[p].a];
+		const Planet& b = planets[candidates[p].b];
+		double dx = a.xpos - b.xpos;
+		double dy = a.ypos - b.ypos;
+		double dz = a.zpos - b.zpos;
+		double radii = a.radius + b.radius;
+		if (dx * dx + dy * dy + dz * dz < radii * radii)
+			overlaps.push_back(candidates[p]);
+	}
+}
+
+size_t spatialHashBytes(const SpatialHash& hash) {
+	return hash.cellStart.capacity() * sizeof(unsigned) + hash.bodies.capacity() * sizeof(unsigned)
+		+ hash.cells.capacity() * sizeof(glm::ivec3) + hash.buckets.capacity() * sizeof(unsigned);
+}
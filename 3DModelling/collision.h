@@ -0,0 +1,94 @@
+#ifndef collision_H
+#define collision_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "planet.h"
+
+/* Collision Pair
+*
+* Two Planets by their index in the array, @a is always smaller than @b so every pair appears once
+*
+*/
+struct CollisionPair
+{
+	unsigned a, b;
+};
+
+/* Spatial Hash
+*
+* Uniform grid over the Planets, every Planet is stored in the cell of its center and the cells are hashed into a table
+* so the grid can be unbounded while the memory stays proportional to the amount of Planets.
+* @threadCount is how many threads build and query the grid, 0 uses every core
+* @cellSize is set by the build to the biggest diameter, so two overlapping Planets are always in the same or neighbour cells
+* @cellStart is the first entry of every bucket in @bodies, with one more entry at the end
+* @bodies are the indices of the Planets sorted by bucket and @cells their integer cell coordinates in the same order
+* @buckets is the bucket of every Planet by its index
+*
+*/
+struct SpatialHash
+{
+	unsigned threadCount = 0;
+	double cellSize = 0.0;
+	std::vector<unsigned> cellStart;
+	std::vector<unsigned> bodies;
+	std::vector<glm::ivec3> cells;
+	std::vector<unsigned> buckets;
+};
+
+/* Sweep Entry
+*
+* The interval of one Planet on the axis of a sweep, the entries are kept sorted by @min.
+* The bounds on the two other axes are copied next to it so the sweep reads the memory in order.
+*
+*/
+struct SweepEntry
+{
+	double min, max;
+	double otherMin[2], otherMax[2];
+	unsigned body;
+};
+
+/* Sweep and Prune
+*
+* Sorted intervals of the bounding boxes of the Planets, two Planets can only overlap if their intervals overlap.
+* Unlike the grid it works for any mix of sizes, a big Planet only makes its own interval longer.
+* The order of the last update is kept, when the Planets move a little between updates it is almost sorted
+* and the insertion sort only does a few swaps.
+* @multiAxis keeps all three axes sorted and sweeps along the one where the Planets are the most spread,
+* otherwise only @axis is sorted and swept
+* @coherent uses the insertion sort, when false every update sorts the intervals from the start
+* @swaps is how many swaps the insertion sort did in the last update
+* @axes are the sorted intervals of every axis
+*
+*/
+struct SweepAndPrune
+{
+	bool multiAxis = false;
+	int axis = 0;
+	bool coherent = true;
+	size_t swaps = 0;
+	std::vector<SweepEntry> axes[3];
+};
+
+// Places the Planets in the grid with a parallel counting sort by bucket
+void buildSpatialHash(SpatialHash& hash, const Planet* planets, size_t count);
+
+// Pairs of Planets in neighbour cells, they may overlap and have to be checked by findOverlaps
+void findCandidatePairs(const SpatialHash& hash, size_t count, std::vector<CollisionPair>& candidates);
+
+// Updates the bounding boxes and sorts the intervals again
+void updateSweepAndPrune(SweepAndPrune& sweep, const Planet* planets, size_t count);
+
+// Pairs of Planets whose bounding boxes overlap, they have to be checked by findOverlaps
+void findSweepPairs(const SweepAndPrune& sweep, std::vector<CollisionPair>& candidates);
+
+// Narrow phase, keeps the candidates whose spheres really overlap
+void findOverlaps(const Planet* planets, const std::vector<CollisionPair>& candidates, std::vector<CollisionPair>& overlaps);
+
+// Bytes used by the arrays of the grid, the temporary counters of the build are not included
+size_t spatialHashBytes(const SpatialHash& hash);
+
+#endif
@@ -0,0 +1,94 @@
+#include <cmath>
+
+#include "cull.h"
+
+/*
+* Gribb and Hartmann plane extraction, every plane is normalized so the distance to it is in world units
+*
+*/
+Frustum extractFrustum(const glm::mat4& clip) {
+
+	Frustum frustum;
+	glm::vec4 row0(clip[0][0], clip[1][0], clip[2][0], clip[3][0]);
+	glm::vec4 row1(clip[0][1], clip[1][1], clip[2][1], clip[3][1]);
+	glm::vec4 row2(clip[0][2], clip[1][2], clip[2][2], clip[3][2]);
+	glm::vec4 row3(clip[0][3], clip[1][3], clip[2][3], clip[3][3]);
+
+	frustum.planes[0] = row3 + row0;
+	frustum.planes[1] = row3 - row0;
+	frustum.planes[2] = row3 + row1;
+	frustum.planes[3] = row3 - row1;
+	frustum.planes[4] = row3 + row2;
+	frustum.planes[5] = row3 - row2;
+
+	for (int p = 0; p < 6; p++) {
+		float length = glm::length(glm::vec3(frustum.planes[p]));
+		if (length > 0.0f)
+			frustum.planes[p] /= length;
+	}
+	return frustum;
+}
+
+float projectionNearPlane(const glm::mat4& projection) {
+	return projection[3][2] / (projection[2][2] - 1.0f);
+}
+
+float projectionFarPlane(const glm::mat4& projection) {
+	return projection[3][2] / (projection[2][2] + 1.0f);
+}
+
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+
+	for (int p = 0; p < 6; p++) {
+		const glm::vec4& plane = frustum.planes[p];
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+	return true;
+}
+
+/*
+* A cluster is backfacing when the camera is behind every triangle of it, the test is done with the bounding Sphere
+* so it stays conservative for every point of the cluster.
+*
+*/
+void cullMeshlets(const std::vector<Meshlet>& meshlets, const glm::vec3& center, float scale,
+	const glm::vec3& cameraPos, const Frustum& frustum, CullStats& stats,
+	std::vector<GLsizei>& counts, std::vector<const GLvoid*>& offsets) {
+
+	counts.clear();
+	offsets.clear();
+
+	for (size_t m = 0; m < meshlets.size(); m++) {
+		const Meshlet& meshlet = meshlets[m];
+		glm::vec3 meshletCenter = center + meshlet.center * scale;
+		float meshletRadius = meshlet.radius * scale;
+
+		stats.clustersTested++;
+		stats.trianglesTested += meshlet.triangleCount;
+
+		glm::vec3 toCluster = meshletCenter - cameraPos;
+		if (glm::dot(toCluster, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCluster) + meshletRadius) {
+			stats.clustersBackface++;
+			stats.trianglesRejected += meshlet.triangleCount;
+			continue;
+		}
+		if (!sphereInFrustum(frustum, meshletCenter, meshletRadius)) {
+			stats.clustersOutside++;
+			stats.trianglesRejected += meshlet.triangleCount;
+			continue;
+		}
+
+		// Neighbour clusters are merged into one range so the driver gets fewer draws
+		GLsizei count = (GLsizei)meshlet.triangleCount * 3;
+		const GLvoid* offset = (const GLvoid*)(meshlet.indexOffset * sizeof(GLuint));
+		if (!counts.empty() && (const char*)offsets.back() + counts.back() * sizeof(GLuint) == (const char*)offset) {
+			counts.back() += count;
+		}
+		else
+		{
+			counts.push_back(count);
+			offsets.push_back(offset);
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef cull_H
+#define cull_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "meshlet.h"
+
+/* Frustum Structure
+*
+* The six planes (left, right, bottom, top, near, far) of a clip matrix, each one is (normal, distance) with the normal pointing inside.
+* If the clip matrix is projection * view * model the planes are in the same space as the vertices before the model matrix.
+*
+*/
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+/* Culling statistics
+*
+* These are reset by the caller every frame and incremented by the cull functions.
+*
+*/
+struct CullStats
+{
+	unsigned long clustersTested = 0;
+	unsigned long clustersBackface = 0;
+	unsigned long clustersOutside = 0;
+	unsigned long trianglesTested = 0;
+	unsigned long trianglesRejected = 0;
+};
+
+Frustum extractFrustum(const glm::mat4& clip);
+
+// The distances of the clip planes of a glm::perspective() matrix
+float projectionNearPlane(const glm::mat4& projection);
+float projectionFarPlane(const glm::mat4& projection);
+
+bool sphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+
+/*
+* Culls the meshlets of a mesh placed at center with the given scale and fills the ranges that are left to draw with glMultiDrawElements()
+* @cameraPos has to be in the same space as the frustum planes
+*
+*/
+void cullMeshlets(const std::vector<Meshlet>& meshlets, const glm::vec3& center, float scale,
+	const glm::vec3& cameraPos, const Frustum& frustum, CullStats& stats,
+	std::vector<GLsizei>& counts, std::vector<const GLvoid*>& offsets);
+
+#endif
@@ -0,0 +1,54 @@
+#include <glm/gtc/type_ptr.hpp>
+
+#include "deferred.h"
+
+/*Deferred variables
+*
+* @gBufferTextureUnit is the first texture unit of the G-buffer, the units before it hold the clusters
+*
+*/
+const int gBufferTextureUnit = 4;
+
+const std::vector<GLenum>& gBufferFormats() {
+
+	static const std::vector<GLenum> formats = { GL_RGBA16F, GL_RGBA8, GL_RGBA16F };
+	return formats;
+}
+
+void beginGBuffer(Framebuffer& gBuffer, int width, int height, const glm::vec3& background) {
+
+	resizeFramebuffer(gBuffer, width, height, gBufferFormats(), true);
+	bindFramebuffer(gBuffer);
+	const GLfloat clearColor[4] = { background.r, background.g, background.b, 1.0f };
+	const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat farDepth = 1.0f;
+	glClearBufferfv(GL_COLOR, 0, clearColor);
+	glClearBufferfv(GL_COLOR, 1, zero);
+	glClearBufferfv(GL_COLOR, 2, zero);
+	glClearBufferfv(GL_DEPTH, 0, &farDepth);
+}
+
+void drawDeferredLighting(const Framebuffer& gBuffer, GLuint shader, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos) {
+
+	static const char* samplers[4] = { "gColor", "gAlbedo", "gNormal", "gDepth" };
+	glUseProgram(shader);
+	for (int t = 0; t < 4; t++) {
+		glActiveTexture(GL_TEXTURE0 + gBufferTextureUnit + t);
+		glBindTexture(GL_TEXTURE_2D, t < 3 ? gBuffer.colors[t] : gBuffer.depth);
+		glUniform1i(glGetUniformLocation(shader, samplers[t]), gBufferTextureUnit + t);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glUniformMatrix4fv(glGetUniformLocation(shader, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	glUniform3f(glGetUniformLocation(shader, "viewPos"), viewPos.x, viewPos.y, viewPos.z);
+	glUniform2f(glGetUniformLocation(shader, "screenSize"), (GLfloat)gBuffer.width, (GLfloat)gBuffer.height);
+
+	// Every pixel is written once, so the depth test and the depth writes are not needed
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	drawFullscreenTriangle();
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+}
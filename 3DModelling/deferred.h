@@ -0,0 +1,29 @@
+#ifndef deferred_H
+#define deferred_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "framebuffer.h"
+
+/*
+* Deferred shading draws the geometry once into a G-buffer, then one pass over the screen adds the lights of the clusters
+* (see cluster.h) to every pixel, so a light costs the same no matter how many triangles are under it.
+* The DEFERRED variants of frag.glsl and impostor_frag.glsl write:
+* location 0 the colour of everything forward lighting adds before the clusters, the own light of the Sphere,
+* the ambient term and the shared lights. The background colour is cleared into it
+* location 1 the objectColor
+* location 2 the normal, in the space of FragPos of frag.glsl
+* and the depth, from which the lighting pass rebuilds the position
+*
+*/
+const std::vector<GLenum>& gBufferFormats();
+
+// Binds the G-buffer, creating it the first time or when the size changed, and clears it
+void beginGBuffer(Framebuffer& gBuffer, int width, int height, const glm::vec3& background);
+
+// Draws deferred_frag.glsl into the bound framebuffer, the program needs the clusters bound when it is built with CLUSTERED
+void drawDeferredLighting(const Framebuffer& gBuffer, GLuint shader, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+
+#endif
@@ -0,0 +1,38 @@
+#version 330 core
+out vec4 color;
+
+// The G-buffer written by the DEFERRED variants of frag.glsl and impostor_frag.glsl, see deferred.h
+uniform sampler2D gColor;
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+uniform mat4 view;
+uniform vec3 viewPos;
+uniform vec2 screenSize;
+
+#include "lighting.glsl"
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 result = texelFetch(gColor, pixel, 0).rgb;
+    float depth = texelFetch(gDepth, pixel, 0).r;
+
+#if CLUSTERED
+    // Nothing was drawn on the background, it keeps the clear colour
+    if (depth < 1.0f)
+    {
+        vec4 clipPos = vec4(gl_FragCoord.xy / screenSize * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+        vec4 position = inverseViewProjection * clipPos;
+        vec3 FragPos = position.xyz / position.w;
+        vec3 norm = normalize(texelFetch(gNormal, pixel, 0).xyz);
+        vec3 viewDir = normalize(viewPos - FragPos);
+        float viewDepth = -(view * vec4(FragPos, 1.0f)).z;
+        // The same terms the forward shaders add last in phongLighting()
+        result += clusterLighting(FragPos, norm, viewDir, viewDepth, mat4(1.0f)) * texelFetch(gAlbedo, pixel, 0).rgb;
+    }
+#endif
+    color = vec4(result, 1.0f);
+}
@@ -0,0 +1,8 @@
+#version 330 core
+
+// One triangle that covers the screen, its corners are (-1,-1), (3,-1) and (-1,3)
+void main()
+{
+    vec2 corner = vec2((gl_VertexID & 1) * 4 - 1, (gl_VertexID >> 1) * 4 - 1);
+    gl_Position = vec4(corner, 0.0f, 1.0f);
+}
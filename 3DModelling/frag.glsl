@@ -1,5 +1,18 @@
 #version 330 core
-out vec4 color;
+
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+#ifndef DEFERRED
+#define DEFERRED 0
+#endif
+
+layout (location = 0) out vec4 color;
+#if DEFERRED
+// The G-buffer, see deferred.h
+layout (location = 1) out vec4 gAlbedo;
+layout (location = 2) out vec4 gNormal;
+#endif
 
 in vec3 FragPos;  
 in vec3 Normal;  
@@ -8,26 +21,30 @@ uniform vec3 lightPos;
 uniform vec3 viewPos;
 uniform vec3 lightColor;
 uniform vec3 objectColor;
+uniform mat4 view;
+
+#if INSTANCED
+flat in vec3 ObjectColor;
+flat in vec3 LightColor;
+flat in vec3 LightPos;
+#endif
+
+#include "lighting.glsl"
 
 void main()
 {
-    // Ambient
-    float ambientStrength = 0.9f;
-    vec3 ambient = ambientStrength * lightColor;
-  	
-    // Diffuse 
-    vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
-    
-    // Specular
-    float specularStrength = 0.2f;
     vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);  
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * lightColor;  
-        
-    vec3 result = (ambient + diffuse + specular) * objectColor;
+    float viewDepth = -(view * vec4(FragPos, 1.0f)).z;
+#if INSTANCED
+    vec3 albedo = ObjectColor;
+    vec3 result = phongLighting(FragPos, Normal, viewDir, LightPos, LightColor, ObjectColor, mat4(1.0f), viewDepth);
+#else
+    vec3 albedo = objectColor;
+    vec3 result = phongLighting(FragPos, Normal, viewDir, lightPos, lightColor, objectColor, mat4(1.0f), viewDepth);
+#endif
     color = vec4(result, 1.0f);
-} 
\ No newline at end of file
+#if DEFERRED
+    gAlbedo = vec4(albedo, 1.0f);
+    gNormal = vec4(normalize(Normal), 0.0f);
+#endif
+} 
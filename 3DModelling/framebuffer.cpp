@@ -0,0 +1,107 @@
+#include <iostream>
+
+#include "framebuffer.h"
+
+static GLuint fullscreenVAO = 0;
+
+static GLuint createTexture(GLenum internalFormat, GLenum format, int width, int height, GLint filter) {
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	// There is no data, so the format and type only have to be valid for the internal format
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+bool createFramebuffer(Framebuffer& framebuffer, int width, int height, const std::vector<GLenum>& colorFormats, bool withDepth) {
+
+	deleteFramebuffer(framebuffer);
+	framebuffer.width = width;
+	framebuffer.height = height;
+	framebuffer.colorFormats = colorFormats;
+
+	glGenFramebuffers(1, &framebuffer.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+	std::vector<GLenum> drawBuffers;
+	for (size_t c = 0; c < colorFormats.size(); c++) {
+		framebuffer.colors.push_back(createTexture(colorFormats[c], GL_RGBA, width, height, GL_LINEAR));
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)c, GL_TEXTURE_2D, framebuffer.colors[c], 0);
+		drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)c);
+	}
+	if (withDepth) {
+		framebuffer.depth = createTexture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, width, height, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, framebuffer.depth, 0);
+	}
+	if (drawBuffers.empty()) {
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	}
+	else
+	{
+		glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+	}
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE 0x" << std::hex << status << std::dec << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void resizeFramebuffer(Framebuffer& framebuffer, int width, int height, const std::vector<GLenum>& colorFormats, bool withDepth) {
+
+	if (framebuffer.fbo != 0 && framebuffer.width == width && framebuffer.height == height
+		&& framebuffer.colorFormats == colorFormats && (framebuffer.depth != 0) == withDepth)
+		return;
+	createFramebuffer(framebuffer, width, height, colorFormats, withDepth);
+}
+
+void deleteFramebuffer(Framebuffer& framebuffer) {
+
+	if (!framebuffer.colors.empty())
+		glDeleteTextures((GLsizei)framebuffer.colors.size(), framebuffer.colors.data());
+	glDeleteTextures(1, &framebuffer.depth);
+	glDeleteFramebuffers(1, &framebuffer.fbo);
+	framebuffer.colors.clear();
+	framebuffer.colorFormats.clear();
+	framebuffer.depth = framebuffer.fbo = 0;
+	framebuffer.width = framebuffer.height = 0;
+}
+
+void bindFramebuffer(const Framebuffer& framebuffer) {
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+	glViewport(0, 0, framebuffer.width, framebuffer.height);
+}
+
+void copyDepth(const Framebuffer& source, const Framebuffer& target) {
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, source.fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.fbo);
+	glBlitFramebuffer(0, 0, source.width, source.height, 0, 0, target.width, target.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+}
+
+void drawFullscreenTriangle() {
+
+	// The triangle has no attributes, but a VAO still has to be bound to draw
+	if (fullscreenVAO == 0)
+		glGenVertexArrays(1, &fullscreenVAO);
+	glBindVertexArray(fullscreenVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
+
+void deleteFullscreenTriangle() {
+
+	glDeleteVertexArrays(1, &fullscreenVAO);
+	fullscreenVAO = 0;
+}
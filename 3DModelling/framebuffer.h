@@ -0,0 +1,43 @@
+#ifndef framebuffer_H
+#define framebuffer_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+/* Framebuffer
+*
+* An offscreen render target, every attachment is a texture so the next pass can read it.
+* @colorFormats are the internal formats of the colour attachments, the shaders write them in this order (location 0, 1, ...)
+* @colors are the colour textures and @depth the depth texture, 0 when the framebuffer was created without one
+*
+*/
+struct Framebuffer
+{
+	int width = 0;
+	int height = 0;
+	GLuint fbo = 0;
+	std::vector<GLenum> colorFormats;
+	std::vector<GLuint> colors;
+	GLuint depth = 0;
+};
+
+// Creates the textures and the framebuffer, an incomplete framebuffer is reported and false is returned
+bool createFramebuffer(Framebuffer& framebuffer, int width, int height, const std::vector<GLenum>& colorFormats, bool withDepth);
+
+// Creates the framebuffer again only if the size or the formats changed, it is cheap to call every frame
+void resizeFramebuffer(Framebuffer& framebuffer, int width, int height, const std::vector<GLenum>& colorFormats, bool withDepth);
+void deleteFramebuffer(Framebuffer& framebuffer);
+
+// Binds the framebuffer and sets the viewport to its size
+void bindFramebuffer(const Framebuffer& framebuffer);
+
+// Copies the depth of @source into @target, they have to be the same size
+void copyDepth(const Framebuffer& source, const Framebuffer& target);
+
+// One triangle that covers the screen, the vertex shader makes its corners from gl_VertexID
+void drawFullscreenTriangle();
+void deleteFullscreenTriangle();
+
+#endif
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "generate.h"
+#include "parallel.h"
+#include "rng.h"
+
+const double layoutPi = 3.14159265358979323846;
+
+void generatePlanetColors(Planet* planets, size_t count, uint64_t seed, unsigned threadCount) {
+
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			planets[i].red = randomFloat(seed, i, STREAM_RED);
+			planets[i].green = randomFloat(seed, i, STREAM_GREEN);
+			planets[i].blue = randomFloat(seed, i, STREAM_BLUE);
+		}
+	}, threadCount);
+}
+
+void generatePlanetEmissive(Planet* planets, size_t count, uint64_t seed, const EmissiveSettings& settings, unsigned threadCount) {
+
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			float random = randomFloat(seed, i, STREAM_EMISSIVE);
+			// The same number picks the stars and the brightness of the others, which is uniform again above starFraction
+			if (random < settings.starFraction)
+				planets[i].emissive = settings.starIntensity;
+			else
+				planets[i].emissive = settings.minimum + (1.0f - settings.minimum) * (random - settings.starFraction) / (1.0f - settings.starFraction);
+		}
+	}, threadCount);
+}
+
+/*
+* Two independent normal numbers from two uniform ones with the Box-Muller transform
+*
+*/
+static glm::dvec2 gaussianPair(uint64_t seed, uint64_t counter, uint64_t streamU, uint64_t streamV) {
+
+	double u = 1.0 - randomDouble(seed, counter, streamU);
+	double v = randomDouble(seed, counter, streamV);
+	double length = sqrt(-2.0 * log(u));
+	return glm::dvec2(length * cos(2.0 * layoutPi * v), length * sin(2.0 * layoutPi * v));
+}
+
+static glm::dvec3 spiralPosition(const LayoutSettings& layout, size_t i) {
+	return glm::dvec3(cos((double)i) * i * layout.spiralSize, 0.0, sin((double)i) * i * layout.spiralSize);
+}
+
+/*
+* The distance to the center is uniform over the area of the disc, the angle follows the arm for that distance
+* and a Gaussian offset that grows with the distance gives the arms their width
+*
+*/
+static glm::dvec3 logSpiralPosition(const LayoutSettings& layout, size_t i) {
+
+	int arm = (int)(i % std::max(layout.arms, 1));
+	double r = layout.radius * sqrt(randomDouble(layout.seed, i, STREAM_LAYOUT_U)) + 1e-3;
+	double angle = log(r) / layout.armTightness + arm * 2.0 * layoutPi / std::max(layout.arms, 1);
+	glm::dvec2 offset = gaussianPair(layout.seed, i, STREAM_LAYOUT_V, STREAM_LAYOUT_W) * (layout.armSpread * r);
+	double height = gaussianPair(layout.seed, i, STREAM_LAYOUT_S, STREAM_LAYOUT_U).y * layout.armSpread * layout.radius * 0.1;
+	return glm::dvec3(r * cos(angle) + offset.x, height, r * sin(angle) + offset.y);
+}
+
+/*
+* The centers are uniform inside the ball, a center that falls outside of it is drawn again with the next counter
+*
+*/
+static glm::dvec3 clusterCenter(const LayoutSettings& layout, uint64_t cluster) {
+
+	glm::dvec3 center;
+	uint64_t attempt = 0;
+	do {
+		uint64_t counter = cluster * 64 + attempt++;
+		center = glm::dvec3(randomDouble(layout.seed, counter, STREAM_CLUSTER_X), randomDouble(layout.seed, counter, STREAM_CLUSTER_Y),
+			randomDouble(layout.seed, counter, STREAM_CLUSTER_Z)) * 2.0 - 1.0;
+	} while (glm::dot(center, center) > 1.0 && attempt < 64);
+	return center * (layout.radius - layout.clusterSize);
+}
+
+static glm::dvec3 clusterPosition(const LayoutSettings& layout, const std::vector<glm::dvec3>& centers, size_t i) {
+
+	glm::dvec2 xy = gaussianPair(layout.seed, i, STREAM_LAYOUT_U, STREAM_LAYOUT_V);
+	glm::dvec2 zw = gaussianPair(layout.seed, i, STREAM_LAYOUT_W, STREAM_LAYOUT_S);
+	return centers[i % centers.size()] + glm::dvec3(xy.x, xy.y, zw.x) * layout.clusterSize;
+}
+
+/*
+* The Planets of a shell are spread with the spherical Fibonacci lattice, which keeps neighbours at about the same distance
+* like a Poisson disk sampling but can place every point on its own. Each shell is turned by a random angle so they don't line up.
+*
+*/
+static glm::dvec3 shellPosition(const LayoutSettings& layout, const std::vector<size_t>& shellStart, size_t i) {
+
+	int shell = (int)(std::upper_bound(shellStart.begin(), shellStart.end(), i) - shellStart.begin()) - 1;
+	size_t k = i - shellStart[shell];
+	size_t n = shellStart[shell + 1] - shellStart[shell];
+	double r = layout.radius * (shell + 1) / std::max(1, layout.shells);
+
+	double y = 1.0 - 2.0 * (k + 0.5) / n;
+	double ring = sqrt(std::max(0.0, 1.0 - y * y));
+	double angle = k * layoutPi * (3.0 - sqrt(5.0)) + 2.0 * layoutPi * randomDouble(layout.seed, shell, STREAM_CLUSTER_X);
+	return glm::dvec3(ring * cos(angle), y, ring * sin(angle)) * r;
+}
+
+static glm::dvec3 latticePosition(const LayoutSettings& layout, size_t side, size_t i) {
+
+	glm::dvec3 cell((double)(i % side), (double)(i / side % side), (double)(i / (side * side)));
+	return (cell - (side - 1) * 0.5) * layout.spacing;
+}
+
+void generateLayout(Planet* planets, size_t count, const LayoutSettings& layout) {
+
+	if (layout.type == LAYOUT_POISSON_DISK) {
+		PoissonSettings poisson = layout.poisson;
+		poisson.seed = layout.seed;
+		poisson.threadCount = layout.threadCount;
+		if (poisson.tiled)
+			poissonDiskLayoutTiled(planets, count, poisson);
+		else
+			poissonDiskLayout(planets, count, poisson);
+		return;
+	}
+
+	// The amount of Planets of every shell is proportional to its area
+	std::vector<size_t> shellStart;
+	if (layout.type == LAYOUT_SHELLS) {
+		int shells = std::max(layout.shells, 1);
+		double totalArea = 0.0;
+		for (int s = 1; s <= shells; s++)
+			totalArea += (double)s * s;
+		shellStart.push_back(0);
+		for (int s = 1; s < shells; s++)
+			shellStart.push_back(std::min(count, shellStart.back() + (size_t)(count * (s * s) / totalArea)));
+		shellStart.push_back(count);
+	}
+	std::vector<glm::dvec3> centers;
+	if (layout.type == LAYOUT_CLUSTERS) {
+		for (int c = 0; c < std::max(layout.clusters, 1); c++)
+			centers.push_back(clusterCenter(layout, c));
+	}
+	size_t side = 1;
+	while (side * side * side < count)
+		side++;
+
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			glm::dvec3 position;
+			switch (layout.type) {
+			case LAYOUT_LOG_SPIRAL: position = logSpiralPosition(layout, i); break;
+			case LAYOUT_CLUSTERS: position = clusterPosition(layout, centers, i); break;
+			case LAYOUT_SHELLS: position = shellPosition(layout, shellStart, i); break;
+			case LAYOUT_LATTICE: position = latticePosition(layout, side, i); break;
+			default: position = spiralPosition(layout, i); break;
+			}
+			planets[i].xpos = position.x;
+			planets[i].ypos = position.y;
+			planets[i].zpos = position.z;
+		}
+	}, layout.threadCount);
+}
+
+const char* layoutName(LayoutType type) {
+
+	switch (type) {
+	case LAYOUT_LOG_SPIRAL: return "logarithmic spiral";
+	case LAYOUT_CLUSTERS: return "Gaussian clusters";
+	case LAYOUT_SHELLS: return "shells";
+	case LAYOUT_LATTICE: return "lattice";
+	case LAYOUT_POISSON_DISK: return "Poisson disk";
+	default: return "spiral";
+	}
+}
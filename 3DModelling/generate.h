@@ -0,0 +1,84 @@
+#ifndef generate_H
+#define generate_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "planet.h"
+#include "poisson.h"
+
+/*
+* Streams of the counter based random numbers used for the properties of the Planets, see rng.h.
+* A new property gets a new stream so the ones that already exist keep their values.
+*
+*/
+enum PlanetStream { STREAM_RED, STREAM_GREEN, STREAM_BLUE, STREAM_LAYOUT_U, STREAM_LAYOUT_V, STREAM_LAYOUT_W, STREAM_LAYOUT_S, STREAM_CLUSTER_X, STREAM_CLUSTER_Y, STREAM_CLUSTER_Z,
+	STREAM_POISSON_PICK, STREAM_POISSON_DISTANCE, STREAM_POISSON_ANGLE, STREAM_POISSON_HEIGHT, STREAM_EMISSIVE };
+
+// Random colour of every Planet, the colour of Planet i only depends on the seed and i whatever the amount of threads
+void generatePlanetColors(Planet* planets, size_t count, uint64_t seed, unsigned threadCount = 0);
+
+/* Emissive Settings
+*
+* @minimum is the emissive of the dimmest Planets, the others are uniform between it and 1
+* @starFraction is the fraction of the Planets that glow like stars with @starIntensity, which is above 1 so they bloom
+*
+*/
+struct EmissiveSettings
+{
+	float minimum = 0.3f;
+	float starFraction = 0.02f;
+	float starIntensity = 6.0f;
+};
+
+// Random emissive intensity of every Planet, like the colours it only depends on the seed and the index of the Planet
+void generatePlanetEmissive(Planet* planets, size_t count, uint64_t seed, const EmissiveSettings& settings, unsigned threadCount = 0);
+
+/*
+* Layouts that place the Planets, every position is a pure function of the seed and the index of the Planet
+* LAYOUT_SPIRAL is the original spiral of the program, cos(i) * i * spiralSize
+* LAYOUT_LOG_SPIRAL is a galaxy with logarithmic spiral arms
+* LAYOUT_CLUSTERS are balls of Planets with a Gaussian density around random centers
+* LAYOUT_SHELLS are concentric spheres with evenly spaced Planets, the amount on each shell grows with its area
+* LAYOUT_LATTICE is a cube of Planets on a regular grid
+* LAYOUT_POISSON_DISK packs the Planets without any overlap with Poisson disk sampling, see poisson.h
+*
+*/
+enum LayoutType { LAYOUT_SPIRAL, LAYOUT_LOG_SPIRAL, LAYOUT_CLUSTERS, LAYOUT_SHELLS, LAYOUT_LATTICE, LAYOUT_POISSON_DISK };
+
+/* Layout Settings
+*
+* @spiralSize is how far apart the Planets of LAYOUT_SPIRAL are
+* @radius is the size of the other layouts, the Planets stay about inside a ball of this radius
+* @arms is the amount of arms of the logarithmic spiral and @armTightness how fast they wind, r = e^(tightness * angle)
+* @armSpread is how far a Planet can be from the center of its arm, relative to its distance to the center
+* @clusters is the amount of Gaussian clusters and @clusterSize their standard deviation
+* @shells is the amount of spheres of LAYOUT_SHELLS
+* @spacing is the distance between the Planets of LAYOUT_LATTICE
+* @poisson are the settings of LAYOUT_POISSON_DISK, its seed and threads are taken from the layout
+* @threadCount is how many threads write the positions, 0 uses every core
+*
+*/
+struct LayoutSettings
+{
+	LayoutType type = LAYOUT_SPIRAL;
+	uint64_t seed = 1;
+	double spiralSize = 0.2;
+	double radius = 40.0;
+	int arms = 4;
+	double armTightness = 0.3;
+	double armSpread = 0.15;
+	int clusters = 8;
+	double clusterSize = 4.0;
+	int shells = 6;
+	double spacing = 3.0;
+	PoissonSettings poisson;
+	unsigned threadCount = 0;
+};
+
+// Writes the position of every Planet straight into the array, split over the threads (Poisson disk sampling is only parallel when tiled)
+void generateLayout(Planet* planets, size_t count, const LayoutSettings& layout);
+
+const char* layoutName(LayoutType type);
+
+#endif
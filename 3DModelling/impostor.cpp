@@ -0,0 +1,86 @@
+#include <cstddef>
+
+#include "impostor.h"
+
+static GLuint impostorVAO = 0;
+static GLuint impostorVBO = 0;
+static GLuint raycastVAO = 0;
+static GLuint raycastVBO = 0;
+
+/*
+* Both draw modes read the same SphereInstance layout, the impostors once per instance and the ray casting once per point
+*
+*/
+static void setInstanceAttributes(GLuint divisor) {
+
+	GLsizei stride = sizeof(SphereInstance);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsetof(SphereInstance, centerRadius));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsetof(SphereInstance, objectColor));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsetof(SphereInstance, lightColor));
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsetof(SphereInstance, lightPos));
+	for (GLuint attribute = 0; attribute < 4; attribute++) {
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, divisor);
+	}
+}
+
+/*
+* The quad corners come from gl_VertexID so the only buffer is the one with the instances.
+* Every attribute advances once per instance.
+*
+*/
+void initImpostors() {
+
+	glGenVertexArrays(1, &impostorVAO);
+	glGenBuffers(1, &impostorVBO);
+	glBindVertexArray(impostorVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, impostorVBO);
+	setInstanceAttributes(1);
+
+	glGenVertexArrays(1, &raycastVAO);
+	glGenBuffers(1, &raycastVBO);
+	glBindVertexArray(raycastVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, raycastVBO);
+	setInstanceAttributes(0);
+
+	glBindVertexArray(0);
+}
+
+void deleteImpostors() {
+
+	glDeleteVertexArrays(1, &impostorVAO);
+	glDeleteBuffers(1, &impostorVBO);
+	glDeleteVertexArrays(1, &raycastVAO);
+	glDeleteBuffers(1, &raycastVBO);
+	impostorVAO = impostorVBO = 0;
+	raycastVAO = raycastVBO = 0;
+}
+
+void drawImpostors(GLuint shader, const std::vector<SphereInstance>& instances) {
+
+	if (instances.empty())
+		return;
+
+	glUseProgram(shader);
+	glBindVertexArray(impostorVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, impostorVBO);
+	// Orphan the old storage every frame so the driver doesn't wait for the previous draw
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(SphereInstance), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(SphereInstance), instances.data());
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instances.size());
+	glBindVertexArray(0);
+}
+
+void drawRaycastSpheres(GLuint shader, const std::vector<SphereInstance>& instances) {
+
+	if (instances.empty())
+		return;
+
+	glUseProgram(shader);
+	glBindVertexArray(raycastVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, raycastVBO);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(SphereInstance), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(SphereInstance), instances.data());
+	glDrawArrays(GL_POINTS, 0, (GLsizei)instances.size());
+	glBindVertexArray(0);
+}
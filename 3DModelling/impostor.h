@@ -0,0 +1,34 @@
+#ifndef impostor_H
+#define impostor_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+/* Sphere instance
+*
+* Everything an impostor needs to be drawn, it has the same values drawPlanets() gives to frag.glsl as uniforms.
+* @centerRadius is the position of the Sphere in xyz and its radius in w
+*
+*/
+struct SphereInstance
+{
+	glm::vec4 centerRadius;
+	glm::vec3 objectColor;
+	glm::vec3 lightColor;
+	glm::vec3 lightPos;
+};
+
+void initImpostors();
+void deleteImpostors();
+
+// Draws every instance as a camera facing quad that is ray traced in impostor_frag.glsl, the program needs its matrices set
+void drawImpostors(GLuint shader, const std::vector<SphereInstance>& instances);
+
+// Draws every instance as a point that raycast_geom.glsl grows into its screen space bounds, it also uses impostor_frag.glsl
+void drawRaycastSpheres(GLuint shader, const std::vector<SphereInstance>& instances);
+
+#endif
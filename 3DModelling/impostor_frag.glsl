@@ -0,0 +1,51 @@
+#version 330 core
+
+#ifndef DEFERRED
+#define DEFERRED 0
+#endif
+
+layout (location = 0) out vec4 color;
+#if DEFERRED
+// The G-buffer, see deferred.h
+layout (location = 1) out vec4 gAlbedo;
+layout (location = 2) out vec4 gNormal;
+#endif
+
+in vec3 ViewRay;
+flat in vec3 SphereCenter;
+flat in float SphereRadius;
+flat in vec3 ObjectColor;
+flat in vec3 LightColor;
+flat in vec3 LightPos;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+#include "lighting.glsl"
+
+void main()
+{
+    // Ray from the camera through this pixel against the Sphere, the closest hit is the visible surface
+    vec3 rayDir = normalize(ViewRay);
+    float b = dot(rayDir, SphereCenter);
+    float c = dot(SphereCenter, SphereCenter) - SphereRadius * SphereRadius;
+    float discriminant = b * b - c;
+    if (discriminant < 0.0f)
+        discard;
+    vec3 FragPos = rayDir * (b - sqrt(discriminant));
+    vec3 Normal = (FragPos - SphereCenter) / SphereRadius;
+
+    // Write the depth of the hit so the impostors intersect the meshes and the Grid correctly
+    vec4 clipPos = projection * vec4(FragPos, 1.0f);
+    float ndcDepth = clipPos.z / clipPos.w;
+    gl_FragDepth = (gl_DepthRange.diff * ndcDepth + gl_DepthRange.near + gl_DepthRange.far) * 0.5f;
+
+    // Same Phong terms as frag.glsl, the camera is at the origin in view space
+    vec3 result = phongLighting(FragPos, Normal, normalize(-FragPos), LightPos, LightColor, ObjectColor, view, -FragPos.z);
+    color = vec4(result, 1.0f);
+#if DEFERRED
+    // The G-buffer keeps the normals in the space of FragPos of frag.glsl, the view matrix only rotates and moves
+    gAlbedo = vec4(ObjectColor, 1.0f);
+    gNormal = vec4(transpose(mat3(view)) * Normal, 0.0f);
+#endif
+}
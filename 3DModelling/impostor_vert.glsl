@@ -0,0 +1,44 @@
+#version 330 core
+layout (location = 0) in vec4 centerRadius;
+layout (location = 1) in vec3 objectColor;
+layout (location = 2) in vec3 lightColor;
+layout (location = 3) in vec3 lightPos;
+
+out vec3 ViewRay;
+flat out vec3 SphereCenter;
+flat out float SphereRadius;
+flat out vec3 ObjectColor;
+flat out vec3 LightColor;
+flat out vec3 LightPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+const vec2 corners[4] = vec2[4](vec2(-1.0f, -1.0f), vec2(1.0f, -1.0f), vec2(-1.0f, 1.0f), vec2(1.0f, 1.0f));
+
+void main()
+{
+    // Everything is done in view space where the camera is at the origin
+    vec3 center = vec3(view * model * vec4(centerRadius.xyz, 1.0f));
+    float radius = centerRadius.w;
+    float dist = length(center);
+
+    // The quad faces the camera and is as big as the silhouette cone of the Sphere where it crosses the center
+    vec3 forward = center / dist;
+    vec3 up = abs(forward.y) > 0.99f ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+    vec3 right = normalize(cross(forward, up));
+    up = cross(right, forward);
+    float halfSize = radius * dist / sqrt(max(dist * dist - radius * radius, 0.0001f));
+
+    vec2 corner = corners[gl_VertexID];
+    ViewRay = center + (right * corner.x + up * corner.y) * halfSize;
+    gl_Position = projection * vec4(ViewRay, 1.0f);
+
+    SphereCenter = center;
+    SphereRadius = radius;
+    ObjectColor = objectColor;
+    LightColor = lightColor;
+    // frag.glsl compares lightPos with the rotated FragPos directly, so only the view matrix is applied here
+    LightPos = vec3(view * vec4(lightPos, 1.0f));
+}
@@ -0,0 +1,260 @@
+// Kepler's equation M = E - e sin(E) is solved with Newton's method from the starting point of Danby "Fundamentals of Celestial Mechanics"
+
+#include <algorithm>
+#include <cmath>
+
+#include "kepler.h"
+#include "parallel.h"
+
+/*Kepler variables
+*
+* @keplerIterations is how many Newton iterations every lane does, there is no early exit so all lanes stay together.
+* The starting point converges for every eccentricity below 1, 5 iterations reach float precision up to about 0.95
+* @keplerLanePadding is the widest SIMD width, the arrays are padded to it with circular orbits of radius 0
+*
+*/
+const int keplerIterations = 5;
+const size_t keplerLanePadding = 16;
+const double keplerPi = 3.14159265358979323846;
+
+void setKeplerOrbits(KeplerOrbits& orbits, const Planet* planets, size_t count) {
+
+	orbits.bodies.clear();
+	for (size_t i = 0; i < count; i++) {
+		if (planets[i].hasOrbit)
+			orbits.bodies.push_back((unsigned)i);
+	}
+	orbits.count = orbits.bodies.size();
+	size_t padded = (orbits.count + keplerLanePadding - 1) / keplerLanePadding * keplerLanePadding;
+
+	orbits.meanMotion.assign(padded, 0.0);
+	orbits.phase.assign(padded, 0.0);
+	orbits.semiMajorAxis.assign(padded, 0.0f);
+	orbits.semiMinorAxis.assign(padded, 0.0f);
+	orbits.eccentricity.assign(padded, 0.0f);
+	orbits.periapsisCos.assign(padded, 1.0f);
+	orbits.periapsisSin.assign(padded, 0.0f);
+	orbits.x.assign(padded, 0.0f);
+	orbits.z.assign(padded, 0.0f);
+	for (size_t k = 0; k < orbits.count; k++) {
+		const OrbitalElements& orbit = planets[orbits.bodies[k]].orbit;
+		orbits.meanMotion[k] = orbit.period > 0.0 ? 2.0 * keplerPi / orbit.period : 0.0;
+		orbits.phase[k] = orbit.phase;
+		orbits.semiMajorAxis[k] = (float)orbit.semiMajorAxis;
+		orbits.semiMinorAxis[k] = (float)(orbit.semiMajorAxis * sqrt(1.0 - orbit.eccentricity * orbit.eccentricity));
+		orbits.eccentricity[k] = (float)orbit.eccentricity;
+		orbits.periapsisCos[k] = (float)cos(orbit.periapsisAngle);
+		orbits.periapsisSin[k] = (float)sin(orbit.periapsisAngle);
+	}
+}
+
+/*
+* The mean anomaly is wrapped to [-pi, pi] in double precision before it becomes a float
+*
+*/
+static inline float meanAnomaly(const KeplerOrbits& orbits, size_t k, double time) {
+
+	double M = orbits.meanMotion[k] * time + orbits.phase[k];
+	return (float)(M - 2.0 * keplerPi * floor(M / (2.0 * keplerPi) + 0.5));
+}
+
+static void keplerScalar(KeplerOrbits& orbits, size_t begin, size_t end, double time) {
+
+	const float pi = (float)keplerPi;
+	for (size_t k = begin; k < end; k++) {
+		float M = meanAnomaly(orbits, k, time);
+		float e = orbits.eccentricity[k];
+		float E = std::max(-pi, std::min(pi, M + 0.85f * e * (M < 0.0f ? -1.0f : 1.0f)));
+		for (int iteration = 0; iteration < keplerIterations; iteration++)
+			E -= (E - e * sinf(E) - M) / (1.0f - e * cosf(E));
+
+		float px = orbits.semiMajorAxis[k] * (cosf(E) - e);
+		float pz = orbits.semiMinorAxis[k] * sinf(E);
+		orbits.x[k] = px * orbits.periapsisCos[k] - pz * orbits.periapsisSin[k];
+		orbits.z[k] = px * orbits.periapsisSin[k] + pz * orbits.periapsisCos[k];
+	}
+}
+
+#if SIMD_X86
+/*
+* Sine and cosine for |x| < 3pi/2, the angle is reflected into [-pi/2, pi/2] where Taylor series up to x^11 and x^12
+* are below the float precision. The Newton iterations never leave [-pi - e, pi + e].
+*
+*/
+TARGET_AVX2 static inline void sinCosAVX2(__m256 x, __m256& s, __m256& c) {
+
+	const __m256 pi = _mm256_set1_ps((float)keplerPi);
+	const __m256 halfPi = _mm256_set1_ps((float)(keplerPi * 0.5));
+	__m256 high = _mm256_cmp_ps(x, halfPi, _CMP_GT_OQ);
+	__m256 low = _mm256_cmp_ps(x, _mm256_sub_ps(_mm256_setzero_ps(), halfPi), _CMP_LT_OQ);
+	x = _mm256_blendv_ps(x, _mm256_sub_ps(pi, x), high);
+	x = _mm256_blendv_ps(x, _mm256_sub_ps(_mm256_sub_ps(_mm256_setzero_ps(), pi), x), low);
+	__m256 cosSign = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_set1_ps(-1.0f), _mm256_or_ps(high, low));
+
+	__m256 x2 = _mm256_mul_ps(x, x);
+	__m256 sp = _mm256_set1_ps(-1.0f / 39916800.0f);
+	sp = _mm256_fmadd_ps(sp, x2, _mm256_set1_ps(1.0f / 362880.0f));
+	sp = _mm256_fmadd_ps(sp, x2, _mm256_set1_ps(-1.0f / 5040.0f));
+	sp = _mm256_fmadd_ps(sp, x2, _mm256_set1_ps(1.0f / 120.0f));
+	sp = _mm256_fmadd_ps(sp, x2, _mm256_set1_ps(-1.0f / 6.0f));
+	sp = _mm256_fmadd_ps(sp, x2, _mm256_set1_ps(1.0f));
+	s = _mm256_mul_ps(sp, x);
+
+	__m256 cp = _mm256_set1_ps(1.0f / 479001600.0f);
+	cp = _mm256_fmadd_ps(cp, x2, _mm256_set1_ps(-1.0f / 3628800.0f));
+	cp = _mm256_fmadd_ps(cp, x2, _mm256_set1_ps(1.0f / 40320.0f));
+	cp = _mm256_fmadd_ps(cp, x2, _mm256_set1_ps(-1.0f / 720.0f));
+	cp = _mm256_fmadd_ps(cp, x2, _mm256_set1_ps(1.0f / 24.0f));
+	cp = _mm256_fmadd_ps(cp, x2, _mm256_set1_ps(-0.5f));
+	cp = _mm256_fmadd_ps(cp, x2, _mm256_set1_ps(1.0f));
+	c = _mm256_mul_ps(cp, cosSign);
+}
+
+TARGET_AVX2 static inline __m256d wrapAngleAVX2(__m256d M) {
+
+	const __m256d twoPi = _mm256_set1_pd(2.0 * keplerPi);
+	__m256d turns = _mm256_round_pd(_mm256_div_pd(M, twoPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	return _mm256_fnmadd_pd(turns, twoPi, M);
+}
+
+TARGET_AVX2 static void keplerAVX2(KeplerOrbits& orbits, size_t begin, size_t end, double time) {
+
+	const __m256d t = _mm256_set1_pd(time);
+	const __m256 pi = _mm256_set1_ps((float)keplerPi);
+	const __m256 minusPi = _mm256_set1_ps((float)-keplerPi);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	for (size_t k = begin; k < end; k += 8) {
+		__m256d M0 = wrapAngleAVX2(_mm256_fmadd_pd(_mm256_loadu_pd(&orbits.meanMotion[k]), t, _mm256_loadu_pd(&orbits.phase[k])));
+		__m256d M1 = wrapAngleAVX2(_mm256_fmadd_pd(_mm256_loadu_pd(&orbits.meanMotion[k + 4]), t, _mm256_loadu_pd(&orbits.phase[k + 4])));
+		__m256 M = _mm256_set_m128(_mm256_cvtpd_ps(M1), _mm256_cvtpd_ps(M0));
+		__m256 e = _mm256_loadu_ps(&orbits.eccentricity[k]);
+
+		__m256 sign = _mm256_blendv_ps(one, _mm256_set1_ps(-1.0f), _mm256_cmp_ps(M, _mm256_setzero_ps(), _CMP_LT_OQ));
+		__m256 E = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_set1_ps(0.85f), e), sign, M);
+		E = _mm256_max_ps(minusPi, _mm256_min_ps(pi, E));
+		__m256 s, c;
+		for (int iteration = 0; iteration < keplerIterations; iteration++) {
+			sinCosAVX2(E, s, c);
+			__m256 f = _mm256_sub_ps(_mm256_fnmadd_ps(e, s, E), M);
+			__m256 derivative = _mm256_fnmadd_ps(e, c, one);
+			E = _mm256_sub_ps(E, _mm256_div_ps(f, derivative));
+		}
+		sinCosAVX2(E, s, c);
+
+		__m256 px = _mm256_mul_ps(_mm256_loadu_ps(&orbits.semiMajorAxis[k]), _mm256_sub_ps(c, e));
+		__m256 pz = _mm256_mul_ps(_mm256_loadu_ps(&orbits.semiMinorAxis[k]), s);
+		__m256 rc = _mm256_loadu_ps(&orbits.periapsisCos[k]);
+		__m256 rs = _mm256_loadu_ps(&orbits.periapsisSin[k]);
+		_mm256_storeu_ps(&orbits.x[k], _mm256_fmsub_ps(px, rc, _mm256_mul_ps(pz, rs)));
+		_mm256_storeu_ps(&orbits.z[k], _mm256_fmadd_ps(px, rs, _mm256_mul_ps(pz, rc)));
+	}
+}
+
+TARGET_AVX512 static inline void sinCosAVX512(__m512 x, __m512& s, __m512& c) {
+
+	const __m512 pi = _mm512_set1_ps((float)keplerPi);
+	const __m512 halfPi = _mm512_set1_ps((float)(keplerPi * 0.5));
+	__mmask16 high = _mm512_cmp_ps_mask(x, halfPi, _CMP_GT_OQ);
+	__mmask16 low = _mm512_cmp_ps_mask(x, _mm512_sub_ps(_mm512_setzero_ps(), halfPi), _CMP_LT_OQ);
+	x = _mm512_mask_sub_ps(x, high, pi, x);
+	x = _mm512_mask_sub_ps(x, low, _mm512_sub_ps(_mm512_setzero_ps(), pi), x);
+	__m512 cosSign = _mm512_mask_blend_ps(high | low, _mm512_set1_ps(1.0f), _mm512_set1_ps(-1.0f));
+
+	__m512 x2 = _mm512_mul_ps(x, x);
+	__m512 sp = _mm512_set1_ps(-1.0f / 39916800.0f);
+	sp = _mm512_fmadd_ps(sp, x2, _mm512_set1_ps(1.0f / 362880.0f));
+	sp = _mm512_fmadd_ps(sp, x2, _mm512_set1_ps(-1.0f / 5040.0f));
+	sp = _mm512_fmadd_ps(sp, x2, _mm512_set1_ps(1.0f / 120.0f));
+	sp = _mm512_fmadd_ps(sp, x2, _mm512_set1_ps(-1.0f / 6.0f));
+	sp = _mm512_fmadd_ps(sp, x2, _mm512_set1_ps(1.0f));
+	s = _mm512_mul_ps(sp, x);
+
+	__m512 cp = _mm512_set1_ps(1.0f / 479001600.0f);
+	cp = _mm512_fmadd_ps(cp, x2, _mm512_set1_ps(-1.0f / 3628800.0f));
+	cp = _mm512_fmadd_ps(cp, x2, _mm512_set1_ps(1.0f / 40320.0f));
+	cp = _mm512_fmadd_ps(cp, x2, _mm512_set1_ps(-1.0f / 720.0f));
+	cp = _mm512_fmadd_ps(cp, x2, _mm512_set1_ps(1.0f / 24.0f));
+	cp = _mm512_fmadd_ps(cp, x2, _mm512_set1_ps(-0.5f));
+	cp = _mm512_fmadd_ps(cp, x2, _mm512_set1_ps(1.0f));
+	c = _mm512_mul_ps(cp, cosSign);
+}
+
+TARGET_AVX512 static inline __m512d wrapAngleAVX512(__m512d M) {
+
+	const __m512d twoPi = _mm512_set1_pd(2.0 * keplerPi);
+	__m512d turns = _mm512_roundscale_pd(_mm512_div_pd(M, twoPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	return _mm512_fnmadd_pd(turns, twoPi, M);
+}
+
+TARGET_AVX512 static void keplerAVX512(KeplerOrbits& orbits, size_t begin, size_t end, double time) {
+
+	const __m512d t = _mm512_set1_pd(time);
+	const __m512 pi = _mm512_set1_ps((float)keplerPi);
+	const __m512 minusPi = _mm512_set1_ps((float)-keplerPi);
+	const __m512 one = _mm512_set1_ps(1.0f);
+	for (size_t k = begin; k < end; k += 16) {
+		__m512d M0 = wrapAngleAVX512(_mm512_fmadd_pd(_mm512_loadu_pd(&orbits.meanMotion[k]), t, _mm512_loadu_pd(&orbits.phase[k])));
+		__m512d M1 = wrapAngleAVX512(_mm512_fmadd_pd(_mm512_loadu_pd(&orbits.meanMotion[k + 8]), t, _mm512_loadu_pd(&orbits.phase[k + 8])));
+		__m512d packed = _mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(_mm512_cvtpd_ps(M0))), _mm256_castps_pd(_mm512_cvtpd_ps(M1)), 1);
+		__m512 M = _mm512_castpd_ps(packed);
+		__m512 e = _mm512_loadu_ps(&orbits.eccentricity[k]);
+
+		__m512 sign = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(M, _mm512_setzero_ps(), _CMP_LT_OQ), one, _mm512_set1_ps(-1.0f));
+		__m512 E = _mm512_fmadd_ps(_mm512_mul_ps(_mm512_set1_ps(0.85f), e), sign, M);
+		E = _mm512_max_ps(minusPi, _mm512_min_ps(pi, E));
+		__m512 s, c;
+		for (int iteration = 0; iteration < keplerIterations; iteration++) {
+			sinCosAVX512(E, s, c);
+			__m512 f = _mm512_sub_ps(_mm512_fnmadd_ps(e, s, E), M);
+			__m512 derivative = _mm512_fnmadd_ps(e, c, one);
+			E = _mm512_sub_ps(E, _mm512_div_ps(f, derivative));
+		}
+		sinCosAVX512(E, s, c);
+
+		__m512 px = _mm512_mul_ps(_mm512_loadu_ps(&orbits.semiMajorAxis[k]), _mm512_sub_ps(c, e));
+		__m512 pz = _mm512_mul_ps(_mm512_loadu_ps(&orbits.semiMinorAxis[k]), s);
+		__m512 rc = _mm512_loadu_ps(&orbits.periapsisCos[k]);
+		__m512 rs = _mm512_loadu_ps(&orbits.periapsisSin[k]);
+		_mm512_storeu_ps(&orbits.x[k], _mm512_fmsub_ps(px, rc, _mm512_mul_ps(pz, rs)));
+		_mm512_storeu_ps(&orbits.z[k], _mm512_fmadd_ps(px, rs, _mm512_mul_ps(pz, rc)));
+	}
+}
+#endif
+
+void evaluateKeplerOrbits(KeplerOrbits& orbits, double time, SimdISA isa) {
+
+	// There is no SSE kernel, a CPU without AVX2 uses the scalar one
+#if !SIMD_X86
+	isa = SIMD_SCALAR;
+#endif
+	size_t blocks = (orbits.count + keplerLanePadding - 1) / keplerLanePadding;
+	parallelFor(blocks, [&](size_t blockBegin, size_t blockEnd) {
+		size_t begin = blockBegin * keplerLanePadding;
+		size_t end = blockEnd * keplerLanePadding;
+		switch (isa) {
+#if SIMD_X86
+		case SIMD_AVX2: keplerAVX2(orbits, begin, end, time); break;
+		case SIMD_AVX512: keplerAVX512(orbits, begin, end, time); break;
+#endif
+		default: keplerScalar(orbits, begin, end, time); break;
+		}
+	}, orbits.threadCount);
+}
+
+glm::dvec2 keplerPosition(const OrbitalElements& orbit, double time) {
+
+	double meanMotion = orbit.period > 0.0 ? 2.0 * keplerPi / orbit.period : 0.0;
+	double M = meanMotion * time + orbit.phase;
+	M -= 2.0 * keplerPi * floor(M / (2.0 * keplerPi) + 0.5);
+	double e = orbit.eccentricity;
+	double E = M + 0.85 * e * (M < 0.0 ? -1.0 : 1.0);
+	for (int iteration = 0; iteration < 50; iteration++) {
+		double step = (E - e * sin(E) - M) / (1.0 - e * cos(E));
+		E -= step;
+		if (fabs(step) < 1e-15)
+			break;
+	}
+	double px = orbit.semiMajorAxis * (cos(E) - e);
+	double pz = orbit.semiMajorAxis * sqrt(1.0 - e * e) * sin(E);
+	return glm::dvec2(px * cos(orbit.periapsisAngle) - pz * sin(orbit.periapsisAngle), px * sin(orbit.periapsisAngle) + pz * cos(orbit.periapsisAngle));
+}
@@ -0,0 +1,40 @@
+#ifndef kepler_H
+#define kepler_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "planet.h"
+#include "simd.h"
+
+/* Kepler Orbits
+*
+* Structure of Arrays copy of the orbital elements of the Planets that have an orbit, ready to be evaluated in SIMD lanes.
+* @threadCount is how many threads evaluate the orbits, 0 uses every core
+* @bodies is the index of the Planet of every orbit
+* @x and @z are the positions of the last evaluation, relative to the parent of the Planet
+* The mean motion and phase stay in double precision so the mean anomaly doesn't lose precision as the time grows,
+* everything after it is in single precision.
+*
+*/
+struct KeplerOrbits
+{
+	unsigned threadCount = 0;
+	size_t count = 0;
+	std::vector<unsigned> bodies;
+	std::vector<double> meanMotion, phase;
+	std::vector<float> semiMajorAxis, semiMinorAxis, eccentricity, periapsisCos, periapsisSin;
+	std::vector<float> x, z;
+};
+
+// Copies the elements of every Planet with an orbit
+void setKeplerOrbits(KeplerOrbits& orbits, const Planet* planets, size_t count);
+
+// Positions of every orbit at a time in seconds, solving Kepler's equation with a fixed amount of Newton iterations
+void evaluateKeplerOrbits(KeplerOrbits& orbits, double time, SimdISA isa);
+
+// Position of one orbit in double precision, solved until it converges, this is the reference for the SIMD kernels
+glm::dvec2 keplerPosition(const OrbitalElements& orbit, double time);
+
+#endif
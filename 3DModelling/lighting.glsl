@@ -0,0 +1,166 @@
+// Phong lighting shared by frag.glsl and impostor_frag.glsl, the shader variants set the defines (see shadervariants.h)
+// and a shader built without them gets the look the Spheres always had
+
+#ifndef SPECULAR
+#define SPECULAR 1
+#endif
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 1
+#endif
+#ifndef CLUSTERED
+#define CLUSTERED 0
+#endif
+#ifndef SHADOWS
+#define SHADOWS 0
+#endif
+#ifndef SSAO
+#define SSAO 0
+#endif
+
+// The first light is the one of the Sphere itself, the others are shared by every Sphere
+#if LIGHT_COUNT > 1
+uniform vec3 extraLightPos[LIGHT_COUNT - 1];
+uniform vec3 extraLightColor[LIGHT_COUNT - 1];
+#endif
+
+vec3 phongLight(vec3 fragPos, vec3 norm, vec3 viewDir, vec3 lightPos, vec3 lightColor)
+{
+    // Diffuse
+    vec3 lightDir = normalize(lightPos - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 result = diff * lightColor;
+
+#if SPECULAR
+    // Specular
+    float specularStrength = 0.2f;
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    result += specularStrength * spec * lightColor;
+#endif
+    return result;
+}
+
+#if CLUSTERED
+// The lights of every cluster of the view frustum, built on the CPU every frame (see cluster.h)
+uniform usamplerBuffer clusterRanges;   //offset and count in clusterIndices of every cluster
+uniform usamplerBuffer clusterIndices;
+uniform samplerBuffer clusterLights;    //position and radius, then colour, of every light
+uniform ivec3 clusterTiles;
+uniform vec2 clusterTileSize;           //in pixels
+uniform vec2 clusterDepth;              //near plane and slices / log(far / near)
+
+vec3 clusterLighting(vec3 fragPos, vec3 norm, vec3 viewDir, float viewDepth, mat4 lightSpace)
+{
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0), clusterTiles.xy - 1);
+    int slice = clamp(int(log(viewDepth / clusterDepth.x) * clusterDepth.y), 0, clusterTiles.z - 1);
+    uvec2 range = texelFetch(clusterRanges, (slice * clusterTiles.y + tile.y) * clusterTiles.x + tile.x).xy;
+
+    vec3 result = vec3(0.0f);
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+        vec3 lightPos = vec3(lightSpace * vec4(positionRadius.xyz, 1.0f));
+        // Fades to 0 at the radius so the light can stop at the clusters its sphere touches
+        float d = length(lightPos - fragPos) / positionRadius.w;
+        float falloff = clamp(1.0f - d * d, 0.0f, 1.0f);
+        result += phongLight(fragPos, norm, viewDir, lightPos, texelFetch(clusterLights, 2 * light + 1).rgb * falloff * falloff);
+    }
+    return result;
+}
+#endif
+
+#if SHADOWS
+// The cascaded shadow maps of the directional light, drawn every frame before the Spheres (see shadow.h)
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[4];         //from fragPos to the texture coordinates and depth of every cascade
+uniform vec4 shadowSplits;              //view depth where every cascade ends
+uniform vec4 shadowBias;                //depth bias of every cascade
+uniform int shadowCascades;
+uniform float shadowTexelSize;
+uniform vec3 shadowLightDir;            //direction the light travels, in the space of fragPos
+uniform vec3 shadowLightColor;
+uniform float shadowStrength;
+
+// 1 where the light reaches the fragment, 0 in the shadow
+float shadowFactor(vec3 fragPos, float viewDepth)
+{
+    int cascade = 0;
+    while (cascade < shadowCascades && viewDepth > shadowSplits[cascade])
+        cascade++;
+    if (cascade == shadowCascades)
+        return 1.0f;
+
+    vec4 shadowPos = shadowMatrices[cascade] * vec4(fragPos, 1.0f);
+    float depth = shadowPos.z - shadowBias[cascade];
+    // 4 filtered lookups half a texel apart, every one of them already compares 2x2 texels
+    float lit = 0.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        vec2 offset = (vec2(i & 1, i >> 1) - 0.5f) * shadowTexelSize;
+        lit += texture(shadowMap, vec4(shadowPos.xy + offset, float(cascade), depth));
+    }
+    return lit * 0.25f;
+}
+#endif
+
+#if SSAO
+// The screen space ambient occlusion of the depth prepass, at the resolution of its preset (see ssao.h)
+uniform sampler2D ssaoTexture;      //the ambient light that is left and the view depth of every pixel
+uniform float ssaoScale;            //size of the occlusion over the size of the screen
+uniform float ssaoSharpness;
+
+// The 4 closest pixels of the occlusion, the bilinear weights are lowered for the ones at another depth
+float ambientOcclusion(float viewDepth)
+{
+    ivec2 size = textureSize(ssaoTexture, 0);
+    vec2 position = gl_FragCoord.xy * ssaoScale - 0.5f;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+
+    float total = 0.0f;
+    float weight = 0.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 corner = ivec2(i & 1, i >> 1);
+        vec2 texel = texelFetch(ssaoTexture, clamp(base + corner, ivec2(0), size - 1), 0).rg;
+        vec2 bilinear = mix(1.0f - f, f, vec2(corner));
+        float w = bilinear.x * bilinear.y * exp(-abs(texel.g - viewDepth) / viewDepth * ssaoSharpness);
+        total += texel.r * w;
+        weight += w;
+    }
+    // Nothing at this depth in the prepass, the Grid for example, keeps all its ambient light
+    return weight > 1e-3f ? total / weight : 1.0f;
+}
+#endif
+
+// @extraLightSpace moves the shared lights into the space of fragPos, the impostors light in view space
+// @viewDepth is the distance of the fragment in front of the camera, it picks the slice of the clusters
+vec3 phongLighting(vec3 fragPos, vec3 normal, vec3 viewDir, vec3 lightPos, vec3 lightColor, vec3 objectColor, mat4 extraLightSpace, float viewDepth)
+{
+    // Ambient
+    float ambientStrength = 0.9f;
+    vec3 ambient = ambientStrength * lightColor;
+
+    vec3 norm = normalize(normal);
+#if SSAO
+    ambient *= ambientOcclusion(viewDepth);
+#endif
+#if SHADOWS
+    float shadow = shadowFactor(fragPos, viewDepth);
+    ambient *= 1.0f - shadowStrength * (1.0f - shadow);
+#endif
+    vec3 result = ambient + phongLight(fragPos, norm, viewDir, lightPos, lightColor);
+#if SHADOWS
+    // A light far enough away that its position is only a direction
+    result += shadow * phongLight(fragPos, norm, viewDir, fragPos - shadowLightDir, shadowLightColor);
+#endif
+#if LIGHT_COUNT > 1
+    for (int i = 0; i < LIGHT_COUNT - 1; i++)
+        result += phongLight(fragPos, norm, viewDir, vec3(extraLightSpace * vec4(extraLightPos[i], 1.0f)), extraLightColor[i]);
+#endif
+#if CLUSTERED
+    result += clusterLighting(fragPos, norm, viewDir, viewDepth, extraLightSpace);
+#endif
+    return result * objectColor;
+}
@@ -2,6 +2,7 @@
 
 
 #include <iostream>
+#include <string>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -15,6 +16,26 @@
 #include <glm/gtc/constants.hpp>
 
 #include "shader.h"
+#include "planet.h"
+#include "mesh.h"
+#include "cull.h"
+#include "impostor.h"
+#include "bench.h"
+#include "nbody.h"
+#include "collision.h"
+#include "kepler.h"
+#include "scenegraph.h"
+#include "generate.h"
+#include "camerapath.h"
+#include "shaderreload.h"
+#include "shadervariants.h"
+#include "cluster.h"
+#include "deferred.h"
+#include "shadow.h"
+#include "ssao.h"
+#include "bloom.h"
+#include "oit.h"
+#include "taa.h"
 #include <corecrt_math_defines.h>
 
 
@@ -56,6 +77,12 @@ GLfloat lastFrame = 0.0f;  	// Time of last frame
 * Pressing 'Q' will increment the speed of the camera rotation
 * Pressing 'E' will decrement the speed of the camera rotation
 * 
+* Pressing 'R' will switch between drawing the Spheres with vertices and ray casting them
+* Pressing 'G' will turn the gravity between the Spheres on and off
+* Pressing 'O' will make the Spheres orbit around the center
+* Pressing 'L' will place the Spheres with the next layout
+* Pressing 'K' will add the current camera to the camera path and 'P' will play the path
+* 
 * It also supports preset you can set and save
 * Pressing 'N' will go to the next preset in the array if you are already
 * on the last preset it will just generate a new one of the same preset
@@ -63,25 +90,6 @@ GLfloat lastFrame = 0.0f;  	// Time of last frame
 * on the first preset it will just generate a new one of the same preset
 */
 
-/* Spheres Structure
-* 
-* This is the struct that is used to build all the Spheres in the program feel free to change if you need anything else
-* It holds values for the standard radius of 1.
-* The position which is changed in setPlanetsProperties()
-* The id is incremented with the new creation of each sphere
-* The RGB colour is also stored and currently set randomly in the setPlanetsProperties()
-* 
-*/ 
-struct Planet
-{
-	double radius = 1;
-	double xpos, ypos, zpos;
-	int id = 0;
-	float red;
-	float green;
-	float blue;
-};
-
 /*SpeedVariables
 * 
 * @increments is a global counter so you shouldn't change it unless you really need to.
@@ -105,10 +113,11 @@ GLfloat cameraRotationSpeed = 1;
 
 /*Lighting
 * 
-* @darkness defines how dark we want the Spheres to become as they get further away from the origin
+* @planetEmissive gives every Sphere how bright it glows, from planetEmissive.minimum to 1 and a few stars that are brighter
+* than the screen can show, see generatePlanetEmissive()
 * 
 */
-float darkness = 0.7f;
+EmissiveSettings planetEmissive;
 
 /*Grid variables
 * 
@@ -148,6 +157,8 @@ int minResolution = 2;
 * @SpiralSize is how clustered the spheres are, smaller numbers will be more clustered in the center 
 * and bigger numbers gives more spread of the Spheres.
 * Use setPlanetsProperties() if you need to change how the Spheres position are generated
+* @planetSeed picks the random colours and positions of the Spheres, the same seed always gives the same Spheres
+* @planetLayout selects how the Spheres are placed (a spiral, galaxy arms, clusters, shells, a lattice or packed without overlaps) and its sizes, see generate.h
 * 
 * This program uses GL_LINE_LOOP because its easier to visualize the Spheres being drawn
 * However it is possible to change the type of shape you want to use if you so desire.
@@ -156,6 +167,8 @@ int minResolution = 2;
 * 
 */
 float spiralSize = .2f;
+unsigned long long planetSeed = 1;
+LayoutSettings planetLayout;
 int shapeChoice = 7;
 GLenum shapes[] = { GL_LINES, // choice 0
 					GL_LINE_STRIP, // choice 1
@@ -168,6 +181,234 @@ GLenum shapes[] = { GL_LINES, // choice 0
 					GL_POLYGON // choice 8
 };
 
+/*Mesh cache
+* 
+* @useMeshCache draws the Spheres from an optimized mesh kept on the GPU instead of generating every vertex each frame.
+* This is only used for the shapes that fill the same surface as a list of triangles (GL_TRIANGLE_STRIP and GL_QUAD_STRIP),
+* the other shapes are still drawn by drawSphere() so they keep their look.
+* The mesh is built once per resolution and moved into place with the center and radius uniforms of vert.glsl
+* 
+*/
+bool useMeshCache = true;
+
+/*Meshlet culling
+* 
+* The cached Sphere is split in clusters of up to 64 vertices and each cluster is tested before drawing.
+* Clusters facing away from the camera or outside the view are not drawn.
+* @meshletCullResolution is the lowest resolution that uses the culling, with less triangles it is faster to draw everything.
+* @printCullStats prints once per second how many clusters and triangles were rejected in the last frame
+* @cullStats holds the counters of the current frame
+* 
+*/
+double meshletCullResolution = 32;
+bool printCullStats = false;
+CullStats cullStats;
+
+/*Impostors
+* 
+* Spheres that are far away cover only a few pixels, so they are drawn as a quad facing the camera instead of a mesh.
+* The quad is ray traced per pixel in impostor_frag.glsl which gives the exact outline, depth and the same lighting as frag.glsl
+* @useImpostors turns the impostors on, like the mesh cache they are only used for the shapes that fill the Sphere
+* @impostorDistance is the distance from the camera where a Sphere stops being a mesh and becomes an impostor
+* 
+*/
+bool useImpostors = true;
+float impostorDistance = 60.0f;
+
+/*Render modes
+* 
+* @renderMode selects how the Spheres are drawn, pressing 'R' switches between the modes
+* RENDER_MESH draws the Spheres with their vertices (and impostors when they are far away)
+* RENDER_RAYCAST draws every Sphere as a single point that becomes its bounding rectangle on the screen,
+* the Sphere is then solved per pixel so the cost doesn't depend on planetResolution. The shapes are ignored in this mode.
+* 
+*/
+enum RenderMode { RENDER_MESH, RENDER_RAYCAST };
+RenderMode renderMode = RENDER_MESH;
+
+/*Gravity
+* 
+* The Spheres can attract each other with an N-body simulation, pressing 'G' turns it on and off.
+* When it is turned on every Sphere gets the speed of a circular orbit so the spiral starts rotating instead of collapsing.
+* @useGravity is true while the simulation is running
+* @gravityTimeStep is the fixed step of the simulation, the frames run as many steps as fit in their deltaTime
+* @maxGravitySteps is the most steps a frame can run so a slow frame doesn't make the next ones even slower
+* @gravity holds the settings (like the Barnes-Hut opening angle) and state of the simulation, see nbody.h
+* 
+*/
+bool useGravity = false;
+double gravityTimeStep = 1.0 / 120.0;
+int maxGravitySteps = 4;
+GravitySimulation gravity;
+
+/*Orbits
+* 
+* Pressing 'O' moves the Spheres along Kepler orbits around the center, the orbits start where setPlanetsProperties() placed them.
+* @useOrbits is true while the orbits are animated, it turns the gravity off and the other way around
+* @orbitEccentricity is how long the ellipses are, 0 keeps the circles of the spiral
+* @orbitPeriod is how many seconds an orbit at a distance of 1 takes, further orbits are slower like in a solar system
+* @moonsPerPlanet turns the Spheres that follow a planet into its moons, 0 keeps every Sphere on the spiral
+* @orbits holds the elements of every orbit ready for the SIMD solver, see kepler.h
+* @orbitTime is the time of the orbits, it only runs while they are animated
+* @scene holds the transforms of the center, the planets and their moons, see scenegraph.h
+* @planetNodes is the node of every Sphere in the @scene
+* 
+*/
+bool useOrbits = false;
+float orbitEccentricity = 0.0f;
+float orbitPeriod = 2.0f;
+int moonsPerPlanet = 0;
+KeplerOrbits orbits;
+double orbitTime = 0.0;
+SceneGraph scene;
+int planetNodes[ammountPlanet];
+
+/*Collisions
+* 
+* While the gravity or the orbits move the Spheres the ones that overlap are found with a spatial hash or with sweep and prune (see collision.h).
+* @detectCollisions turns the detection on, nothing reacts to the collisions yet so it is only useful with @printCollisions
+* @printCollisions prints once per second how many candidate pairs the broad phase found and how many of them overlap
+* @collisionBroadPhase chooses how the candidate pairs are found, the grid is best when the Spheres have similar sizes
+* and sweep and prune when some Spheres are much bigger than the others
+* 
+*/
+enum BroadPhase { BROAD_PHASE_HASH, BROAD_PHASE_SWEEP };
+bool detectCollisions = true;
+bool printCollisions = false;
+BroadPhase collisionBroadPhase = BROAD_PHASE_HASH;
+SpatialHash collisionHash;
+SweepAndPrune collisionSweep;
+std::vector<CollisionPair> collisionCandidates;
+std::vector<CollisionPair> collisions;
+
+/*Camera path
+* 
+* Pressing 'K' records where the camera is and where it looks as a keyframe, @cameraKeyInterval seconds after the last one.
+* Pressing 'P' bakes the path into its table and flies through it from the start, pressing it again stops the flight.
+* @cameraPath holds the keyframes and the table, see camerapath.h
+* @playCameraPath is true while the path moves the camera, the mouse and the keys don't move it then
+* @cameraPathStep is how much the path time moves each frame, 0 follows the real time.
+* Setting it to 1 / cameraPath.sampleRate plays every entry of the table once, so a recording gives the same frames every time.
+* @cameraPathTime is the time on the path of the current frame
+* 
+*/
+CameraPath cameraPath;
+float cameraKeyInterval = 2.0f;
+bool playCameraPath = false;
+float cameraPathStep = 0.0f;
+float cameraPathTime = 0.0f;
+
+/*Shader reload
+* 
+* @hotReloadShaders rebuilds the shader programs when their .glsl files are saved, so they can be changed while the program runs.
+* A shader with an error prints it and the last program that worked keeps drawing, see shaderreload.h
+* 
+*/
+bool hotReloadShaders = true;
+
+/*Shader variants
+* 
+* @shaderSpecular adds the specular highlight to the Spheres, 'H' toggles it
+* @shaderLightCount is how many lights reach every Sphere, its own light and the lights of the first Spheres of the array.
+* 'J' cycles it from 1 to maxShaderLights, every count is its own program so the shaders loop over a constant
+* @useInstancing draws all the cached meshes with one draw call when the meshlets are not culled, 'I' toggles it
+* Every combination is built the first time it is used and kept, see shadervariants.h
+* 
+*/
+bool shaderSpecular = true;
+const int maxShaderLights = 4;
+int shaderLightCount = 1;
+bool useInstancing = true;
+ShaderVariants meshVariants;
+ShaderVariants impostorVariants;
+ShaderVariants raycastVariants;
+
+/*Clustered lighting
+* 
+* @useClusteredLights makes every Sphere a light for the others, 'F' toggles it.
+* The lights are given to the clusters of the view frustum they reach every frame and a fragment only loops over the lights of its cluster
+* @clusterLightRadius is the distance where the light of a Sphere fades out, a bigger radius puts every light in more clusters
+* @clusterLightIntensity scales the colour and the emissive of the Sphere to get the colour of its light
+* 
+*/
+bool useClusteredLights = true;
+float clusterLightRadius = 6.0f;
+float clusterLightIntensity = 0.6f;
+ClusterGrid clusterGrid;
+std::vector<ClusterLight> clusterLights;
+
+/*Deferred shading
+* 
+* @useDeferred draws the Spheres and the Grid into a G-buffer first and adds the clustered lights in one pass over the screen,
+* so the lights are only computed for the visible pixels. 'U' toggles it, see deferred.h
+* 
+*/
+bool useDeferred = false;
+Framebuffer gBuffer;
+ShaderVariants deferredVariants;
+
+/*Shadows
+* 
+* @useShadows adds a directional light whose Spheres throw shadows on each other and on the Grid, 'Y' toggles it.
+* The view frustum is cut into the cascades of @shadowCascades and the Spheres are drawn into the shadow map of every cascade
+* they reach before the frame, see shadow.h
+* @shadowMeshResolution is the resolution of the Spheres drawn into the shadow maps, the silhouette needs fewer triangles than the lighting
+* 
+*/
+bool useShadows = true;
+ShadowCascades shadowCascades;
+double shadowMeshResolution = 16;
+GLuint shadowProgram = 0;
+
+/*Ambient occlusion
+* 
+* @useSSAO darkens the ambient light where the Spheres are close to each other, 'X' toggles it and 'Z' cycles its quality preset.
+* It is optional and costs a second pass over the Spheres, so it starts off.
+* The Spheres are drawn into a depth prepass with the program of the shadows, the occlusion is computed from it and the lighting
+* shaders read it, see ssao.h. When it takes more GPU time than its budget the preset is lowered
+* @printAOCost prints once per second the GPU time of the prepass and the occlusion against the budget
+* 
+*/
+bool useSSAO = false;
+bool printAOCost = false;
+AmbientOcclusion ambientOcclusion;
+
+/*HDR
+* 
+* The frame is drawn into @sceneBuffer instead of the window, its colours are floats so the light can go above 1.
+* At the end it is tonemapped into the window with a filmic curve, see bloom.h
+* @useBloom spreads the light above the threshold of @bloom around it, 'B' toggles it
+* 
+*/
+Framebuffer sceneBuffer;
+bool useBloom = true;
+Bloom bloom;
+
+/*Translucent shells
+* 
+* @useShells draws a translucent atmosphere @shellScale times the radius of every Sphere around it.
+* 'T' turns them on and goes through the ways they are blended, weighted blended, linked lists (OpenGL 4.3) and sorted on the CPU,
+* then turns them off, see oit.h
+* @shellOpacity is the alpha of a shell where it faces the camera, it grows towards its edge
+* 
+*/
+bool useShells = true;
+float shellScale = 1.4f;
+float shellOpacity = 0.35f;
+TranslucentShells shells;
+ShaderVariants shellVariants;
+ShaderVariants shellListVariants;
+
+/*Temporal anti-aliasing
+* 
+* @useTAA moves the projection by a fraction of a pixel every frame and blends the frames over time, so the edges of the Grid,
+* the wireframes and the Spheres get many samples per pixel for the cost of one, see taa.h. '1' toggles it.
+* The culling, the clusters and the shadows keep the projection without the jitter
+* 
+*/
+bool useTAA = true;
+TemporalAA temporalAA;
+
 /*Other Variables
 * 
 * @firstMouse enables to take the value of the first location of the mouse.
@@ -218,7 +459,7 @@ void usePreset(int preset) {
 		cameraVelocity = 10.0f;
 		cameraSensitivity = 0.1f;
 
-		darkness = 0.5f;
+		planetEmissive.minimum = 0.5f;
 
 		maxLength = 80;
 		spaceWidth = 1.0f;
@@ -243,7 +484,7 @@ void usePreset(int preset) {
 		cameraVelocity = 10.0f;
 		cameraSensitivity = 0.1f;
 
-		darkness = 0.8f;
+		planetEmissive.minimum = 0.2f;
 
 		maxLength = 100;
 		spaceWidth = 1.0f;
@@ -327,6 +568,22 @@ void drawSphere(double r, double xpos, double ypos, double zpos) {
 	glPopMatrix();
 }
 
+/*
+* Updates the world transforms of the scene and moves every Sphere to the position of its node
+* 
+*/
+void updatePlanetPositions() {
+
+	updateWorldTransforms(scene);
+	for (signed int i = 0; i < ammountPlanet; i++)
+	{
+		const glm::mat4& world = worldTransform(scene, planetNodes[i]);
+		planets[i].xpos = world[3].x;
+		planets[i].ypos = world[3].y;
+		planets[i].zpos = world[3].z;
+	}
+}
+
 /*
 * This method iterates through each Sphere and sets the colour and position
 * This could be used to define what shape we are going to draw, therefore this should always be called at least once before you start drawing them
@@ -334,48 +591,448 @@ void drawSphere(double r, double xpos, double ypos, double zpos) {
 */
 void setPlanetsProperties() {
 
+	generatePlanetColors(planets, ammountPlanet, planetSeed);
+	generatePlanetEmissive(planets, ammountPlanet, planetSeed, planetEmissive);
+	planetLayout.spiralSize = spiralSize;
+	planetLayout.seed = planetSeed;
+	generateLayout(planets, ammountPlanet, planetLayout);
 	for (signed i = 1; i < ammountPlanet+1; i++)
 	{
+		// A circular orbit at the time 0 is the same point of the layout
+		OrbitalElements& orbit = planets[i-1].orbit;
+		int moon = moonsPerPlanet > 0 ? (i-1) % (moonsPerPlanet + 1) : 0;
+		planets[i-1].parent = moon > 0 ? (i-1) - moon : -1;
+		orbit.semiMajorAxis = moon > 0 ? 1.5 + moon * 1.5 : hypot(planets[i-1].xpos, planets[i-1].zpos);
+		orbit.eccentricity = orbitEccentricity;
+		orbit.period = orbitPeriod * pow(orbit.semiMajorAxis, 1.5);
+		orbit.phase = moon > 0 ? i - 1 : atan2(planets[i-1].zpos, planets[i-1].xpos);
+		orbit.periapsisAngle = 0;
+		orbit.height = moon > 0 ? 0.0 : planets[i-1].ypos;
+		planets[i-1].hasOrbit = true;
+	}
+	setKeplerOrbits(orbits, planets, ammountPlanet);
+	orbitTime = 0.0;
+
+	// Every planet hangs from the center and every moon from its planet, the orbits move them relative to their parent
+	clearSceneGraph(scene);
+	int center = addSceneNode(scene, -1, glm::mat4());
+	for (signed int i = 0; i < ammountPlanet; i++)
+	{
+		glm::dvec2 position = keplerPosition(planets[i].orbit, 0.0);
+		int parent = planets[i].parent >= 0 ? planetNodes[planets[i].parent] : center;
+		planetNodes[i] = addSceneNode(scene, parent, glm::translate(glm::mat4(), glm::vec3(position.x, planets[i].orbit.height, position.y)));
+	}
+	updatePlanetPositions();
+}
+
+/*
+* Returns true if the shape fills the Sphere the same way a list of triangles does, so the cached mesh can replace it
+* 
+*/
+bool shapeIsSurface(GLenum shape) {
+	return shape == GL_TRIANGLE_STRIP || shape == GL_QUAD_STRIP;
+}
+
+/*
+* The colour of the light for each Sphere, its emissive intensity
+* 
+*/
+glm::vec3 planetLightColor(int i) {
+	return glm::vec3(planets[i].emissive);
+}
+
+/*
+* The key of the lighting shaders for the current settings, the impostors are always instanced so they only use the other bits
+* 
+*/
+unsigned lightingVariant(bool instanced) {
+	unsigned features = (instanced ? SHADER_INSTANCED : 0) | (shaderSpecular ? SHADER_SPECULAR : 0);
+	// With deferred shading the clusters are added by the lighting pass instead
+	if (useDeferred)
+		features |= SHADER_DEFERRED;
+	else if (useClusteredLights)
+		features |= SHADER_CLUSTERED;
+	if (useShadows)
+		features |= SHADER_SHADOWS;
+	if (useSSAO)
+		features |= SHADER_SSAO;
+	return shaderVariantKey(features, shaderLightCount);
+}
+
+unsigned deferredLightingVariant() {
+	return shaderVariantKey((shaderSpecular ? SHADER_SPECULAR : 0) | (useClusteredLights ? SHADER_CLUSTERED : 0), 1);
+}
+
+/*
+* Makes a light of every Sphere and gives the lights to the clusters of this frame's frustum.
+* The lights are moved by the model rotation so they are in the same space as FragPos
+* 
+*/
+void updateClusterLights(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
+
+	static const SimdISA isa = detectSimdISA();
+	clusterLights.resize(ammountPlanet);
+	for (signed int i = 0; i < ammountPlanet; i++)
+	{
+		clusterLights[i].position = glm::vec3(model * glm::vec4((GLfloat)planets[i].xpos, (GLfloat)planets[i].ypos, (GLfloat)planets[i].zpos, 1.0f));
+		clusterLights[i].radius = clusterLightRadius;
+		clusterLights[i].color = glm::vec3(planets[i].red, planets[i].green, planets[i].blue) * (clusterLightIntensity * planets[i].emissive);
+	}
+	setClusterProjection(clusterGrid, projection);
+	buildClusters(clusterGrid, clusterLights, view, isa);
+	uploadClusters(clusterGrid, clusterLights);
+}
+
+/*
+* The centers and radii of the Spheres inside the frustum, for the passes that only need their depth
+* 
+*/
+const std::vector<SphereInstance>& planetBounds(const Frustum* frustum) {
+
+	static std::vector<SphereInstance> bounds;
+	bounds.clear();
+	for (signed int i = 0; i < ammountPlanet; i++)
+	{
+		SphereInstance instance;
+		instance.centerRadius = glm::vec4((GLfloat)planets[i].xpos, (GLfloat)planets[i].ypos, (GLfloat)planets[i].zpos, (GLfloat)planets[i].radius);
+		if (frustum == NULL || sphereInFrustum(*frustum, glm::vec3(instance.centerRadius), instance.centerRadius.w))
+			bounds.push_back(instance);
+	}
+	return bounds;
+}
+
+/*
+* Fits the cascades to this frame's frustum and draws every Sphere into the shadow maps of the cascades it reaches
+* 
+*/
+void drawShadows(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
+
+	updateShadowCascades(shadowCascades, model, view, projection);
+	drawShadowCasters(shadowCascades, shadowProgram, model, getSphereMesh(shadowMeshResolution), planetBounds(NULL));
+}
+
+/*
+* Draws the visible Spheres into the depth prepass with the program of the shadows and computes their ambient occlusion
+* 
+*/
+void drawAmbientOcclusionPass(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, const Frustum& frustum) {
+
+	beginDepthPrepass(ambientOcclusion, WIDTH, HEIGHT);
+	glm::mat4 viewProjection = projection * view;
+	glUseProgram(shadowProgram);
+	glUniformMatrix4fv(glGetUniformLocation(shadowProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+	glUniformMatrix4fv(glGetUniformLocation(shadowProgram, "lightViewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+	drawMeshInstanced(getSphereMesh(planetResolution), planetBounds(&frustum));
+	drawAmbientOcclusion(ambientOcclusion, projection);
+}
 
-		srand((unsigned int)time(NULL));
-		planets[i-1].red = (float)rand() / RAND_MAX;
-		planets[i-1].green = (float)rand() / RAND_MAX;
-		planets[i-1].blue = (float)rand() / RAND_MAX;
+/*
+* Draws the shells of the visible Spheres over the frame with one instanced call, blended the way shells.mode says
+* 
+*/
+void drawShells(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, const Frustum& frustum, const glm::vec3& viewPoint) {
 
-		planets[i-1].xpos = cos(i - 1) *(i-1)* spiralSize;
-		planets[i-1].zpos = sin(i - 1) *(i-1)* spiralSize;
+	static std::vector<SphereInstance> instances;
+	instances.clear();
+	for (signed int i = 0; i < ammountPlanet; i++)
+	{
+		glm::vec3 center((GLfloat)planets[i].xpos, (GLfloat)planets[i].ypos, (GLfloat)planets[i].zpos);
+		GLfloat radius = (GLfloat)planets[i].radius * shellScale;
+		if (!sphereInFrustum(frustum, center, radius)) {
+			continue;
+		}
+		SphereInstance instance;
+		instance.centerRadius = glm::vec4(center, radius);
+		instance.objectColor = glm::vec3(planets[i].red, planets[i].green, planets[i].blue);
+		instance.lightColor = planetLightColor(i);
+		instance.lightPos = center;
+		instances.push_back(instance);
+	}
+	if (shells.mode == OIT_SORTED) {
+		sortShellsBackToFront(instances, viewPoint);
+	}
+
+	GLuint program;
+	if (shells.mode == OIT_LINKED_LIST)
+		program = getShaderVariant(shellListVariants, shaderVariantKey(SHELL_INSTANCED, 1));
+	else
+		program = getShaderVariant(shellVariants, shaderVariantKey(SHELL_INSTANCED | (shells.mode == OIT_SORTED ? SHELL_SORTED : 0), 1));
+	beginTranslucency(shells, sceneBuffer);
+	setCameraUniforms(program, model, view, projection);
+	glUniform3f(glGetUniformLocation(program, "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+	glUniform1f(glGetUniformLocation(program, "shellOpacity"), shellOpacity);
+	glUniform1ui(glGetUniformLocation(program, "nodeCapacity"), shells.nodeCapacity);
+	drawMeshInstanced(getSphereMesh(planetResolution), instances);
+	endTranslucency(shells, sceneBuffer);
+}
+
+void reportAmbientOcclusion(GLfloat currentFrame) {
+
+	static GLfloat lastReport = 0.0f;
+	if (!useSSAO || !printAOCost || currentFrame - lastReport < 1.0f) {
+		return;
+	}
+	lastReport = currentFrame;
+	std::cout << "SSAO::COST " << ambientOcclusion.cost << " ms (" << aoQualityName(ambientOcclusion.quality) << "), budget "
+		<< ambientOcclusion.budget << " ms" << std::endl;
+}
+
+/*
+* Uploads the camera position and the lights shared by every Sphere, the program is left in use
+* 
+*/
+void setLightUniforms(GLuint shader) {
+
+	glUseProgram(shader);
+	glUniform3f(glGetUniformLocation(shader, "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+	for (int l = 0; l < shaderLightCount - 1 && l < ammountPlanet; l++) {
+		std::string index = "[" + std::to_string(l) + "]";
+		glm::vec3 color = planetLightColor(l);
+		glUniform3f(glGetUniformLocation(shader, ("extraLightPos" + index).c_str()), (GLfloat)planets[l].xpos, (GLfloat)planets[l].ypos, (GLfloat)planets[l].zpos);
+		glUniform3f(glGetUniformLocation(shader, ("extraLightColor" + index).c_str()), color.r, color.g, color.b);
 	}
 }
 
 /*
 * If the Spheres properties are defined, this method will iterate trough all of them and call the method to start drawing them
 * This includes colour and you can change to your own liking.
-* There is currently a implementation for the colour to subdue as it gets to the last Sphere in the array
-* 
+* Every Sphere glows with its own emissive intensity, see planetLightColor()
+* Spheres further than impostorDistance from the viewPoint are collected and drawn at the end with the impostorShader
+* In RENDER_RAYCAST mode all of them are collected and drawn with the raycastShader
+* With useInstancing the meshes that are drawn whole are collected too and drawn at once with the instancedShader
 * 
 */
-void drawPlanets(GLuint shader) {
+void drawPlanets(GLuint shader, GLuint instancedShader, GLuint impostorShader, GLuint raycastShader, const Frustum& frustum, const glm::vec3& viewPoint) {
+
+	if (renderMode == RENDER_RAYCAST) {
+		std::vector<SphereInstance> spheres;
+		spheres.reserve(ammountPlanet);
+		for (signed int i = 0; i < ammountPlanet; i++)
+		{
+			glm::vec3 center(planets[i].xpos, planets[i].ypos, planets[i].zpos);
+			planets[i].id = i;
+			if (!sphereInFrustum(frustum, center, (GLfloat)planets[i].radius)) {
+				continue;
+			}
+			SphereInstance instance;
+			instance.centerRadius = glm::vec4(center, (GLfloat)planets[i].radius);
+			instance.objectColor = glm::vec3(planets[i].red, planets[i].green, planets[i].blue);
+			instance.lightColor = planetLightColor(i);
+			instance.lightPos = center;
+			spheres.push_back(instance);
+		}
+		drawRaycastSpheres(raycastShader, spheres);
+		return;
+	}
 
 	glUseProgram(shader);
 	GLint objectColorLoc = glGetUniformLocation(shader, "objectColor");
 	GLint lightColorLoc = glGetUniformLocation(shader, "lightColor");
 	GLint lightPosLoc = glGetUniformLocation(shader, "lightPos");
+	GLint centerLoc = glGetUniformLocation(shader, "center");
+	GLint radiusLoc = glGetUniformLocation(shader, "radius");
+
+	bool meshPath = useMeshCache && shapeIsSurface(shapes[shapeChoice]);
+	bool meshletPath = meshPath && planetResolution >= meshletCullResolution;
+	bool instancedPath = meshPath && !meshletPath && useInstancing;
+	std::vector<GLsizei> counts;
+	std::vector<const GLvoid*> offsets;
+	cullStats = CullStats();
+	std::vector<SphereInstance> impostors;
+	std::vector<SphereInstance> instances;
+	const Mesh* sphere = NULL;
+	if (meshPath) {
+		sphere = &getSphereMesh(planetResolution);
+	}
+	else
+	{
+		glUniform3f(centerLoc, 0.0f, 0.0f, 0.0f);
+		glUniform1f(radiusLoc, 1.0f);
+	}
 
 	for (signed int i = 0; i < ammountPlanet; i++)
 	{
 		glm::vec3 lightPos(planets[i].xpos, planets[i].ypos, planets[i].zpos);
+		glm::vec3 lightColor = planetLightColor(i);
+		planets[i].id = i;
 
-		glUniform3f(objectColorLoc, planets[i].red, planets[i].green, planets[i].blue);
+		if (meshPath && useImpostors && glm::length(lightPos - viewPoint) > impostorDistance) {
+			if (sphereInFrustum(frustum, lightPos, (GLfloat)planets[i].radius)) {
+				SphereInstance instance;
+				instance.centerRadius = glm::vec4(lightPos, (GLfloat)planets[i].radius);
+				instance.objectColor = glm::vec3(planets[i].red, planets[i].green, planets[i].blue);
+				instance.lightColor = lightColor;
+				instance.lightPos = lightPos;
+				impostors.push_back(instance);
+			}
+			continue;
+		}
+
+		if (instancedPath) {
+			SphereInstance instance;
+			instance.centerRadius = glm::vec4(lightPos, (GLfloat)planets[i].radius);
+			instance.objectColor = glm::vec3(planets[i].red, planets[i].green, planets[i].blue);
+			instance.lightColor = lightColor;
+			instance.lightPos = lightPos;
+			instances.push_back(instance);
+			continue;
+		}
 
-		glUniform3f(lightColorLoc,
-			1.0f-(darkness - (darkness / (ammountPlanet/(ammountPlanet-i)))),
-			1.0f-(darkness - (darkness / (ammountPlanet / (ammountPlanet - i)))),
-			1.0f-(darkness -(darkness / (ammountPlanet / (ammountPlanet - i)))));
+		glUniform3f(objectColorLoc, planets[i].red, planets[i].green, planets[i].blue);
+		glUniform3f(lightColorLoc, lightColor.r, lightColor.g, lightColor.b);
 		glUniform3f(lightPosLoc, lightPos.x, lightPos.y, lightPos.z);
-	
 
-		drawSphere(planets[i].radius, planets[i].xpos, planets[i].ypos,planets[i].zpos);
-		planets[i].id = i;
+		if (meshPath) {
+			glUniform3f(centerLoc, (GLfloat)planets[i].xpos, (GLfloat)planets[i].ypos, (GLfloat)planets[i].zpos);
+			glUniform1f(radiusLoc, (GLfloat)planets[i].radius);
+			if (meshletPath) {
+				glm::vec3 center((GLfloat)planets[i].xpos, (GLfloat)planets[i].ypos, (GLfloat)planets[i].zpos);
+				cullMeshlets(sphere->meshlets, center, (GLfloat)planets[i].radius, viewPoint, frustum, cullStats, counts, offsets);
+				drawMeshRanges(*sphere, counts, offsets);
+			}
+			else
+			{
+				drawMesh(*sphere);
+			}
+		}
+		else
+		{
+			drawSphere(planets[i].radius, planets[i].xpos, planets[i].ypos, planets[i].zpos);
+		}
+	}
+
+	if (!instances.empty()) {
+		glUseProgram(instancedShader);
+		drawMeshInstanced(*sphere, instances);
+	}
+	drawImpostors(impostorShader, impostors);
+}
+
+/*
+* Runs the fixed steps of the gravity simulation that fit in the time of the last frame
+* 
+*/
+void updateGravity() {
+
+	static double accumulator = 0.0;
+	if (!useGravity) {
+		accumulator = 0.0;
+		return;
+	}
+	accumulator += deltaTime;
+	int steps = 0;
+	while (accumulator >= gravityTimeStep && steps < maxGravitySteps) {
+		stepGravity(gravity, planets, ammountPlanet, gravityTimeStep);
+		accumulator -= gravityTimeStep;
+		steps++;
+	}
+	if (steps == maxGravitySteps) {
+		accumulator = 0.0;
+	}
+}
+
+/*
+* Moves the Spheres to where their orbits are at the current orbit time
+* 
+*/
+void updateOrbits() {
+
+	static const SimdISA isa = detectSimdISA();
+	if (!useOrbits) {
+		return;
+	}
+	orbitTime += deltaTime;
+	evaluateKeplerOrbits(orbits, orbitTime, isa);
+	for (size_t k = 0; k < orbits.count; k++) {
+		const Planet& planet = planets[orbits.bodies[k]];
+		setLocalTransform(scene, planetNodes[orbits.bodies[k]], glm::translate(glm::mat4(), glm::vec3(orbits.x[k], planet.orbit.height, orbits.z[k])));
+	}
+	updatePlanetPositions();
+}
+
+/*
+* Gives the camera back to the mouse and the keys, the mouse keeps turning it from where the path left it
+* 
+*/
+void stopCameraPath() {
+
+	playCameraPath = false;
+	yaw = glm::degrees(atan2(cameraFront.z, cameraFront.x));
+	pitch = glm::degrees(asin(glm::clamp(cameraFront.y, -1.0f, 1.0f)));
+	cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+/*
+* Moves the camera along the baked path, at the end of the path the camera stays there and the mouse takes over again
+* 
+*/
+void updateCameraPath() {
+
+	if (!playCameraPath) {
+		return;
+	}
+	cameraPathTime += cameraPathStep > 0.0f ? cameraPathStep : deltaTime;
+	glm::vec3 position;
+	glm::quat orientation;
+	sampleCameraPath(cameraPath, cameraPath.keyframes.front().time + cameraPathTime, position, orientation);
+	cameraPos = position;
+	cameraFront = orientation * glm::vec3(0.0f, 0.0f, -1.0f);
+	cameraUp = orientation * glm::vec3(0.0f, 1.0f, 0.0f);
+	if (!cameraPath.loop && cameraPathTime >= cameraPathDuration(cameraPath)) {
+		stopCameraPath();
+	}
+}
+
+/*
+* Finds the Spheres that overlap after the gravity or the orbits moved them, the Spheres don't move without them
+* 
+*/
+void updateCollisions(GLfloat currentFrame) {
+
+	static GLfloat lastReport = 0.0f;
+	if ((!useGravity && !useOrbits) || !detectCollisions) {
+		return;
+	}
+	if (collisionBroadPhase == BROAD_PHASE_SWEEP) {
+		updateSweepAndPrune(collisionSweep, planets, ammountPlanet);
+		findSweepPairs(collisionSweep, collisionCandidates);
+	}
+	else
+	{
+		buildSpatialHash(collisionHash, planets, ammountPlanet);
+		findCandidatePairs(collisionHash, ammountPlanet, collisionCandidates);
+	}
+	findOverlaps(planets, collisionCandidates, collisions);
+
+	if (printCollisions && currentFrame - lastReport >= 1.0f) {
+		lastReport = currentFrame;
+		std::cout << "COLLISION::PAIRS " << collisionCandidates.size() << " candidates, " << collisions.size() << " overlapping" << std::endl;
+	}
+}
+
+/*
+* Prints the culling counters of the last frame, at most once per second so the console stays readable
+* 
+*/
+void reportCullStats(GLfloat currentFrame) {
+
+	static GLfloat lastReport = 0.0f;
+	if (!printCullStats || currentFrame - lastReport < 1.0f) {
+		return;
+	}
+	lastReport = currentFrame;
+	std::cout << "CULL::CLUSTERS " << cullStats.clustersTested << " tested, "
+		<< cullStats.clustersBackface << " backfacing, " << cullStats.clustersOutside << " outside"
+		<< " TRIANGLES " << cullStats.trianglesRejected << " of " << cullStats.trianglesTested << " rejected" << std::endl;
+	if (useClusteredLights) {
+		std::cout << "CULL::LIGHTS " << clusterLights.size() << " lights, " << clusterGrid.references << " in clusters, at most "
+			<< clusterGrid.maxCount << " in one, " << clusterGrid.dropped << " dropped" << std::endl;
+	}
+	if (useShadows) {
+		std::cout << "CULL::SHADOWS";
+		for (int c = 0; c < shadowCascades.cascades; c++)
+			std::cout << (c > 0 ? ", " : " ") << shadowCascades.casters[c] << " casters up to " << shadowCascades.splits[c];
+		std::cout << std::endl;
 	}
 }
 
@@ -432,15 +1089,112 @@ void decreaseRotationSpeed() {
 /*
 * This method should be called everytime you want to refresh the variables utilized for the Sphere generation presets
 * It uses the currentPreset variable to update each Spheres properties
+* The seed moves to the next one so generating the same preset again still gives new colours
+* The new positions keep the gravity running from circular orbits, like turning it on does
 *
 */
 void refreshPreset() {
+	planetSeed++;
 	usePreset(currentPreset);
 	setPlanetsProperties();
+	if (useGravity) {
+		setCircularVelocities(planets, ammountPlanet, gravity.gravityConstant);
+		gravity.accelerations.clear();
+	}
 }
 
-int main(void)
+int main(int argc, char** argv)
 {
+	// "--benchmark-render" times the tessellated and the ray casted Spheres and exits
+	// "--benchmark-gravity" times the N-body forces and exits without opening a window
+	// "--benchmark-direct-gravity" times the SIMD direct sum for every instruction set and exits
+	// "--benchmark-collisions" times the spatial hash collision detection and exits
+	// "--benchmark-sweep" times sweep and prune with and without the insertion sort and exits
+	// "--benchmark-orbits" times the Kepler solver on 1M orbits and exits
+	// "--benchmark-scene" times the world matrix updates of a 1M node scene graph and exits
+	// "--benchmark-generation" times the random Planet generation with different amounts of threads and exits
+	// "--benchmark-layouts" times every layout on 10M Planets and exits
+	// "--benchmark-poisson" times the Poisson disk sampling in 2D and 3D, checks that nothing overlaps and exits
+	// "--benchmark-camera-path" compares the baked camera path with evaluating its splines and exits
+	// "--benchmark-clusters" times giving the Planet lights to the clusters of the view frustum and exits
+	// "--benchmark-deferred" times forward against deferred shading from 1 to 10k lights and exits
+	// "--benchmark-shadows" times the shadow pass of 1 to 4 cascades against the pass that draws the Spheres and exits
+	// "--benchmark-ssao" times the ambient occlusion of every quality preset with the GPU timer and exits
+	// "--benchmark-bloom" times the tonemapping with a bloom chain of 0 to 6 levels and exits
+	// "--benchmark-oit" times the translucent shells weighted blended, in linked lists and sorted on the CPU and exits
+	// "--benchmark-taa" compares TAA with no anti-aliasing and the highest MSAA up to 8x in frame time and error against supersampling and exits
+	// "--benchmark-shaders" times building the shader programs with and without the program binary cache and exits
+	bool runRenderBenchmark = false;
+	bool runShaderBenchmark = false;
+	bool runDeferredBenchmark = false;
+	bool runShadowBenchmark = false;
+	bool runAOBenchmark = false;
+	bool runBloomBenchmark = false;
+	bool runOITBenchmark = false;
+	bool runTAABenchmark = false;
+	for (int arg = 1; arg < argc; arg++) {
+		if (std::string(argv[arg]) == "--benchmark-render")
+			runRenderBenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-shaders")
+			runShaderBenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-deferred")
+			runDeferredBenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-shadows")
+			runShadowBenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-ssao")
+			runAOBenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-bloom")
+			runBloomBenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-oit")
+			runOITBenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-taa")
+			runTAABenchmark = true;
+		if (std::string(argv[arg]) == "--benchmark-gravity") {
+			benchmarkGravity();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-direct-gravity") {
+			benchmarkDirectGravity();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-collisions") {
+			benchmarkCollisions();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-sweep") {
+			benchmarkSweepAndPrune();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-orbits") {
+			benchmarkOrbits();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-scene") {
+			benchmarkSceneGraph();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-generation") {
+			benchmarkGeneration();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-layouts") {
+			benchmarkLayouts();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-poisson") {
+			benchmarkPoisson();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-camera-path") {
+			benchmarkCameraPath();
+			return 0;
+		}
+		if (std::string(argv[arg]) == "--benchmark-clusters") {
+			benchmarkClusters();
+			return 0;
+		}
+	}
+
 	//++++create a glfw window+++++++++++++++++++++++++++++++++++++++
 	GLFWwindow* window;
 
@@ -476,7 +1230,7 @@ int main(void)
 	glewInit();
 
 	//++++Define the viewport dimensions++++++++++++++++++++++++++++
-	glViewport(0, 0, HEIGHT, HEIGHT);
+	glViewport(0, 0, WIDTH, HEIGHT);
 
 	// Setup OpenGL options
 	glEnable(GL_DEPTH_TEST);
@@ -487,8 +1241,116 @@ int main(void)
 	}
 	setPlanetsProperties();
 
+	if (runShaderBenchmark) {
+		benchmarkShaderCache();
+		glfwTerminate();
+		return 0;
+	}
+
 	//++++++++++Build and compile shader program+++++++++++++++++++++
-	GLuint shaderProgram = initShader("vert.glsl","frag.glsl");
+	// The first run compiles the programs and fills the shader cache, the next runs load them from it
+	// The variants of the current settings are started together so the driver can compile them in parallel, the others are built when used
+	double shaderStart = glfwGetTime();
+	if (hotReloadShaders) {
+		startShaderReload(window);
+	}
+	std::vector<std::string> shaderFeatures = { "INSTANCED", "SPECULAR", "CLUSTERED", "DEFERRED", "SHADOWS", "SSAO" };
+	initShaderVariants(meshVariants, "vert.glsl", NULL, "frag.glsl", shaderFeatures);
+	initShaderVariants(impostorVariants, "impostor_vert.glsl", NULL, "impostor_frag.glsl", shaderFeatures);
+	initShaderVariants(raycastVariants, "raycast_vert.glsl", "raycast_geom.glsl", "impostor_frag.glsl", shaderFeatures);
+	initShaderVariants(deferredVariants, "deferred_vert.glsl", NULL, "deferred_frag.glsl", shaderFeatures);
+	initShaderVariants(shellVariants, "vert.glsl", NULL, "shell_frag.glsl", { "INSTANCED", "SORTED" });
+	initShaderVariants(shellListVariants, "vert.glsl", NULL, "shell_list_frag.glsl", { "INSTANCED" });
+	meshVariants.hotReload = impostorVariants.hotReload = raycastVariants.hotReload = deferredVariants.hotReload = hotReloadShaders;
+	shellVariants.hotReload = shellListVariants.hotReload = hotReloadShaders;
+	precompileShaderVariants(meshVariants, { lightingVariant(false), lightingVariant(true) });
+	precompileShaderVariants(impostorVariants, { lightingVariant(false) });
+	precompileShaderVariants(raycastVariants, { lightingVariant(false) });
+	shadowProgram = initShader("shadow_vert.glsl", "shadow_frag.glsl");
+	ambientOcclusion.program = initShader("deferred_vert.glsl", "ssao_frag.glsl");
+	ambientOcclusion.blurProgram = initShader("deferred_vert.glsl", "ssao_blur_frag.glsl");
+	bloom.downProgram = initShader("deferred_vert.glsl", "bloom_down_frag.glsl");
+	bloom.upProgram = initShader("deferred_vert.glsl", "bloom_up_frag.glsl");
+	bloom.tonemapProgram = initShader("deferred_vert.glsl", "tonemap_frag.glsl");
+	shells.compositeProgram = initShader("deferred_vert.glsl", "oit_composite_frag.glsl");
+	temporalAA.program = initShader("deferred_vert.glsl", "taa_frag.glsl");
+	if (linkedListSupported()) {
+		shells.resolveProgram = initShader("deferred_vert.glsl", "oit_resolve_frag.glsl");
+	}
+	if (hotReloadShaders) {
+		watchShaderProgram(&shadowProgram, "shadow_vert.glsl", NULL, "shadow_frag.glsl");
+		watchShaderProgram(&ambientOcclusion.program, "deferred_vert.glsl", NULL, "ssao_frag.glsl");
+		watchShaderProgram(&ambientOcclusion.blurProgram, "deferred_vert.glsl", NULL, "ssao_blur_frag.glsl");
+		watchShaderProgram(&bloom.downProgram, "deferred_vert.glsl", NULL, "bloom_down_frag.glsl");
+		watchShaderProgram(&bloom.upProgram, "deferred_vert.glsl", NULL, "bloom_up_frag.glsl");
+		watchShaderProgram(&bloom.tonemapProgram, "deferred_vert.glsl", NULL, "tonemap_frag.glsl");
+		watchShaderProgram(&shells.compositeProgram, "deferred_vert.glsl", NULL, "oit_composite_frag.glsl");
+		watchShaderProgram(&temporalAA.program, "deferred_vert.glsl", NULL, "taa_frag.glsl");
+		if (linkedListSupported())
+			watchShaderProgram(&shells.resolveProgram, "deferred_vert.glsl", NULL, "oit_resolve_frag.glsl");
+	}
+	std::cout << "SHADER::STARTUP " << (glfwGetTime() - shaderStart) * 1000.0 << " ms, " << shaderCache.hits << " from the cache, "
+		<< shaderCache.misses << " compiled" << (shaderCache.misses > 0 ? " (cold)" : " (warm)") << std::endl;
+	initImpostors();
+
+	if (runRenderBenchmark || runDeferredBenchmark || runShadowBenchmark || runAOBenchmark || runBloomBenchmark || runOITBenchmark || runTAABenchmark) {
+		if (runTAABenchmark) {
+			benchmarkTemporalAA(window, getShaderVariant(meshVariants, shaderVariantKey(SHADER_SPECULAR, 1)), temporalAA);
+		}
+		else if (runOITBenchmark) {
+			GLuint weightedShader = getShaderVariant(shellVariants, shaderVariantKey(SHELL_INSTANCED, 1));
+			GLuint sortedShader = getShaderVariant(shellVariants, shaderVariantKey(SHELL_INSTANCED | SHELL_SORTED, 1));
+			GLuint listShader = linkedListSupported() ? getShaderVariant(shellListVariants, shaderVariantKey(SHELL_INSTANCED, 1)) : 0;
+			benchmarkTranslucency(window, weightedShader, sortedShader, listShader, shells);
+		}
+		else if (runBloomBenchmark) {
+			benchmarkBloom(window, bloom);
+		}
+		else if (runAOBenchmark) {
+			benchmarkAmbientOcclusion(window, shadowProgram, ambientOcclusion);
+		}
+		else if (runShadowBenchmark) {
+			GLuint sceneShader = getShaderVariant(meshVariants, shaderVariantKey(SHADER_INSTANCED | SHADER_SPECULAR, 1));
+			GLuint shadowedShader = getShaderVariant(meshVariants, shaderVariantKey(SHADER_INSTANCED | SHADER_SPECULAR | SHADER_SHADOWS, 1));
+			benchmarkShadows(window, shadowProgram, sceneShader, shadowedShader);
+		}
+		else if (runDeferredBenchmark) {
+			GLuint forwardShader = getShaderVariant(meshVariants, shaderVariantKey(SHADER_INSTANCED | SHADER_SPECULAR | SHADER_CLUSTERED, 1));
+			GLuint geometryShader = getShaderVariant(meshVariants, shaderVariantKey(SHADER_INSTANCED | SHADER_SPECULAR | SHADER_DEFERRED, 1));
+			GLuint lightingShader = getShaderVariant(deferredVariants, shaderVariantKey(SHADER_SPECULAR | SHADER_CLUSTERED, 1));
+			benchmarkDeferredShading(window, forwardShader, geometryShader, lightingShader);
+		}
+		else
+		{
+			// The Spheres are drawn with the shaders they always had, one light and the specular highlight
+			unsigned plainKey = shaderVariantKey(SHADER_SPECULAR, 1);
+			benchmarkSphereRendering(window, getShaderVariant(meshVariants, plainKey), getShaderVariant(raycastVariants, plainKey));
+		}
+		stopShaderReload();
+		deleteShaderVariants(meshVariants);
+		deleteShaderVariants(impostorVariants);
+		deleteShaderVariants(raycastVariants);
+		deleteShaderVariants(deferredVariants);
+		glDeleteProgram(shadowProgram);
+		glDeleteProgram(ambientOcclusion.program);
+		glDeleteProgram(ambientOcclusion.blurProgram);
+		deleteAmbientOcclusion(ambientOcclusion);
+		glDeleteProgram(bloom.downProgram);
+		glDeleteProgram(bloom.upProgram);
+		glDeleteProgram(bloom.tonemapProgram);
+		deleteBloom(bloom);
+		deleteShaderVariants(shellVariants);
+		deleteShaderVariants(shellListVariants);
+		glDeleteProgram(shells.compositeProgram);
+		glDeleteProgram(shells.resolveProgram);
+		deleteTranslucentShells(shells);
+		glDeleteProgram(temporalAA.program);
+		deleteTemporalAA(temporalAA);
+		clearMeshCache();
+		deleteImpostors();
+		glfwTerminate();
+		return 0;
+	}
 
 	glm::vec3 lightPos(0.0f, 0.0f, 1.0f);
 
@@ -502,25 +1364,37 @@ int main(void)
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// A shader that finished building replaces the old one before anything is drawn with it
+		updateShaderReload();
+
+		// The camera is moved first so the matrices used to draw and cull this frame are the same
+		do_movement();
+		takeInput();
+		updateGravity();
+		updateOrbits();
+		updateCollisions(currentFrame);
+		updateCameraPath();
+
+		// Changing the settings only picks another program, it is compiled the first time it is picked
+		GLuint shaderProgram = getShaderVariant(meshVariants, lightingVariant(false));
+		GLuint instancedProgram = useInstancing ? getShaderVariant(meshVariants, lightingVariant(true)) : 0;
+		GLuint impostorProgram = getShaderVariant(impostorVariants, lightingVariant(false));
+		GLuint raycastProgram = getShaderVariant(raycastVariants, lightingVariant(false));
 
 		glUseProgram(shaderProgram);
 		GLint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
 		GLint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
 		GLint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos");
 		GLint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
+		GLint centerLoc = glGetUniformLocation(shaderProgram, "center");
+		GLint radiusLoc = glGetUniformLocation(shaderProgram, "radius");
 
 		glUniform3f(objectColorLoc, 1.0f, 1.0f, 1.0f);
 		glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
 		glUniform3f(lightPosLoc, lightPos.x, lightPos.y, lightPos.z);
 		glUniform3f(viewPosLoc, cameraPos.x, cameraPos.y, cameraPos.z);
-
-		glLoadIdentity();
-		drawGrid();
-		drawPlanets(shaderProgram);
-		do_movement();
-		takeInput();
+		glUniform3f(centerLoc, 0.0f, 0.0f, 0.0f);
+		glUniform1f(radiusLoc, 1.0f);
 
 		glm::mat4 model;
 		glm::mat4 view;
@@ -531,19 +1405,125 @@ int main(void)
 
 		view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 		projection = glm::perspective(45.0f, (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 100.0f);
+		// Everything that is drawn into the frame or reads its depth uses the jittered projection
+		glm::mat4 drawProjection = useTAA ? jitterProjection(temporalAA, projection, WIDTH, HEIGHT) : projection;
+
+		// The Spheres are culled before the model rotation, so the camera is moved into that space instead
+		Frustum frustum = extractFrustum(projection * view * model);
+		glm::vec3 viewPoint = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+
+		// The shadow maps and the ambient occlusion are drawn first, they bind their own framebuffers
+		if (useShadows) {
+			drawShadows(model, view, projection);
+			bindShadows(shadowCascades, raycastProgram, glm::inverse(view));
+			bindShadows(shadowCascades, impostorProgram, glm::inverse(view));
+			bindShadows(shadowCascades, shaderProgram, glm::mat4());
+			if (useInstancing)
+				bindShadows(shadowCascades, instancedProgram, glm::mat4());
+		}
+		if (useSSAO) {
+			drawAmbientOcclusionPass(model, view, drawProjection, frustum);
+			bindAmbientOcclusion(ambientOcclusion, raycastProgram);
+			bindAmbientOcclusion(ambientOcclusion, impostorProgram);
+			bindAmbientOcclusion(ambientOcclusion, shaderProgram);
+			if (useInstancing)
+				bindAmbientOcclusion(ambientOcclusion, instancedProgram);
+		}
 
-		GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-		GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-		GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-		glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+		glm::vec3 background(0.2f, 0.3f, 0.3f);
+		resizeFramebuffer(sceneBuffer, WIDTH, HEIGHT, { GL_RGBA16F }, true);
+		if (useDeferred) {
+			beginGBuffer(gBuffer, WIDTH, HEIGHT, background);
+		}
+		else
+		{
+			bindFramebuffer(sceneBuffer);
+			glClearColor(background.r, background.g, background.b, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
+
+		setCameraUniforms(raycastProgram, model, view, drawProjection);
+		setCameraUniforms(impostorProgram, model, view, drawProjection);
+		setCameraUniforms(shaderProgram, model, view, drawProjection);
+		setLightUniforms(raycastProgram);
+		setLightUniforms(impostorProgram);
+		setLightUniforms(shaderProgram);
+		if (useInstancing) {
+			setCameraUniforms(instancedProgram, model, view, drawProjection);
+			setLightUniforms(instancedProgram);
+		}
+		GLuint deferredProgram = useDeferred ? getShaderVariant(deferredVariants, deferredLightingVariant()) : 0;
+		if (useClusteredLights && useDeferred) {
+			updateClusterLights(model, view, projection);
+			bindClusters(clusterGrid, deferredProgram, WIDTH, HEIGHT);
+		}
+		else if (useClusteredLights) {
+			updateClusterLights(model, view, projection);
+			bindClusters(clusterGrid, raycastProgram, WIDTH, HEIGHT);
+			bindClusters(clusterGrid, impostorProgram, WIDTH, HEIGHT);
+			bindClusters(clusterGrid, shaderProgram, WIDTH, HEIGHT);
+			if (useInstancing)
+				bindClusters(clusterGrid, instancedProgram, WIDTH, HEIGHT);
+		}
+
+		// The Grid is drawn with the uniforms of the plain mesh program, the other programs were bound after it
+		glUseProgram(shaderProgram);
+		glLoadIdentity();
+		drawGrid();
+		drawPlanets(shaderProgram, instancedProgram, impostorProgram, raycastProgram, frustum, viewPoint);
+		if (useDeferred) {
+			bindFramebuffer(sceneBuffer);
+			drawDeferredLighting(gBuffer, deferredProgram, view, drawProjection, cameraPos);
+			// The shells are tested against the depth of the Spheres
+			copyDepth(gBuffer, sceneBuffer);
+		}
+		if (useShells) {
+			drawShells(model, view, drawProjection, frustum, viewPoint);
+		}
+		// The bloom and the tonemapping read the frame after it was blended with its history
+		const Framebuffer* frame = &sceneBuffer;
+		if (useTAA) {
+			frame = &resolveTemporalAA(temporalAA, sceneBuffer, model, projection * view);
+		}
+		if (useBloom) {
+			drawBloom(bloom, *frame);
+		}
+		drawTonemap(bloom, *frame, useBloom, WIDTH, HEIGHT);
+		reportCullStats(currentFrame);
+		reportAmbientOcclusion(currentFrame);
 
 		glfwSwapBuffers(window);
 
 		glfwPollEvents();
 	}
 
+	stopShaderReload();
+	deleteShaderVariants(meshVariants);
+	deleteShaderVariants(impostorVariants);
+	deleteShaderVariants(raycastVariants);
+	deleteShaderVariants(deferredVariants);
+	deleteClusters(clusterGrid);
+	deleteFramebuffer(gBuffer);
+	deleteShadowCascades(shadowCascades);
+	glDeleteProgram(shadowProgram);
+	deleteAmbientOcclusion(ambientOcclusion);
+	glDeleteProgram(ambientOcclusion.program);
+	glDeleteProgram(ambientOcclusion.blurProgram);
+	deleteFramebuffer(sceneBuffer);
+	deleteBloom(bloom);
+	glDeleteProgram(bloom.downProgram);
+	glDeleteProgram(bloom.upProgram);
+	glDeleteProgram(bloom.tonemapProgram);
+	deleteShaderVariants(shellVariants);
+	deleteShaderVariants(shellListVariants);
+	glDeleteProgram(shells.compositeProgram);
+	glDeleteProgram(shells.resolveProgram);
+	deleteTranslucentShells(shells);
+	glDeleteProgram(temporalAA.program);
+	deleteTemporalAA(temporalAA);
+	deleteFullscreenTriangle();
+	clearMeshCache();
+	deleteImpostors();
 	glfwTerminate();
 	return 0;
 }
@@ -557,6 +1537,103 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
+	// Switching modes happens once per press instead of every frame the key is held
+	if (key == GLFW_KEY_R && action == GLFW_PRESS)
+		renderMode = renderMode == RENDER_MESH ? RENDER_RAYCAST : RENDER_MESH;
+	if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+		useGravity = !useGravity;
+		if (useGravity) {
+			useOrbits = false;
+			setCircularVelocities(planets, ammountPlanet, gravity.gravityConstant);
+			gravity.accelerations.clear();
+		}
+	}
+	if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+		useOrbits = !useOrbits;
+		if (useOrbits)
+			useGravity = false;
+	}
+	if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+		planetLayout.type = (LayoutType)((planetLayout.type + 1) % (LAYOUT_POISSON_DISK + 1));
+		std::cout << "LAYOUT::" << layoutName(planetLayout.type) << std::endl;
+		useGravity = false;
+		setPlanetsProperties();
+	}
+	if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+		shaderSpecular = !shaderSpecular;
+		std::cout << "SHADER::SPECULAR " << (shaderSpecular ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_J && action == GLFW_PRESS) {
+		shaderLightCount = shaderLightCount % maxShaderLights + 1;
+		std::cout << "SHADER::LIGHTS " << shaderLightCount << std::endl;
+	}
+	if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+		useClusteredLights = !useClusteredLights;
+		std::cout << "SHADER::CLUSTERED_LIGHTS " << (useClusteredLights ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_U && action == GLFW_PRESS) {
+		useDeferred = !useDeferred;
+		std::cout << "SHADER::" << (useDeferred ? "DEFERRED" : "FORWARD") << std::endl;
+	}
+	if (key == GLFW_KEY_Y && action == GLFW_PRESS) {
+		useShadows = !useShadows;
+		std::cout << "SHADER::SHADOWS " << (useShadows ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_X && action == GLFW_PRESS) {
+		useSSAO = !useSSAO;
+		std::cout << "SHADER::SSAO " << (useSSAO ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+		ambientOcclusion.quality = (AOQuality)((ambientOcclusion.quality + 1) % (AO_HIGH + 1));
+		std::cout << "SSAO::QUALITY " << aoQualityName(ambientOcclusion.quality) << std::endl;
+	}
+	if (key == GLFW_KEY_B && action == GLFW_PRESS) {
+		useBloom = !useBloom;
+		std::cout << "SHADER::BLOOM " << (useBloom ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+		if (!useShells) {
+			useShells = true;
+			shells.mode = OIT_WEIGHTED;
+		}
+		else if (shells.mode == OIT_SORTED)
+		{
+			useShells = false;
+		}
+		else
+		{
+			shells.mode = (OITMode)(shells.mode + 1);
+			if (shells.mode == OIT_LINKED_LIST && !linkedListSupported())
+				shells.mode = OIT_SORTED;
+		}
+		std::cout << "SHADER::SHELLS " << (useShells ? oitModeName(shells.mode) : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_1 && action == GLFW_PRESS) {
+		useTAA = !useTAA;
+		// The history of before it was turned off would smear over the first frames
+		resetTemporalAA(temporalAA);
+		std::cout << "SHADER::TAA " << (useTAA ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+		useInstancing = !useInstancing;
+		std::cout << "SHADER::INSTANCING " << (useInstancing ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_K && action == GLFW_PRESS) {
+		float time = cameraPath.keyframes.empty() ? 0.0f : cameraPath.keyframes.back().time + cameraKeyInterval;
+		addCameraKeyframe(cameraPath, time, cameraPos, cameraFront, cameraUp);
+		std::cout << "CAMERA::KEYFRAME " << cameraPath.keyframes.size() << " at " << time << "s" << std::endl;
+	}
+	if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+		if (playCameraPath) {
+			stopCameraPath();
+		}
+		else if (!cameraPath.keyframes.empty())
+		{
+			bakeCameraPath(cameraPath);
+			cameraPathTime = 0.0f;
+			playCameraPath = true;
+		}
+	}
 	if (key >= 0 && key < 1024)
 	{
 		if (action == GLFW_PRESS)
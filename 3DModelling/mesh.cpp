@@ -0,0 +1,280 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstddef>
+#include <list>
+
+#include <glm/gtc/packing.hpp>
+
+#include "mesh.h"
+#include "meshopt.h"
+#include <corecrt_math_defines.h>
+
+/*Mesh cache variables
+*
+* @meshCacheCapacity is how many Sphere resolutions are kept on the GPU, the least recently used one is deleted first
+* Holding 'C' or 'V' creates a new resolution every frame so this should be small.
+* @simulatedCacheSize is the size of the FIFO post-transform cache used to measure the ACMR/ATVR, 16 is common on hardware
+* @reportMeshStats prints the cache statistics of every mesh that enters the cache, it is off since holding 'C' or 'V' would
+* print every frame
+* @sortMeshOverdraw also sorts the triangles to reduce overdraw, it is mostly useful for meshes that are not convex
+* @compactSphereVertices stores each vertex of the Sphere as one 32 bit GL_INT_2_10_10_10_REV direction instead of 6 floats.
+* This is 6 times less vertex memory, the direction has an error of about 0.002 which can't be seen at the Sphere sizes we use.
+*
+*/
+const int meshCacheCapacity = 8;
+int simulatedCacheSize = 16;
+bool reportMeshStats = false;
+bool sortMeshOverdraw = false;
+bool compactSphereVertices = true;
+
+struct MeshCacheEntry
+{
+	double resolution;
+	unsigned long lastUsed;
+	Mesh mesh;
+};
+
+// A list so the meshes never move, a reference from getSphereMesh() stays valid until its entry is evicted
+static std::list<MeshCacheEntry> meshCache;
+static unsigned long meshCacheClock = 0;
+static GLuint instanceVBO = 0;
+
+/*
+* The Sphere is generated as a grid of latitude rows and longitude columns where each vertex is stored only once.
+* Row r is the latitude used by drawSphere() for i = r - 1, so every band between two rows is the same strip drawSphere() draws,
+* which keeps the fractional resolutions looking the same as the immediate mode version.
+*
+*/
+Mesh buildSphereMesh(double resolution) {
+
+	Mesh mesh;
+	if (resolution <= 0)
+		return mesh;
+	int steps = (int)floor(resolution);
+
+	int rows = steps + 2;
+	int columns = steps + 1;
+	mesh.positions.reserve(rows * columns);
+	for (int r = 0; r < rows; r++) {
+		double lat = M_PI * (-0.5 + (double)(r - 1) / resolution);
+		double z = sin(lat);
+		double zr = cos(lat);
+		for (int j = 0; j < columns; j++) {
+			double lng = 2 * M_PI * (double)(j - 1) / resolution;
+			mesh.positions.push_back(glm::vec3(cos(lng) * zr, sin(lng) * zr, z));
+		}
+	}
+	mesh.normals = mesh.positions;
+
+	// Every quad of the strip becomes two triangles with the same winding the strip would have given
+	mesh.indices.reserve((rows - 1) * (columns - 1) * 6);
+	for (int r = 0; r < rows - 1; r++) {
+		for (int j = 0; j < columns - 1; j++) {
+			GLuint a = r * columns + j;
+			GLuint b = (r + 1) * columns + j;
+			GLuint c = a + 1;
+			GLuint d = b + 1;
+			mesh.indices.push_back(a);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(c);
+			mesh.indices.push_back(c);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(d);
+		}
+	}
+	return mesh;
+}
+
+void optimizeMesh(Mesh& mesh, bool sortOverdraw) {
+
+	size_t vertexCount = mesh.positions.size();
+	VertexCacheStats before = simulateVertexCache(mesh.indices, vertexCount, simulatedCacheSize);
+
+	optimizeVertexCache(mesh.indices, vertexCount);
+	if (sortOverdraw) {
+		optimizeOverdraw(mesh.indices, mesh.positions, simulatedCacheSize);
+	}
+	std::vector<GLuint> remap = optimizeVertexFetch(mesh.indices, vertexCount);
+
+	std::vector<glm::vec3> positions(vertexCount);
+	std::vector<glm::vec3> normals(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		positions[remap[v]] = mesh.positions[v];
+		normals[remap[v]] = mesh.normals[v];
+	}
+	mesh.positions.swap(positions);
+	mesh.normals.swap(normals);
+
+	VertexCacheStats after = simulateVertexCache(mesh.indices, vertexCount, simulatedCacheSize);
+	if (reportMeshStats) {
+		std::cout << std::fixed << std::setprecision(3)
+			<< "MESH::OPTIMIZED " << vertexCount << " vertices, " << mesh.indices.size() / 3 << " triangles"
+			<< " ACMR " << before.acmr << " -> " << after.acmr
+			<< " ATVR " << before.atvr << " -> " << after.atvr
+			<< " (FIFO " << simulatedCacheSize << ")" << std::endl;
+	}
+}
+
+/*
+* The positions and normals are interleaved in one buffer, position goes to location 0 and normal to location 1 like in vert.glsl
+* The compact format packs the direction with glm::packSnorm3x10_1x2() which has the same bit layout as GL_INT_2_10_10_10_REV.
+* Both attributes then read the same 4 bytes, and vert.glsl still places the vertex with radius * position + center.
+*
+*/
+void uploadMesh(Mesh& mesh, bool compact) {
+
+	std::vector<GLfloat> vertices;
+	std::vector<glm::uint32> packedVertices;
+	if (compact) {
+		packedVertices.reserve(mesh.normals.size());
+		for (size_t v = 0; v < mesh.normals.size(); v++) {
+			packedVertices.push_back(glm::packSnorm3x10_1x2(glm::vec4(mesh.normals[v], 0.0f)));
+		}
+		mesh.vertexBytes = packedVertices.size() * sizeof(glm::uint32);
+	}
+	else
+	{
+		vertices.reserve(mesh.positions.size() * 6);
+		for (size_t v = 0; v < mesh.positions.size(); v++) {
+			vertices.push_back(mesh.positions[v].x);
+			vertices.push_back(mesh.positions[v].y);
+			vertices.push_back(mesh.positions[v].z);
+			vertices.push_back(mesh.normals[v].x);
+			vertices.push_back(mesh.normals[v].y);
+			vertices.push_back(mesh.normals[v].z);
+		}
+		mesh.vertexBytes = vertices.size() * sizeof(GLfloat);
+	}
+
+	glGenVertexArrays(1, &mesh.vao);
+	glGenBuffers(1, &mesh.vbo);
+	glGenBuffers(1, &mesh.ebo);
+
+	glBindVertexArray(mesh.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+	if (compact) {
+		glBufferData(GL_ARRAY_BUFFER, mesh.vertexBytes, packedVertices.data(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, mesh.vertexBytes, vertices.data(), GL_STATIC_DRAW);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(GLuint), mesh.indices.data(), GL_STATIC_DRAW);
+
+	if (compact) {
+		glVertexAttribPointer(0, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(glm::uint32), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(glm::uint32), (GLvoid*)0);
+		glEnableVertexAttribArray(1);
+	}
+	else
+	{
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(1);
+	}
+
+	// Unbind so the immediate mode drawing in drawGrid() is not recorded in this VAO
+	glBindVertexArray(0);
+
+	if (reportMeshStats) {
+		std::cout << "MESH::UPLOADED " << mesh.vertexBytes << " vertex bytes ("
+			<< (compact ? "packed 2_10_10_10" : "float position and normal") << ")" << std::endl;
+	}
+}
+
+void deleteMesh(Mesh& mesh) {
+
+	glDeleteVertexArrays(1, &mesh.vao);
+	glDeleteBuffers(1, &mesh.vbo);
+	glDeleteBuffers(1, &mesh.ebo);
+	mesh.vao = mesh.vbo = mesh.ebo = 0;
+}
+
+void drawMesh(const Mesh& mesh) {
+
+	glBindVertexArray(mesh.vao);
+	glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0);
+	glBindVertexArray(0);
+}
+
+void drawMeshRanges(const Mesh& mesh, const std::vector<GLsizei>& counts, const std::vector<const GLvoid*>& offsets) {
+
+	if (counts.empty())
+		return;
+	glBindVertexArray(mesh.vao);
+	glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), (GLsizei)counts.size());
+	glBindVertexArray(0);
+}
+
+/*
+* The instances go to locations 2 to 4 of the mesh VAO with a divisor of 1, the plain shaders don't read them.
+* The attributes are set again on every call because the cached meshes come and go.
+*
+*/
+void drawMeshInstanced(const Mesh& mesh, const std::vector<SphereInstance>& instances) {
+
+	if (instances.empty())
+		return;
+	if (instanceVBO == 0)
+		glGenBuffers(1, &instanceVBO);
+
+	glBindVertexArray(mesh.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	// Orphan the old storage every frame so the driver doesn't wait for the previous draw
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(SphereInstance), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(SphereInstance), instances.data());
+	GLsizei stride = sizeof(SphereInstance);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsetof(SphereInstance, centerRadius));
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsetof(SphereInstance, objectColor));
+	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offsetof(SphereInstance, lightColor));
+	for (GLuint attribute = 2; attribute < 5; attribute++) {
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1);
+	}
+	glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0, (GLsizei)instances.size());
+	glBindVertexArray(0);
+}
+
+const Mesh& getSphereMesh(double resolution) {
+
+	meshCacheClock++;
+	for (std::list<MeshCacheEntry>::iterator e = meshCache.begin(); e != meshCache.end(); ++e) {
+		if (e->resolution == resolution) {
+			e->lastUsed = meshCacheClock;
+			return e->mesh;
+		}
+	}
+
+	if (meshCache.size() >= (size_t)meshCacheCapacity) {
+		std::list<MeshCacheEntry>::iterator oldest = meshCache.begin();
+		for (std::list<MeshCacheEntry>::iterator e = meshCache.begin(); e != meshCache.end(); ++e) {
+			if (e->lastUsed < oldest->lastUsed)
+				oldest = e;
+		}
+		deleteMesh(oldest->mesh);
+		meshCache.erase(oldest);
+	}
+
+	meshCache.push_back(MeshCacheEntry());
+	MeshCacheEntry& entry = meshCache.back();
+	entry.resolution = resolution;
+	entry.lastUsed = meshCacheClock;
+	entry.mesh = buildSphereMesh(resolution);
+	optimizeMesh(entry.mesh, sortMeshOverdraw);
+	entry.mesh.meshlets = buildMeshlets(entry.mesh.indices, entry.mesh.positions, entry.mesh.normals);
+	uploadMesh(entry.mesh, compactSphereVertices);
+	return entry.mesh;
+}
+
+void clearMeshCache() {
+
+	for (std::list<MeshCacheEntry>::iterator e = meshCache.begin(); e != meshCache.end(); ++e)
+		deleteMesh(e->mesh);
+	meshCache.clear();
+	glDeleteBuffers(1, &instanceVBO);
+	instanceVBO = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef mesh_H
+#define mesh_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "meshlet.h"
+#include "impostor.h"
+
+/* Mesh Structure
+*
+* A mesh is stored once as an indexed triangle list and uploaded to the GPU, it can then be drawn as many times as needed.
+* @positions and @normals hold one entry for every unique vertex, for the unit Sphere both are the same direction
+* @indices hold three vertices for each triangle
+* @vao, @vbo and @ebo are the OpenGL objects created by uploadMesh()
+* @vertexBytes is the size of the vertex buffer on the GPU, it depends on the format chosen in uploadMesh()
+* @meshlets are the clusters of the final triangle order, each one is a range of @indices
+*
+*/
+struct Mesh
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<GLuint> indices;
+	GLuint vao = 0;
+	GLuint vbo = 0;
+	GLuint ebo = 0;
+	size_t vertexBytes = 0;
+	std::vector<Meshlet> meshlets;
+};
+
+// Builds the unit Sphere with the same latitudes and longitudes drawSphere() generates for the given resolution
+Mesh buildSphereMesh(double resolution);
+
+// Runs the vertex cache, overdraw and vertex fetch optimizations and reports the ACMR/ATVR before and after
+void optimizeMesh(Mesh& mesh, bool sortOverdraw);
+
+// A compact mesh stores only a packed direction per vertex, this is only valid for the unit Sphere where position equals normal
+void uploadMesh(Mesh& mesh, bool compact);
+void deleteMesh(Mesh& mesh);
+void drawMesh(const Mesh& mesh);
+// Draws only the index ranges given, these usually come from cullMeshlets()
+void drawMeshRanges(const Mesh& mesh, const std::vector<GLsizei>& counts, const std::vector<const GLvoid*>& offsets);
+// Draws the mesh once for every instance in one call, the program has to be a variant built with INSTANCED (see shadervariants.h)
+void drawMeshInstanced(const Mesh& mesh, const std::vector<SphereInstance>& instances);
+
+// Returns the cached unit Sphere for this resolution, it is built, optimized and uploaded only the first time.
+// The reference stays valid until the resolution is evicted, when the cache is full and it is the least recently used
+const Mesh& getSphereMesh(double resolution);
+void clearMeshCache();
+
+#endif
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cmath>
+
+#include "meshlet.h"
+
+/*
+* Computes the bounding Sphere and the normal cone of the triangles in [first, first + count)
+* The face normals are flipped to agree with the vertex normals so the cone doesn't depend on the winding of the strips.
+*
+*/
+static void computeMeshletBounds(Meshlet& meshlet, const std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals) {
+
+	size_t first = meshlet.indexOffset;
+	size_t last = first + meshlet.triangleCount * 3;
+
+	glm::vec3 minimum = positions[indices[first]];
+	glm::vec3 maximum = minimum;
+	for (size_t i = first; i < last; i++) {
+		minimum = glm::min(minimum, positions[indices[i]]);
+		maximum = glm::max(maximum, positions[indices[i]]);
+	}
+	meshlet.center = (minimum + maximum) * 0.5f;
+	meshlet.radius = 0.0f;
+	for (size_t i = first; i < last; i++) {
+		meshlet.radius = std::max(meshlet.radius, glm::length(positions[indices[i]] - meshlet.center));
+	}
+
+	std::vector<glm::vec3> faceNormals;
+	faceNormals.reserve(meshlet.triangleCount);
+	glm::vec3 axis(0.0f);
+	for (size_t i = first; i < last; i += 3) {
+		const glm::vec3& p0 = positions[indices[i]];
+		const glm::vec3& p1 = positions[indices[i + 1]];
+		const glm::vec3& p2 = positions[indices[i + 2]];
+		glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(faceNormal);
+		if (length <= 0.0f)
+			continue;
+		faceNormal /= length;
+		glm::vec3 vertexNormal = normals[indices[i]] + normals[indices[i + 1]] + normals[indices[i + 2]];
+		if (glm::dot(faceNormal, vertexNormal) < 0.0f)
+			faceNormal = -faceNormal;
+		faceNormals.push_back(faceNormal);
+		axis += faceNormal;
+	}
+
+	float axisLength = glm::length(axis);
+	if (faceNormals.empty() || axisLength <= 0.0f) {
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = 1.0f;
+		return;
+	}
+	meshlet.coneAxis = axis / axisLength;
+
+	float minimumDot = 1.0f;
+	for (size_t n = 0; n < faceNormals.size(); n++) {
+		minimumDot = std::min(minimumDot, glm::dot(meshlet.coneAxis, faceNormals[n]));
+	}
+	// Cones wider than a hemisphere always have a triangle facing the camera
+	meshlet.coneCutoff = minimumDot <= 0.0f ? 1.0f : sqrtf(1.0f - minimumDot * minimumDot);
+}
+
+/*
+* Triangles are added in order until the next one would go over the vertex or triangle limit.
+* Vertex cache ordering keeps neighbour triangles next to each other, so the clusters come out compact.
+*
+*/
+std::vector<Meshlet> buildMeshlets(const std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals) {
+
+	std::vector<Meshlet> meshlets;
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return meshlets;
+
+	// Marks which vertices are already in the current meshlet, the mark is the meshlet number + 1
+	std::vector<size_t> vertexMark(positions.size(), 0);
+	Meshlet current = Meshlet();
+	int vertexCount = 0;
+
+	for (size_t t = 0; t < triangleCount; t++) {
+		int newVertices = 0;
+		for (int k = 0; k < 3; k++) {
+			if (vertexMark[indices[t * 3 + k]] != meshlets.size() + 1)
+				newVertices++;
+		}
+		if (vertexCount + newVertices > maxMeshletVertices || current.triangleCount + 1 > (GLuint)maxMeshletTriangles) {
+			computeMeshletBounds(current, indices, positions, normals);
+			meshlets.push_back(current);
+			current = Meshlet();
+			current.indexOffset = (GLuint)(t * 3);
+			vertexCount = 0;
+		}
+		for (int k = 0; k < 3; k++) {
+			GLuint v = indices[t * 3 + k];
+			if (vertexMark[v] != meshlets.size() + 1) {
+				vertexMark[v] = meshlets.size() + 1;
+				vertexCount++;
+			}
+		}
+		current.triangleCount++;
+	}
+	computeMeshletBounds(current, indices, positions, normals);
+	meshlets.push_back(current);
+	return meshlets;
+}
@@ -0,0 +1,41 @@
+#ifndef meshlet_H
+#define meshlet_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+/* Meshlet Structure
+*
+* A meshlet is a small cluster of triangles that is culled as a whole before drawing.
+* @indexOffset and @triangleCount are the range of the mesh index buffer that belongs to this cluster
+* @center and @radius are the bounding Sphere of the cluster
+* @coneAxis and @coneCutoff are the normal cone, every triangle normal is inside the cone of half angle asin(coneCutoff).
+* A cutoff of 1 means the normals are too spread out and the cluster can never be backface culled.
+*
+*/
+struct Meshlet
+{
+	GLuint indexOffset;
+	GLuint triangleCount;
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	float coneCutoff;
+};
+
+/*Meshlet limits
+*
+* @maxMeshletVertices and @maxMeshletTriangles are the size of each cluster, they match the common mesh shader limits
+*
+*/
+const int maxMeshletVertices = 64;
+const int maxMeshletTriangles = 124;
+
+// Splits the index buffer in its current order, so the mesh should already be optimized for the vertex cache
+std::vector<Meshlet> buildMeshlets(const std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals);
+
+#endif
@@ -0,0 +1,321 @@
+// Vertex cache ordering based on Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+// Overdraw ordering based on Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Tipsify)
+
+#include <algorithm>
+#include <cmath>
+
+#include "meshopt.h"
+
+/*Forsyth scoring variables
+*
+* @forsythCacheSize is the size of the LRU cache the scores are modelled on, it is bigger than the real hardware cache on purpose
+* @cacheDecayPower controls how fast the score of a vertex decays as it moves to the back of the cache
+* @lastTriScore is the fixed score of the three vertices that were just used, lower than the next ones to avoid reusing them as a strip
+* @valenceBoostScale and @valenceBoostPower give a bonus to vertices with few triangles left so they don't get left behind
+*
+*/
+const int forsythCacheSize = 32;
+const float cacheDecayPower = 1.5f;
+const float lastTriScore = 0.75f;
+const float valenceBoostScale = 2.0f;
+const float valenceBoostPower = 0.5f;
+
+/*
+* Counts how many vertices have to be transformed by a First In First Out cache.
+* A vertex is only pushed to the cache when it misses, which is how most of the hardware works.
+*
+*/
+VertexCacheStats simulateVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, int cacheSize) {
+
+	VertexCacheStats stats;
+	if (indices.empty() || vertexCount == 0)
+		return stats;
+
+	// Each vertex remembers the timestamp it entered the cache, so a lookup is a single subtraction
+	std::vector<size_t> cacheTimestamp(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	size_t timestamp = cacheSize + 1;
+	size_t misses = 0;
+	size_t uniqueVertices = 0;
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		GLuint v = indices[i];
+		if (!used[v]) {
+			used[v] = true;
+			uniqueVertices++;
+		}
+		if (timestamp - cacheTimestamp[v] > (size_t)cacheSize) {
+			cacheTimestamp[v] = timestamp++;
+			misses++;
+		}
+	}
+
+	stats.acmr = (double)misses / (indices.size() / 3);
+	stats.atvr = (double)misses / uniqueVertices;
+	return stats;
+}
+
+/*
+* Score of a single vertex given its position in the simulated cache and how many triangles still use it
+*
+*/
+static float vertexScore(int cachePosition, int remainingTriangles) {
+
+	if (remainingTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			score = lastTriScore;
+		}
+		else
+		{
+			float scaler = 1.0f / (forsythCacheSize - 3);
+			score = powf(1.0f - (cachePosition - 3) * scaler, cacheDecayPower);
+		}
+	}
+	score += valenceBoostScale * powf((float)remainingTriangles, -valenceBoostPower);
+	return score;
+}
+
+/*
+* Greedily emits the triangle with the best score, only the triangles that touch the cache are rescored after each step.
+* When no triangle touches the cache anymore the next unused triangle in the original order is picked.
+*
+*/
+void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount) {
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Build the vertex to triangle adjacency in a single array, each vertex owns a range of it
+	std::vector<int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		remaining[indices[i]]++;
+
+	std::vector<size_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + remaining[v];
+
+	std::vector<size_t> adjacency(triangleCount * 3);
+	std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t t = 0; t < triangleCount; t++)
+		for (int k = 0; k < 3; k++)
+			adjacency[fill[indices[t * 3 + k]]++] = t;
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		score[v] = vertexScore(-1, remaining[v]);
+
+	std::vector<float> triangleScore(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+		triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<GLuint> result;
+	result.reserve(triangleCount * 3);
+
+	std::vector<GLuint> cache;
+	std::vector<GLuint> newCache;
+	cache.reserve(forsythCacheSize + 3);
+	newCache.reserve(forsythCacheSize + 3);
+
+	long bestTriangle = 0;
+	size_t deadEndCursor = 0;
+
+	while (result.size() < triangleCount * 3)
+	{
+		if (bestTriangle < 0) {
+			while (emitted[deadEndCursor])
+				deadEndCursor++;
+			bestTriangle = (long)deadEndCursor;
+		}
+
+		const GLuint* tri = &indices[bestTriangle * 3];
+		emitted[bestTriangle] = true;
+
+		// Emit the triangle and remove it from the adjacency of its vertices
+		newCache.clear();
+		for (int k = 0; k < 3; k++)
+		{
+			GLuint v = tri[k];
+			result.push_back(v);
+			newCache.push_back(v);
+
+			size_t begin = offsets[v];
+			size_t end = begin + remaining[v];
+			for (size_t a = begin; a < end; a++)
+			{
+				if (adjacency[a] == (size_t)bestTriangle) {
+					adjacency[a] = adjacency[end - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// The used vertices go to the front of the cache, the rest keeps the previous order
+		for (size_t c = 0; c < cache.size(); c++)
+		{
+			GLuint v = cache[c];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache.push_back(v);
+		}
+		for (size_t c = forsythCacheSize; c < newCache.size(); c++)
+			cachePosition[newCache[c]] = -1;
+		if (newCache.size() > (size_t)forsythCacheSize)
+			newCache.resize(forsythCacheSize);
+		cache.swap(newCache);
+
+		// Rescore the vertices in the cache and the triangles touching them
+		for (size_t c = 0; c < cache.size(); c++)
+		{
+			GLuint v = cache[c];
+			cachePosition[v] = (int)c;
+			float newScore = vertexScore((int)c, remaining[v]);
+			float delta = newScore - score[v];
+			score[v] = newScore;
+			for (size_t a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+				triangleScore[adjacency[a]] += delta;
+		}
+		// Vertices that just fell out of the cache lose their cache score, newCache holds the previous cache now
+		for (size_t c = 0; c < newCache.size(); c++)
+		{
+			GLuint v = newCache[c];
+			if (cachePosition[v] != -1)
+				continue;
+			float newScore = vertexScore(-1, remaining[v]);
+			float delta = newScore - score[v];
+			score[v] = newScore;
+			for (size_t a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+				triangleScore[adjacency[a]] += delta;
+		}
+
+		// The next triangle is the best one that touches the cache
+		float bestScore = -1.0f;
+		bestTriangle = -1;
+		for (size_t c = 0; c < cache.size(); c++)
+		{
+			GLuint v = cache[c];
+			for (size_t a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+			{
+				size_t t = adjacency[a];
+				if (triangleScore[t] > bestScore) {
+					bestScore = triangleScore[t];
+					bestTriangle = (long)t;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+/*
+* Splits the cache optimized list into clusters at every point where the cache is fully flushed (a triangle with 3 misses),
+* then sorts the clusters so the ones facing away from the center of the mesh are drawn first.
+* For any point of view this draws the likely occluders before the occluded triangles, while every cluster keeps its cache order.
+*
+*/
+void optimizeOverdraw(std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions, int cacheSize) {
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	std::vector<size_t> clusters;
+	std::vector<size_t> cacheTimestamp(positions.size(), 0);
+	size_t timestamp = cacheSize + 1;
+
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			GLuint v = indices[t * 3 + k];
+			if (timestamp - cacheTimestamp[v] > (size_t)cacheSize) {
+				cacheTimestamp[v] = timestamp++;
+				misses++;
+			}
+		}
+		if (t == 0 || misses == 3)
+			clusters.push_back(t);
+	}
+	clusters.push_back(triangleCount);
+
+	glm::vec3 meshCentroid(0.0f);
+	for (size_t v = 0; v < positions.size(); v++)
+		meshCentroid += positions[v];
+	meshCentroid /= (float)positions.size();
+
+	// Area weighted centroid and normal of each cluster
+	size_t clusterCount = clusters.size() - 1;
+	std::vector<float> sortKey(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const glm::vec3& p0 = positions[indices[t * 3]];
+			const glm::vec3& p1 = positions[indices[t * 3 + 1]];
+			const glm::vec3& p2 = positions[indices[t * 3 + 2]];
+			glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+			float faceArea = glm::length(faceNormal);
+			centroid += (p0 + p1 + p2) * (faceArea / 3.0f);
+			normal += faceNormal;
+			area += faceArea;
+		}
+		float normalLength = glm::length(normal);
+		if (area > 0.0f && normalLength > 0.0f) {
+			centroid /= area;
+			sortKey[c] = glm::dot(centroid - meshCentroid, normal / normalLength);
+		}
+		else
+		{
+			sortKey[c] = 0.0f;
+		}
+	}
+
+	std::vector<size_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+		order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+	std::vector<GLuint> result;
+	result.reserve(indices.size());
+	for (size_t c = 0; c < clusterCount; c++)
+		result.insert(result.end(), indices.begin() + clusters[order[c]] * 3, indices.begin() + clusters[order[c] + 1] * 3);
+	indices.swap(result);
+}
+
+/*
+* Vertices are renumbered in the order the index buffer first references them so the vertex fetch walks memory linearly.
+* Vertices that are never referenced are placed at the end.
+*
+*/
+std::vector<GLuint> optimizeVertexFetch(std::vector<GLuint>& indices, size_t vertexCount) {
+
+	const GLuint unused = ~0u;
+	std::vector<GLuint> remap(vertexCount, unused);
+	GLuint next = 0;
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		GLuint& v = indices[i];
+		if (remap[v] == unused)
+			remap[v] = next++;
+		v = remap[v];
+	}
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == unused)
+			remap[v] = next++;
+	}
+	return remap;
+}
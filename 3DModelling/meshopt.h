@@ -0,0 +1,35 @@
+#ifndef meshopt_H
+#define meshopt_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+/* Vertex cache statistics
+*
+* @acmr is the Average Cache Miss Ratio, the amount of vertices transformed per triangle (0.5 is the ideal for big grids, 3 is the worst)
+* @atvr is the Average Transformed Vertex Ratio, the amount of times each vertex was transformed (1 is the ideal)
+*
+*/
+struct VertexCacheStats
+{
+	double acmr = 0;
+	double atvr = 0;
+};
+
+// Simulates a FIFO post-transform cache of cacheSize entries over a triangle list
+VertexCacheStats simulateVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, int cacheSize);
+
+// Reorders the triangles so they reuse the vertices that are still in the cache (Forsyth's linear-speed algorithm)
+void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount);
+
+// Reorders clusters of triangles so the outward facing ones are drawn first, this keeps most of the cache order
+void optimizeOverdraw(std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions, int cacheSize);
+
+// Renumbers the vertices in the order they are first used and returns the remap table (old index -> new index)
+std::vector<GLuint> optimizeVertexFetch(std::vector<GLuint>& indices, size_t vertexCount);
+
+#endif
@@ -0,0 +1,299 @@
+// Barnes-Hut tree code based on Barnes and Hut "A hierarchical O(N log N) force-calculation algorithm"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nbody.h"
+#include "parallel.h"
+
+/* Octree Node
+*
+* A node is a cube, when it is a leaf it holds the bodies [begin, end) of the sorted order, otherwise it has up to 8 children.
+* Every node stores the total mass and the center of mass of the bodies inside it.
+*
+*/
+struct OctreeNode
+{
+	glm::dvec3 center;
+	double halfSize;
+	glm::dvec3 centerOfMass;
+	double mass;
+	int children[8];
+	unsigned begin, end;
+	bool leaf;
+};
+
+/* Octree Structure
+*
+* @order maps the position in the tree to the index of the Planet, @positions and @masses are already in tree order
+*
+*/
+struct Octree
+{
+	std::vector<OctreeNode> nodes;
+	std::vector<unsigned> order;
+	std::vector<glm::dvec3> positions;
+	std::vector<double> masses;
+};
+
+const int maxOctreeDepth = 32;
+
+/*
+* Splits the bodies of the node by octant with three in place partitions (x, then y, then z), and recurses into every octant
+*
+*/
+static int buildNode(Octree& tree, unsigned begin, unsigned end, glm::dvec3 center, double halfSize, int depth, int leafSize) {
+
+	int index = (int)tree.nodes.size();
+	tree.nodes.push_back(OctreeNode());
+	OctreeNode node;
+	node.center = center;
+	node.halfSize = halfSize;
+	node.begin = begin;
+	node.end = end;
+	node.mass = 0.0;
+	node.centerOfMass = glm::dvec3(0.0);
+	for (int c = 0; c < 8; c++)
+		node.children[c] = -1;
+
+	node.leaf = (int)(end - begin) <= leafSize || depth >= maxOctreeDepth;
+	if (node.leaf) {
+		for (unsigned i = begin; i < end; i++) {
+			unsigned body = tree.order[i];
+			node.mass += tree.masses[body];
+			node.centerOfMass += tree.positions[body] * tree.masses[body];
+		}
+	}
+	else
+	{
+		unsigned* first = tree.order.data() + begin;
+		unsigned* last = tree.order.data() + end;
+		const std::vector<glm::dvec3>& positions = tree.positions;
+		unsigned* splitX = std::partition(first, last, [&](unsigned b) { return positions[b].x < center.x; });
+		unsigned* ranges[9];
+		ranges[0] = first;
+		ranges[4] = splitX;
+		ranges[8] = last;
+		ranges[2] = std::partition(ranges[0], ranges[4], [&](unsigned b) { return positions[b].y < center.y; });
+		ranges[6] = std::partition(ranges[4], ranges[8], [&](unsigned b) { return positions[b].y < center.y; });
+		for (int r = 0; r < 8; r += 2)
+			ranges[r + 1] = std::partition(ranges[r], ranges[r + 2], [&](unsigned b) { return positions[b].z < center.z; });
+
+		double childHalf = halfSize * 0.5;
+		for (int c = 0; c < 8; c++) {
+			unsigned childBegin = (unsigned)(ranges[c] - tree.order.data());
+			unsigned childEnd = (unsigned)(ranges[c + 1] - tree.order.data());
+			if (childBegin == childEnd)
+				continue;
+			glm::dvec3 childCenter = center + glm::dvec3(c & 4 ? childHalf : -childHalf, c & 2 ? childHalf : -childHalf, c & 1 ? childHalf : -childHalf);
+			int child = buildNode(tree, childBegin, childEnd, childCenter, childHalf, depth + 1, leafSize);
+			node.children[c] = child;
+			node.mass += tree.nodes[child].mass;
+			node.centerOfMass += tree.nodes[child].centerOfMass * tree.nodes[child].mass;
+		}
+	}
+	if (node.mass > 0.0)
+		node.centerOfMass /= node.mass;
+	tree.nodes[index] = node;
+	return index;
+}
+
+static void buildOctree(Octree& tree, const Planet* planets, size_t count, int leafSize) {
+
+	tree.nodes.clear();
+	tree.order.resize(count);
+	tree.positions.resize(count);
+	tree.masses.resize(count);
+
+	glm::dvec3 minimum(planets[0].xpos, planets[0].ypos, planets[0].zpos);
+	glm::dvec3 maximum = minimum;
+	for (size_t i = 0; i < count; i++) {
+		tree.order[i] = (unsigned)i;
+		tree.positions[i] = glm::dvec3(planets[i].xpos, planets[i].ypos, planets[i].zpos);
+		tree.masses[i] = planets[i].mass;
+		minimum = glm::min(minimum, tree.positions[i]);
+		maximum = glm::max(maximum, tree.positions[i]);
+	}
+
+	glm::dvec3 extent = maximum - minimum;
+	double halfSize = std::max(extent.x, std::max(extent.y, extent.z)) * 0.5 + 1e-9;
+	tree.nodes.reserve(count / std::max(leafSize, 1) * 2 + 1);
+	buildNode(tree, 0, (unsigned)count, (minimum + maximum) * 0.5, halfSize, 0, leafSize);
+
+	// The bodies are stored in tree order from now on so the leaves read memory linearly
+	std::vector<glm::dvec3> sortedPositions(count);
+	std::vector<double> sortedMasses(count);
+	for (size_t i = 0; i < count; i++) {
+		sortedPositions[i] = tree.positions[tree.order[i]];
+		sortedMasses[i] = tree.masses[tree.order[i]];
+	}
+	tree.positions.swap(sortedPositions);
+	tree.masses.swap(sortedMasses);
+}
+
+static inline glm::dvec3 pointGravity(const glm::dvec3& position, const glm::dvec3& source, double mass, double softening2) {
+
+	glm::dvec3 d = source - position;
+	double distance2 = glm::dot(d, d) + softening2;
+	double inverseDistance = 1.0 / sqrt(distance2);
+	return d * (mass * inverseDistance * inverseDistance * inverseDistance);
+}
+
+/*
+* Walks the tree from the root, a node far enough away is used as one body and the leaves that are too close are summed directly
+*
+*/
+static glm::dvec3 treeGravity(const Octree& tree, unsigned slot, double theta2, double softening2) {
+
+	const glm::dvec3& position = tree.positions[slot];
+	glm::dvec3 acceleration(0.0);
+	int stack[8 * maxOctreeDepth + 8];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0) {
+		const OctreeNode& node = tree.nodes[stack[--top]];
+		glm::dvec3 d = node.centerOfMass - position;
+		double distance2 = glm::dot(d, d);
+		double size = node.halfSize * 2.0;
+
+		if (node.leaf) {
+			for (unsigned i = node.begin; i < node.end; i++) {
+				if (i != slot)
+					acceleration += pointGravity(position, tree.positions[i], tree.masses[i], softening2);
+			}
+		}
+		else if (size * size < theta2 * distance2) {
+			acceleration += pointGravity(position, node.centerOfMass, node.mass, softening2);
+		}
+		else
+		{
+			for (int c = 0; c < 8; c++) {
+				if (node.children[c] >= 0)
+					stack[top++] = node.children[c];
+			}
+		}
+	}
+	return acceleration;
+}
+
+void computeGravityBarnesHut(const Planet* planets, size_t count, const GravitySimulation& simulation, std::vector<glm::dvec3>& accelerations) {
+
+	accelerations.resize(count);
+	if (count == 0)
+		return;
+
+	Octree tree;
+	buildOctree(tree, planets, count, simulation.leafSize);
+
+	double theta2 = simulation.openingAngle * simulation.openingAngle;
+	double softening2 = simulation.softening * simulation.softening;
+	double G = simulation.gravityConstant;
+	// Threads take the bodies in tree order so neighbour bodies share the same nodes in the cache
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			accelerations[tree.order[i]] = treeGravity(tree, (unsigned)i, theta2, softening2) * G;
+	}, simulation.threadCount);
+}
+
+glm::dvec3 exactGravity(const Planet* planets, size_t count, size_t body, const GravitySimulation& simulation) {
+
+	double softening2 = simulation.softening * simulation.softening;
+	glm::dvec3 position(planets[body].xpos, planets[body].ypos, planets[body].zpos);
+	glm::dvec3 acceleration(0.0);
+	for (size_t j = 0; j < count; j++) {
+		if (j == body)
+			continue;
+		glm::dvec3 source(planets[j].xpos, planets[j].ypos, planets[j].zpos);
+		acceleration += pointGravity(position, source, planets[j].mass, softening2);
+	}
+	return acceleration * simulation.gravityConstant;
+}
+
+void computeGravityExact(const Planet* planets, size_t count, const GravitySimulation& simulation, std::vector<glm::dvec3>& accelerations) {
+
+	accelerations.resize(count);
+	parallelFor(count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			accelerations[i] = exactGravity(planets, count, i, simulation);
+	}, simulation.threadCount);
+}
+
+static void computeGravity(const Planet* planets, size_t count, GravitySimulation& simulation) {
+
+	static const SimdISA isa = detectSimdISA();
+	if (count <= simulation.directLimit)
+		computeGravityDirect(planets, count, simulation, simulation.accelerations, isa);
+	else
+		computeGravityBarnesHut(planets, count, simulation, simulation.accelerations);
+}
+
+void stepGravity(GravitySimulation& simulation, Planet* planets, size_t count, double dt) {
+
+	if (simulation.accelerations.size() != count)
+		computeGravity(planets, count, simulation);
+
+	double halfStep = dt * 0.5;
+	for (size_t i = 0; i < count; i++) {
+		const glm::dvec3& a = simulation.accelerations[i];
+		planets[i].xvel += a.x * halfStep;
+		planets[i].yvel += a.y * halfStep;
+		planets[i].zvel += a.z * halfStep;
+		planets[i].xpos += planets[i].xvel * dt;
+		planets[i].ypos += planets[i].yvel * dt;
+		planets[i].zpos += planets[i].zvel * dt;
+	}
+
+	computeGravity(planets, count, simulation);
+
+	for (size_t i = 0; i < count; i++) {
+		const glm::dvec3& a = simulation.accelerations[i];
+		planets[i].xvel += a.x * halfStep;
+		planets[i].yvel += a.y * halfStep;
+		planets[i].zvel += a.z * halfStep;
+	}
+}
+
+void setCircularVelocities(Planet* planets, size_t count, double gravityConstant) {
+
+	if (count == 0)
+		return;
+
+	glm::dvec3 centerOfMass(0.0);
+	double totalMass = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		centerOfMass += glm::dvec3(planets[i].xpos, planets[i].ypos, planets[i].zpos) * planets[i].mass;
+		totalMass += planets[i].mass;
+	}
+	if (totalMass > 0.0)
+		centerOfMass /= totalMass;
+
+	std::vector<size_t> order(count);
+	std::vector<double> distance(count);
+	for (size_t i = 0; i < count; i++) {
+		order[i] = i;
+		distance[i] = glm::length(glm::dvec3(planets[i].xpos, planets[i].ypos, planets[i].zpos) - centerOfMass);
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distance[a] < distance[b]; });
+
+	double enclosedMass = 0.0;
+	for (size_t k = 0; k < count; k++) {
+		Planet& planet = planets[order[k]];
+		glm::dvec3 offset = glm::dvec3(planet.xpos, planet.ypos, planet.zpos) - centerOfMass;
+		glm::dvec3 tangent = glm::cross(glm::dvec3(0.0, 1.0, 0.0), offset);
+		double r = distance[order[k]];
+		double tangentLength = glm::length(tangent);
+		if (r > 0.0 && tangentLength > 0.0 && enclosedMass > 0.0) {
+			double speed = sqrt(gravityConstant * enclosedMass / r);
+			tangent *= speed / tangentLength;
+		}
+		else
+		{
+			tangent = glm::dvec3(0.0);
+		}
+		planet.xvel = tangent.x;
+		planet.yvel = tangent.y;
+		planet.zvel = tangent.z;
+		enclosedMass += planet.mass;
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef nbody_H
+#define nbody_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "planet.h"
+#include "simd.h"
+
+/* Gravity Simulation
+*
+* Holds the settings of the N-body simulation and the accelerations of the last step.
+* @gravityConstant is G in the units of the scene, with a mass of 1 per Sphere the orbits take a few seconds
+* @softening keeps the force finite when two Spheres get very close, it is about the size of a Sphere
+* @openingAngle is the Barnes-Hut theta, a node is used as a single body when its size / distance is below it.
+* 0 is the exact sum and bigger values are faster but less accurate, 0.5 is the usual choice
+* @leafSize is how many bodies a node of the octree can hold before it is split
+* @threadCount is how many threads compute the forces, 0 uses every core
+* @directLimit is the body count up to which the SIMD direct sum is used instead of the octree,
+* it is faster below about 20k bodies because it has no tree to build and no branches
+* @accelerations are kept from the last step so the leapfrog integrator only computes the forces once per step
+*
+*/
+struct GravitySimulation
+{
+	double gravityConstant = 1.0;
+	double softening = 0.5;
+	double openingAngle = 0.5;
+	int leafSize = 8;
+	unsigned threadCount = 0;
+	size_t directLimit = 20000;
+	std::vector<glm::dvec3> accelerations;
+};
+
+// Accelerations of every body using an octree, O(N log N)
+void computeGravityBarnesHut(const Planet* planets, size_t count, const GravitySimulation& simulation, std::vector<glm::dvec3>& accelerations);
+
+// Accelerations of every body by summing every pair in single precision with SIMD, O(N^2) but with a small constant
+void computeGravityDirect(const Planet* planets, size_t count, const GravitySimulation& simulation, std::vector<glm::dvec3>& accelerations, SimdISA isa);
+
+// Accelerations of every body by summing every pair, O(N^2), this is the reference for the accuracy of the octree
+void computeGravityExact(const Planet* planets, size_t count, const GravitySimulation& simulation, std::vector<glm::dvec3>& accelerations);
+glm::dvec3 exactGravity(const Planet* planets, size_t count, size_t body, const GravitySimulation& simulation);
+
+// Kick-drift-kick leapfrog step, it is symplectic so the orbits don't gain or lose energy over time
+void stepGravity(GravitySimulation& simulation, Planet* planets, size_t count, double dt);
+
+// Gives every body the speed of a circular orbit around the center of mass in the XZ plane, using the mass closer to the center
+void setCircularVelocities(Planet* planets, size_t count, double gravityConstant);
+
+#endif
@@ -0,0 +1,206 @@
+// Direct summation gravity with SIMD kernels chosen at runtime, the layout follows Nyland et al. "Fast N-Body Simulation with CUDA"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nbody.h"
+#include "parallel.h"
+#include "simd.h"
+
+/*Direct gravity variables
+*
+* @gravityTileSize is how many bodies are summed before moving to the next block of targets.
+* 1024 bodies are 16 KB of positions and masses, which stays in the L1 cache while every target goes over them.
+* @gravityLanePadding is the widest SIMD width, the arrays are padded to it with bodies of mass 0
+*
+*/
+const size_t gravityTileSize = 1024;
+const size_t gravityLanePadding = 16;
+
+/* Structure of Arrays copy of the bodies
+*
+* Every coordinate is in its own array so a SIMD register loads the same coordinate of consecutive bodies.
+*
+*/
+struct GravityArrays
+{
+	size_t count;
+	size_t paddedCount;
+	std::vector<float> x, y, z, mass;
+	std::vector<float> ax, ay, az;
+};
+
+static void fillGravityArrays(GravityArrays& arrays, const Planet* planets, size_t count) {
+
+	arrays.count = count;
+	arrays.paddedCount = (count + gravityLanePadding - 1) / gravityLanePadding * gravityLanePadding;
+	arrays.x.assign(arrays.paddedCount, 0.0f);
+	arrays.y.assign(arrays.paddedCount, 0.0f);
+	arrays.z.assign(arrays.paddedCount, 0.0f);
+	arrays.mass.assign(arrays.paddedCount, 0.0f);
+	arrays.ax.assign(arrays.paddedCount, 0.0f);
+	arrays.ay.assign(arrays.paddedCount, 0.0f);
+	arrays.az.assign(arrays.paddedCount, 0.0f);
+	for (size_t i = 0; i < count; i++) {
+		arrays.x[i] = (float)planets[i].xpos;
+		arrays.y[i] = (float)planets[i].ypos;
+		arrays.z[i] = (float)planets[i].zpos;
+		arrays.mass[i] = (float)planets[i].mass;
+	}
+}
+
+/*
+* The scalar kernel is the reference for the SIMD ones, it uses the exact 1 / sqrt.
+* A body against itself has a distance of 0, which only adds 0 thanks to the softening, so there is no branch for it.
+*
+*/
+static void directScalar(GravityArrays& a, size_t begin, size_t end, float softening2) {
+
+	for (size_t tile = 0; tile < a.paddedCount; tile += gravityTileSize) {
+		size_t tileEnd = std::min(a.paddedCount, tile + gravityTileSize);
+		for (size_t i = begin; i < end; i++) {
+			float xi = a.x[i], yi = a.y[i], zi = a.z[i];
+			float axi = a.ax[i], ayi = a.ay[i], azi = a.az[i];
+			for (size_t j = tile; j < tileEnd; j++) {
+				float dx = a.x[j] - xi;
+				float dy = a.y[j] - yi;
+				float dz = a.z[j] - zi;
+				float distance2 = dx * dx + dy * dy + dz * dz + softening2;
+				float inverse = 1.0f / sqrtf(distance2);
+				float s = a.mass[j] * inverse * inverse * inverse;
+				axi += dx * s;
+				ayi += dy * s;
+				azi += dz * s;
+			}
+			a.ax[i] = axi;
+			a.ay[i] = ayi;
+			a.az[i] = azi;
+		}
+	}
+}
+
+#if SIMD_X86
+/*
+* The SIMD kernels process 4, 8 or 16 targets at once and broadcast one source at a time, so there is no horizontal sum.
+* The hardware reciprocal square root is refined with one Newton step: r = r * (1.5 - 0.5 * d2 * r * r)
+*
+*/
+static void directSSE(GravityArrays& a, size_t begin, size_t end, float softening2) {
+
+	const __m128 eps2 = _mm_set1_ps(softening2);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 threeHalves = _mm_set1_ps(1.5f);
+	for (size_t tile = 0; tile < a.paddedCount; tile += gravityTileSize) {
+		size_t tileEnd = std::min(a.paddedCount, tile + gravityTileSize);
+		for (size_t i = begin; i < end; i += 4) {
+			__m128 xi = _mm_loadu_ps(&a.x[i]), yi = _mm_loadu_ps(&a.y[i]), zi = _mm_loadu_ps(&a.z[i]);
+			__m128 axi = _mm_loadu_ps(&a.ax[i]), ayi = _mm_loadu_ps(&a.ay[i]), azi = _mm_loadu_ps(&a.az[i]);
+			for (size_t j = tile; j < tileEnd; j++) {
+				__m128 dx = _mm_sub_ps(_mm_set1_ps(a.x[j]), xi);
+				__m128 dy = _mm_sub_ps(_mm_set1_ps(a.y[j]), yi);
+				__m128 dz = _mm_sub_ps(_mm_set1_ps(a.z[j]), zi);
+				__m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_add_ps(_mm_mul_ps(dz, dz), eps2));
+				__m128 r = _mm_rsqrt_ps(distance2);
+				r = _mm_mul_ps(r, _mm_sub_ps(threeHalves, _mm_mul_ps(_mm_mul_ps(half, distance2), _mm_mul_ps(r, r))));
+				__m128 s = _mm_mul_ps(_mm_set1_ps(a.mass[j]), _mm_mul_ps(r, _mm_mul_ps(r, r)));
+				axi = _mm_add_ps(axi, _mm_mul_ps(dx, s));
+				ayi = _mm_add_ps(ayi, _mm_mul_ps(dy, s));
+				azi = _mm_add_ps(azi, _mm_mul_ps(dz, s));
+			}
+			_mm_storeu_ps(&a.ax[i], axi);
+			_mm_storeu_ps(&a.ay[i], ayi);
+			_mm_storeu_ps(&a.az[i], azi);
+		}
+	}
+}
+
+TARGET_AVX2 static void directAVX2(GravityArrays& a, size_t begin, size_t end, float softening2) {
+
+	const __m256 eps2 = _mm256_set1_ps(softening2);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 threeHalves = _mm256_set1_ps(1.5f);
+	for (size_t tile = 0; tile < a.paddedCount; tile += gravityTileSize) {
+		size_t tileEnd = std::min(a.paddedCount, tile + gravityTileSize);
+		for (size_t i = begin; i < end; i += 8) {
+			__m256 xi = _mm256_loadu_ps(&a.x[i]), yi = _mm256_loadu_ps(&a.y[i]), zi = _mm256_loadu_ps(&a.z[i]);
+			__m256 axi = _mm256_loadu_ps(&a.ax[i]), ayi = _mm256_loadu_ps(&a.ay[i]), azi = _mm256_loadu_ps(&a.az[i]);
+			for (size_t j = tile; j < tileEnd; j++) {
+				__m256 dx = _mm256_sub_ps(_mm256_set1_ps(a.x[j]), xi);
+				__m256 dy = _mm256_sub_ps(_mm256_set1_ps(a.y[j]), yi);
+				__m256 dz = _mm256_sub_ps(_mm256_set1_ps(a.z[j]), zi);
+				__m256 distance2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_fmadd_ps(dz, dz, eps2)));
+				__m256 r = _mm256_rsqrt_ps(distance2);
+				r = _mm256_mul_ps(r, _mm256_fnmadd_ps(_mm256_mul_ps(half, distance2), _mm256_mul_ps(r, r), threeHalves));
+				__m256 s = _mm256_mul_ps(_mm256_set1_ps(a.mass[j]), _mm256_mul_ps(r, _mm256_mul_ps(r, r)));
+				axi = _mm256_fmadd_ps(dx, s, axi);
+				ayi = _mm256_fmadd_ps(dy, s, ayi);
+				azi = _mm256_fmadd_ps(dz, s, azi);
+			}
+			_mm256_storeu_ps(&a.ax[i], axi);
+			_mm256_storeu_ps(&a.ay[i], ayi);
+			_mm256_storeu_ps(&a.az[i], azi);
+		}
+	}
+}
+
+TARGET_AVX512 static void directAVX512(GravityArrays& a, size_t begin, size_t end, float softening2) {
+
+	const __m512 eps2 = _mm512_set1_ps(softening2);
+	const __m512 half = _mm512_set1_ps(0.5f);
+	const __m512 threeHalves = _mm512_set1_ps(1.5f);
+	for (size_t tile = 0; tile < a.paddedCount; tile += gravityTileSize) {
+		size_t tileEnd = std::min(a.paddedCount, tile + gravityTileSize);
+		for (size_t i = begin; i < end; i += 16) {
+			__m512 xi = _mm512_loadu_ps(&a.x[i]), yi = _mm512_loadu_ps(&a.y[i]), zi = _mm512_loadu_ps(&a.z[i]);
+			__m512 axi = _mm512_loadu_ps(&a.ax[i]), ayi = _mm512_loadu_ps(&a.ay[i]), azi = _mm512_loadu_ps(&a.az[i]);
+			for (size_t j = tile; j < tileEnd; j++) {
+				__m512 dx = _mm512_sub_ps(_mm512_set1_ps(a.x[j]), xi);
+				__m512 dy = _mm512_sub_ps(_mm512_set1_ps(a.y[j]), yi);
+				__m512 dz = _mm512_sub_ps(_mm512_set1_ps(a.z[j]), zi);
+				__m512 distance2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_fmadd_ps(dz, dz, eps2)));
+				__m512 r = _mm512_rsqrt14_ps(distance2);
+				r = _mm512_mul_ps(r, _mm512_fnmadd_ps(_mm512_mul_ps(half, distance2), _mm512_mul_ps(r, r), threeHalves));
+				__m512 s = _mm512_mul_ps(_mm512_set1_ps(a.mass[j]), _mm512_mul_ps(r, _mm512_mul_ps(r, r)));
+				axi = _mm512_fmadd_ps(dx, s, axi);
+				ayi = _mm512_fmadd_ps(dy, s, ayi);
+				azi = _mm512_fmadd_ps(dz, s, azi);
+			}
+			_mm512_storeu_ps(&a.ax[i], axi);
+			_mm512_storeu_ps(&a.ay[i], ayi);
+			_mm512_storeu_ps(&a.az[i], azi);
+		}
+	}
+}
+#endif
+
+void computeGravityDirect(const Planet* planets, size_t count, const GravitySimulation& simulation, std::vector<glm::dvec3>& accelerations, SimdISA isa) {
+
+	accelerations.resize(count);
+	if (count == 0)
+		return;
+#if !SIMD_X86
+	isa = SIMD_SCALAR;
+#endif
+
+	GravityArrays arrays;
+	fillGravityArrays(arrays, planets, count);
+	float softening2 = (float)(simulation.softening * simulation.softening);
+
+	// Every thread gets whole blocks of 16 targets so each SIMD width divides its range
+	size_t blocks = arrays.paddedCount / gravityLanePadding;
+	parallelFor(blocks, [&](size_t blockBegin, size_t blockEnd) {
+		size_t begin = blockBegin * gravityLanePadding;
+		size_t end = blockEnd * gravityLanePadding;
+		switch (isa) {
+#if SIMD_X86
+		case SIMD_SSE: directSSE(arrays, begin, end, softening2); break;
+		case SIMD_AVX2: directAVX2(arrays, begin, end, softening2); break;
+		case SIMD_AVX512: directAVX512(arrays, begin, end, softening2); break;
+#endif
+		default: directScalar(arrays, begin, end, softening2); break;
+		}
+	}, simulation.threadCount);
+
+	for (size_t i = 0; i < count; i++)
+		accelerations[i] = glm::dvec3(arrays.ax[i], arrays.ay[i], arrays.az[i]) * simulation.gravityConstant;
+}
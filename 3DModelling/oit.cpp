@@ -0,0 +1,157 @@
+// Weighted blended OIT is from McGuire and Bavoil "Weighted Blended Order-Independent Transparency" (JCGT 2013),
+// the linked lists from Yang et al. "Real-Time Concurrent Linked List Construction on the GPU" (EGSR 2010)
+
+#include <algorithm>
+
+#include "oit.h"
+
+/*OIT variables
+*
+* @oitTextureUnit is the texture unit of the weighted sums, the units before it hold the lighting inputs and the bloom
+*
+*/
+const int oitTextureUnit = 12;
+
+const char* oitModeName(OITMode mode) {
+
+	static const char* names[] = { "WEIGHTED", "LINKED_LIST", "SORTED" };
+	return names[mode];
+}
+
+bool linkedListSupported() {
+	return GLEW_VERSION_4_3 != 0;
+}
+
+void sortShellsBackToFront(std::vector<SphereInstance>& shells, const glm::vec3& viewPoint) {
+
+	std::sort(shells.begin(), shells.end(), [&](const SphereInstance& a, const SphereInstance& b) {
+		glm::vec3 da = glm::vec3(a.centerRadius) - viewPoint;
+		glm::vec3 db = glm::vec3(b.centerRadius) - viewPoint;
+		return glm::dot(da, da) > glm::dot(db, db);
+	});
+}
+
+/*
+* The heads are cleared through a framebuffer, the nodes and the counter have one 16 byte node and one counter.
+* The node 0 is never written, a head or a next of 0 is the end of a list
+*
+*/
+static void resizeLinkedLists(TranslucentShells& shells, int width, int height) {
+
+	if (shells.heads != 0 && shells.listWidth == width && shells.listHeight == height)
+		return;
+	glDeleteTextures(1, &shells.heads);
+	glDeleteFramebuffers(1, &shells.headsFBO);
+	if (shells.nodes == 0) {
+		glGenBuffers(1, &shells.nodes);
+		glGenBuffers(1, &shells.counter);
+	}
+
+	glGenTextures(1, &shells.heads);
+	glBindTexture(GL_TEXTURE_2D, shells.heads);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenFramebuffers(1, &shells.headsFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, shells.headsFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, shells.heads, 0);
+
+	shells.nodeCapacity = (GLuint)(width * height * shells.listLayers);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, shells.nodes);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(shells.nodeCapacity + 1) * 16, NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, shells.counter);
+	glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+	shells.listWidth = width;
+	shells.listHeight = height;
+}
+
+void beginTranslucency(TranslucentShells& shells, const Framebuffer& scene) {
+
+	// The shells are tested against the opaque depth but don't write it, so they never hide each other
+	glDepthMask(GL_FALSE);
+	if (shells.mode == OIT_WEIGHTED) {
+		resizeFramebuffer(shells.accumulation, scene.width, scene.height, { GL_RGBA16F, GL_R16F }, false);
+		bindFramebuffer(shells.accumulation);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, scene.depth, 0);
+		const GLfloat emptyColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		const GLfloat emptyWeight[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearBufferfv(GL_COLOR, 0, emptyColor);
+		glClearBufferfv(GL_COLOR, 1, emptyWeight);
+		// The colour and the weights are added, the alpha of the first target multiplies the revealage by 1 - alpha.
+		// The same blending for both targets works on OpenGL 3.3, which has no glBlendFunci
+		glEnable(GL_BLEND);
+		glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+	}
+	else if (shells.mode == OIT_LINKED_LIST) {
+		resizeLinkedLists(shells, scene.width, scene.height);
+		const GLuint end[4] = { 0, 0, 0, 0 };
+		glBindFramebuffer(GL_FRAMEBUFFER, shells.headsFBO);
+		glClearBufferuiv(GL_COLOR, 0, end);
+		GLuint zero = 0;
+		glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, shells.counter);
+		glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(GLuint), &zero);
+		glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+
+		glBindImageTexture(0, shells.heads, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, shells.nodes);
+		glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, shells.counter);
+		// Only the depth test of the frame is needed, the fragments go into the lists
+		bindFramebuffer(scene);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	}
+	else
+	{
+		bindFramebuffer(scene);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	}
+}
+
+void endTranslucency(TranslucentShells& shells, const Framebuffer& scene) {
+
+	if (shells.mode == OIT_WEIGHTED) {
+		bindFramebuffer(scene);
+		glUseProgram(shells.compositeProgram);
+		glActiveTexture(GL_TEXTURE0 + oitTextureUnit);
+		glBindTexture(GL_TEXTURE_2D, shells.accumulation.colors[0]);
+		glActiveTexture(GL_TEXTURE0 + oitTextureUnit + 1);
+		glBindTexture(GL_TEXTURE_2D, shells.accumulation.colors[1]);
+		glActiveTexture(GL_TEXTURE0);
+		glUniform1i(glGetUniformLocation(shells.compositeProgram, "accumulation"), oitTextureUnit);
+		glUniform1i(glGetUniformLocation(shells.compositeProgram, "weights"), oitTextureUnit + 1);
+		// The average colour covers the frame by 1 - revealage
+		glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+		drawFullscreenTriangle();
+		glEnable(GL_DEPTH_TEST);
+	}
+	else if (shells.mode == OIT_LINKED_LIST) {
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+		glUseProgram(shells.resolveProgram);
+		// The resolve gives the colour of the sorted fragments and how much of the frame they let through
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+		drawFullscreenTriangle();
+		glEnable(GL_DEPTH_TEST);
+	}
+	glDisable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ZERO);
+	glDepthMask(GL_TRUE);
+}
+
+void deleteTranslucentShells(TranslucentShells& shells) {
+
+	deleteFramebuffer(shells.accumulation);
+	glDeleteTextures(1, &shells.heads);
+	glDeleteFramebuffers(1, &shells.headsFBO);
+	glDeleteBuffers(1, &shells.nodes);
+	glDeleteBuffers(1, &shells.counter);
+	shells.heads = shells.headsFBO = shells.nodes = shells.counter = 0;
+	shells.listWidth = shells.listHeight = 0;
+	shells.nodeCapacity = 0;
+}
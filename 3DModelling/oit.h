@@ -0,0 +1,76 @@
+#ifndef oit_H
+#define oit_H
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "framebuffer.h"
+#include "impostor.h"
+
+/*
+* How the translucent shells are blended over the frame
+* OIT_WEIGHTED is weighted blended order independent transparency, every fragment is added to a weighted average in any order
+* OIT_LINKED_LIST keeps every fragment of every pixel in a list and sorts them when they are resolved, exact but it needs OpenGL 4.3
+* OIT_SORTED sorts the shells back to front on the CPU and blends them in that order, the usual way it is done
+*
+*/
+enum OITMode { OIT_WEIGHTED, OIT_LINKED_LIST, OIT_SORTED };
+
+const char* oitModeName(OITMode mode);
+
+// True when the driver has what OIT_LINKED_LIST needs, images, shader storage buffers and atomic counters
+bool linkedListSupported();
+
+/*
+* Features of the shell shaders, the bits of the keys of their variants (see shadervariants.h)
+* SHELL_INSTANCED reads the Spheres from the instanced attributes of vert.glsl, the shells are always drawn that way
+* SHELL_SORTED writes the premultiplied colour for plain blending instead of the weighted sums
+*
+*/
+enum ShellFeature { SHELL_INSTANCED = 1, SHELL_SORTED = 2 };
+
+/* Translucent Shells
+*
+* Draws translucent shells, atmospheres around the Spheres, over the opaque frame without sorting them (apart from OIT_SORTED).
+* The opaque depth of the frame hides the shells behind the Spheres, the shells don't write depth.
+* @listLayers is how many fragments per pixel on average the linked lists have room for, the ones after that are lost
+* @accumulation holds the weighted colour with the revealage in its alpha, and the sum of the weights
+* @compositeProgram is built from deferred_vert.glsl and oit_composite_frag.glsl, @resolveProgram from deferred_vert.glsl and
+* oit_resolve_frag.glsl, only when the linked lists are supported
+* @heads is the first fragment of the list of every pixel and @nodes the fragments of all the lists, @counter counts them
+*
+*/
+struct TranslucentShells
+{
+	OITMode mode = OIT_WEIGHTED;
+	int listLayers = 4;
+
+	Framebuffer accumulation;
+	GLuint compositeProgram = 0;
+	GLuint resolveProgram = 0;
+
+	GLuint heads = 0;
+	GLuint headsFBO = 0;
+	GLuint nodes = 0;
+	GLuint counter = 0;
+	int listWidth = 0;
+	int listHeight = 0;
+	GLuint nodeCapacity = 0;
+};
+
+// Sorts the shells from the furthest to the closest to @viewPoint, for OIT_SORTED
+void sortShellsBackToFront(std::vector<SphereInstance>& shells, const glm::vec3& viewPoint);
+
+// Sets the targets and the blending of the mode, the shells are drawn after it with the shell program of the mode
+void beginTranslucency(TranslucentShells& shells, const Framebuffer& scene);
+
+// Blends what the shells left in the targets of the mode over @scene
+void endTranslucency(TranslucentShells& shells, const Framebuffer& scene);
+
+void deleteTranslucentShells(TranslucentShells& shells);
+
+#endif
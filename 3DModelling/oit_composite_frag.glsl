@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 color;
+
+// The sums of the weighted blended shells, see oit.h
+uniform sampler2D accumulation;     //weighted colour and the revealage in the alpha
+uniform sampler2D weights;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 sum = texelFetch(accumulation, pixel, 0);
+    float revealage = sum.a;
+    if (revealage >= 1.0f)
+        discard;
+    // Blended with 1 - alpha and alpha, the frame shows through by the revealage
+    color = vec4(sum.rgb / max(texelFetch(weights, pixel, 0).r, 1e-5f), revealage);
+}
@@ -0,0 +1,63 @@
+#version 430 core
+out vec4 color;
+
+// Sorts the list of fragments of shell_list_frag.glsl of this pixel and blends them front to back
+struct ListNode
+{
+    uint redGreen;
+    uint blueAlpha;
+    float depth;
+    uint next;
+};
+layout (binding = 0, r32ui) uniform readonly uimage2D listHeads;
+layout (std430, binding = 0) readonly buffer ListNodes
+{
+    ListNode nodes[];
+};
+
+// More fragments than this in one pixel are not blended
+const int maxLayers = 32;
+
+void main()
+{
+    uint node = imageLoad(listHeads, ivec2(gl_FragCoord.xy)).r;
+    if (node == 0u)
+        discard;
+
+    vec4 layers[maxLayers];
+    float depths[maxLayers];
+    int count = 0;
+    while (node != 0u && count < maxLayers)
+    {
+        layers[count] = vec4(unpackHalf2x16(nodes[node].redGreen), unpackHalf2x16(nodes[node].blueAlpha));
+        depths[count] = nodes[node].depth;
+        node = nodes[node].next;
+        count++;
+    }
+
+    // Insertion sort from the closest, the lists are short
+    for (int i = 1; i < count; i++)
+    {
+        vec4 layer = layers[i];
+        float depth = depths[i];
+        int j = i - 1;
+        while (j >= 0 && depths[j] > depth)
+        {
+            layers[j + 1] = layers[j];
+            depths[j + 1] = depths[j];
+            j--;
+        }
+        layers[j + 1] = layer;
+        depths[j + 1] = depth;
+    }
+
+    vec3 result = vec3(0.0f);
+    float transmittance = 1.0f;
+    for (int i = 0; i < count; i++)
+    {
+        result += transmittance * layers[i].a * layers[i].rgb;
+        transmittance *= 1.0f - layers[i].a;
+    }
+    // Blended with 1 and alpha, the frame shows through by the transmittance
+    color = vec4(result, transmittance);
+}
@@ -0,0 +1,36 @@
+#ifndef parallel_H
+#define parallel_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/*
+* Splits [0, count) in one contiguous range per thread and calls work(begin, end) for each range.
+* The calling thread takes the first range, so with one thread (or a small count) nothing is started.
+* @threadCount of 0 uses every core of the machine
+*
+*/
+template <typename Work>
+void parallelFor(size_t count, Work work, unsigned threadCount = 0) {
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	if ((size_t)threadCount > count)
+		threadCount = (unsigned)std::max<size_t>(count, 1);
+
+	size_t chunk = (count + threadCount - 1) / threadCount;
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < threadCount; t++) {
+		size_t begin = t * chunk;
+		size_t end = std::min(count, begin + chunk);
+		if (begin >= end)
+			break;
+		threads.push_back(std::thread(work, begin, end));
+	}
+	work((size_t)0, std::min(count, chunk));
+	for (size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+}
+
+#endif
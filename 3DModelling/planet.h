@@ -0,0 +1,54 @@
+#ifndef planet_H
+#define planet_H
+
+/* Orbital Elements
+* 
+* Describes an ellipse in the XZ plane with the origin at one focus, like a planet around its star
+* @semiMajorAxis is half of the longest diameter of the ellipse
+* @eccentricity is 0 for a circle and gets closer to 1 as the ellipse gets longer
+* @period is how many seconds one orbit takes
+* @phase is the mean anomaly at the time 0 in radians, where on the orbit the planet starts
+* @periapsisAngle is the direction of the closest point to the origin, measured from the X axis towards Z
+* @height moves the plane of the ellipse along Y, so the Planets of a 3D layout keep their height while they orbit
+* 
+*/
+struct OrbitalElements
+{
+	double semiMajorAxis = 1;
+	double eccentricity = 0;
+	double period = 1;
+	double phase = 0;
+	double periapsisAngle = 0;
+	double height = 0;
+};
+
+/* Spheres Structure
+* 
+* This is the struct that is used to build all the Spheres in the program feel free to change if you need anything else
+* It holds values for the standard radius of 1.
+* The position which is changed in setPlanetsProperties()
+* The id is incremented with the new creation of each sphere
+* The RGB colour is also stored and currently set randomly in the setPlanetsProperties()
+* @emissive is how bright the Sphere glows, above 1 it is brighter than the screen can show and blooms, see generatePlanetEmissive()
+* The velocity and mass are only used when the gravity simulation is turned on, see nbody.h
+* When @hasOrbit is true the position in the XZ plane can be animated by its @orbit, see kepler.h
+* @parent is the index of the Planet the orbit goes around (for a moon), -1 goes around the center of the scene
+* 
+*/ 
+struct Planet
+{
+	double radius = 1;
+	double xpos, ypos, zpos;
+	int id = 0;
+	float red;
+	float green;
+	float blue;
+	float emissive = 1.0f;
+	double xvel = 0, yvel = 0, zvel = 0;
+	double mass = 1;
+	bool hasOrbit = false;
+	OrbitalElements orbit;
+	int parent = -1;
+};
+
+#endif
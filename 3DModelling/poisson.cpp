@@ -0,0 +1,378 @@
+// Poisson disk sampling based on Bridson "Fast Poisson Disk Sampling in Arbitrary Dimensions"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "poisson.h"
+#include "generate.h"
+#include "parallel.h"
+#include "rng.h"
+
+const double poissonPi = 3.14159265358979323846;
+
+/*Poisson disk variables
+*
+* @poissonAreaPerSample is about the area a sample takes in 2D in units of the squared spacing, and @poissonVolumePerSample
+* the volume in 3D in units of the cubed spacing. They size the ball before the sampling, when it fills up too early it grows.
+* @poissonGrowth is how much the radius of the ball grows when it is full
+* @poissonTiledMargin makes the first ball of the tiled sampling bigger, the tiles start again from nothing when it is too small
+*
+*/
+const double poissonAreaPerSample = 1.45;
+const double poissonVolumePerSample = 1.8;
+const double poissonGrowth = 1.2;
+const double poissonTiledMargin = 1.1;
+
+/* Poisson Grid
+*
+* Background grid of the sampling, a cell holds a list of the samples whose center is inside it.
+* The cells are as big as the biggest spacing, so only the cells next to a candidate can hold a sample that is too close.
+* @head is the first sample of every cell (-1 when empty) and @next the next sample of the same cell
+*
+*/
+struct PoissonGrid
+{
+	int dimensions;
+	double cellSize;
+	double origin;
+	int side;
+	std::vector<int> head;
+	std::vector<int> next;
+};
+
+static double startingBound(size_t count, double spacing, int dimensions) {
+
+	if (dimensions == 3)
+		return cbrt(count * poissonVolumePerSample * 3.0 / (4.0 * poissonPi)) * spacing + spacing;
+	return sqrt(count * poissonAreaPerSample / poissonPi) * spacing + spacing;
+}
+
+/*
+* A random point at a distance between minDistance and twice minDistance from the center, the candidates of Bridson
+*
+*/
+static glm::dvec3 candidateAround(const glm::dvec3& center, double minDistance, int dimensions, uint64_t seed, uint64_t counter) {
+
+	double distance = minDistance * (1.0 + randomDouble(seed, counter, STREAM_POISSON_DISTANCE));
+	double angle = 2.0 * poissonPi * randomDouble(seed, counter, STREAM_POISSON_ANGLE);
+	if (dimensions == 2)
+		return center + glm::dvec3(cos(angle), 0.0, sin(angle)) * distance;
+	double y = 2.0 * randomDouble(seed, counter, STREAM_POISSON_HEIGHT) - 1.0;
+	double ring = sqrt(std::max(0.0, 1.0 - y * y));
+	return center + glm::dvec3(ring * cos(angle), y, ring * sin(angle)) * distance;
+}
+
+static inline glm::ivec3 gridCell(const PoissonGrid& grid, const glm::dvec3& position) {
+
+	glm::ivec3 cell = glm::ivec3(glm::floor((position - grid.origin) / grid.cellSize));
+	cell = glm::clamp(cell, glm::ivec3(0), glm::ivec3(grid.side - 1));
+	if (grid.dimensions == 2)
+		cell.y = 0;
+	return cell;
+}
+
+static inline size_t gridIndex(const PoissonGrid& grid, const glm::ivec3& cell) {
+	return ((size_t)cell.z * (grid.dimensions == 3 ? grid.side : 1) + cell.y) * grid.side + cell.x;
+}
+
+static void buildPoissonGrid(PoissonGrid& grid, const std::vector<glm::dvec3>& positions, size_t placed, double bound) {
+
+	grid.origin = -bound;
+	grid.side = (int)ceil(2.0 * bound / grid.cellSize) + 1;
+	size_t cells = (size_t)grid.side * grid.side * (grid.dimensions == 3 ? grid.side : 1);
+	grid.head.assign(cells, -1);
+	for (size_t i = 0; i < placed; i++) {
+		size_t index = gridIndex(grid, gridCell(grid, positions[i]));
+		grid.next[i] = grid.head[index];
+		grid.head[index] = (int)i;
+	}
+}
+
+static bool fitsInGrid(const PoissonGrid& grid, const std::vector<glm::dvec3>& positions, const Planet* planets,
+	const glm::dvec3& candidate, double radius, double gap) {
+
+	glm::ivec3 cell = gridCell(grid, candidate);
+	glm::ivec3 low = glm::max(cell - 1, glm::ivec3(0));
+	glm::ivec3 high = glm::min(cell + 1, glm::ivec3(grid.side - 1));
+	if (grid.dimensions == 2)
+		high.y = 0;
+	for (int z = low.z; z <= high.z; z++) {
+		for (int y = low.y; y <= high.y; y++) {
+			for (int x = low.x; x <= high.x; x++) {
+				for (int j = grid.head[gridIndex(grid, glm::ivec3(x, y, z))]; j >= 0; j = grid.next[j]) {
+					glm::dvec3 d = positions[j] - candidate;
+					double minDistance = radius + planets[j].radius + gap;
+					if (glm::dot(d, d) < minDistance * minDistance)
+						return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void poissonDiskLayout(Planet* planets, size_t count, const PoissonSettings& settings) {
+
+	if (count == 0)
+		return;
+	int dimensions = settings.dimensions == 3 ? 3 : 2;
+	double maxRadius = 0.0;
+	double averageRadius = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		maxRadius = std::max(maxRadius, planets[i].radius);
+		averageRadius += planets[i].radius / count;
+	}
+
+	PoissonGrid grid;
+	grid.dimensions = dimensions;
+	grid.cellSize = 2.0 * maxRadius + settings.gap;
+	grid.next.assign(count, -1);
+	std::vector<glm::dvec3> positions(count);
+	std::vector<size_t> active;
+	double bound = startingBound(count, 2.0 * averageRadius + settings.gap, dimensions);
+	size_t placed = 1;
+	positions[0] = glm::dvec3(0.0);
+	uint64_t counter = 0;
+
+	double lastBound = 0.0;
+	while (placed < count) {
+		// After the ball grows the samples on its old edge are active again, they are the only ones that can reach the new space
+		buildPoissonGrid(grid, positions, placed, bound);
+		active.clear();
+		for (size_t i = 0; i < placed; i++) {
+			if (glm::length(positions[i]) > lastBound - 3.0 * grid.cellSize)
+				active.push_back(i);
+		}
+		lastBound = bound;
+
+		while (!active.empty() && placed < count) {
+			size_t pick = (size_t)(randomDouble(settings.seed, counter++, STREAM_POISSON_PICK) * active.size());
+			size_t around = active[pick];
+			double radius = planets[placed].radius;
+			double minDistance = planets[around].radius + radius + settings.gap;
+			bool found = false;
+			for (int attempt = 0; attempt < settings.attempts && !found; attempt++) {
+				glm::dvec3 candidate = candidateAround(positions[around], minDistance, dimensions, settings.seed, counter++);
+				if (glm::length(candidate) > bound - radius || !fitsInGrid(grid, positions, planets, candidate, radius, settings.gap))
+					continue;
+				positions[placed] = candidate;
+				size_t index = gridIndex(grid, gridCell(grid, candidate));
+				grid.next[placed] = grid.head[index];
+				grid.head[index] = (int)placed;
+				active.push_back(placed);
+				placed++;
+				found = true;
+			}
+			if (!found) {
+				active[pick] = active.back();
+				active.pop_back();
+			}
+		}
+		bound *= poissonGrowth;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		planets[i].xpos = positions[i].x;
+		planets[i].ypos = positions[i].y;
+		planets[i].zpos = positions[i].z;
+	}
+}
+
+/* Poisson Tiles
+*
+* Grid of the tiled sampling, the cells are the spacing / sqrt(dimensions) of Bridson so a cell holds at most one sample.
+* @cells is the code of the sample in every cell, the tile times @tileCapacity plus its index in @points of the tile
+* @points are the samples of every tile, a tile only writes to its own cells and points
+*
+*/
+struct PoissonTiles
+{
+	int dimensions;
+	double spacing;
+	double cellSize;
+	double origin;
+	double bound;
+	int side;
+	int tileCells;
+	int tilesPerSide;
+	unsigned tileCapacity;
+	std::vector<unsigned> cells;
+	std::vector<std::vector<glm::dvec3>> points;
+};
+
+const unsigned emptyPoissonCell = 0xFFFFFFFFu;
+
+static inline size_t tileCellIndex(const PoissonTiles& tiles, const glm::ivec3& cell) {
+	return ((size_t)cell.z * (tiles.dimensions == 3 ? tiles.side : 1) + cell.y) * tiles.side + cell.x;
+}
+
+static bool fitsInTiles(const PoissonTiles& tiles, const glm::dvec3& candidate, const glm::ivec3& cell) {
+
+	// A sample closer than the spacing is at most sqrt(dimensions) cells away, so 2 cells around are enough
+	glm::ivec3 low = glm::max(cell - 2, glm::ivec3(0));
+	glm::ivec3 high = glm::min(cell + 2, glm::ivec3(tiles.side - 1));
+	if (tiles.dimensions == 2)
+		high.y = 0;
+	double spacing2 = tiles.spacing * tiles.spacing;
+	for (int z = low.z; z <= high.z; z++) {
+		for (int y = low.y; y <= high.y; y++) {
+			for (int x = low.x; x <= high.x; x++) {
+				unsigned code = tiles.cells[tileCellIndex(tiles, glm::ivec3(x, y, z))];
+				if (code == emptyPoissonCell)
+					continue;
+				glm::dvec3 d = tiles.points[code / tiles.tileCapacity][code % tiles.tileCapacity] - candidate;
+				if (glm::dot(d, d) < spacing2)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*
+* Bridson inside one tile. The samples that the tiles of the earlier colours placed near the border are active too,
+* so the tile fills the space up to them instead of leaving a seam.
+*
+*/
+static void fillPoissonTile(PoissonTiles& tiles, unsigned tile, const glm::ivec3& tileCoord, const PoissonSettings& settings, uint64_t seed) {
+
+	glm::ivec3 low = tileCoord * tiles.tileCells;
+	glm::ivec3 high = low + tiles.tileCells - 1;
+	if (tiles.dimensions == 2) {
+		low.y = 0;
+		high.y = 0;
+	}
+	glm::dvec3 tileMin = tiles.origin + glm::dvec3(low) * tiles.cellSize;
+	glm::dvec3 tileMax = tiles.origin + glm::dvec3(high + 1) * tiles.cellSize;
+	if (tiles.dimensions == 2) {
+		tileMin.y = 0.0;
+		tileMax.y = 0.0;
+	}
+	double limit = tiles.bound - tiles.spacing * 0.5;
+	// A tile that is completely outside the ball gets no samples
+	glm::dvec3 closest = glm::clamp(glm::dvec3(0.0), tileMin, tileMax);
+	if (glm::length(closest) > limit)
+		return;
+
+	std::vector<glm::dvec3> active;
+	int seedReach = (int)ceil(2.0 * sqrt((double)tiles.dimensions));
+	glm::ivec3 ringLow = glm::max(low - seedReach, glm::ivec3(0));
+	glm::ivec3 ringHigh = glm::min(high + seedReach, glm::ivec3(tiles.side - 1));
+	if (tiles.dimensions == 2)
+		ringHigh.y = 0;
+	for (int z = ringLow.z; z <= ringHigh.z; z++) {
+		for (int y = ringLow.y; y <= ringHigh.y; y++) {
+			for (int x = ringLow.x; x <= ringHigh.x; x++) {
+				unsigned code = tiles.cells[tileCellIndex(tiles, glm::ivec3(x, y, z))];
+				if (code != emptyPoissonCell)
+					active.push_back(tiles.points[code / tiles.tileCapacity][code % tiles.tileCapacity]);
+			}
+		}
+	}
+
+	std::vector<glm::dvec3>& points = tiles.points[tile];
+	uint64_t counter = (uint64_t)tile << 32;
+	auto tryInsert = [&](const glm::dvec3& candidate) {
+		glm::ivec3 cell = glm::ivec3(glm::floor((candidate - tiles.origin) / tiles.cellSize));
+		if (tiles.dimensions == 2)
+			cell.y = 0;
+		if (glm::any(glm::lessThan(cell, low)) || glm::any(glm::greaterThan(cell, high)) || glm::length(candidate) > limit)
+			return false;
+		if (!fitsInTiles(tiles, candidate, cell))
+			return false;
+		tiles.cells[tileCellIndex(tiles, cell)] = tile * tiles.tileCapacity + (unsigned)points.size();
+		points.push_back(candidate);
+		active.push_back(candidate);
+		return true;
+	};
+
+	// One random sample starts the tiles that have no neighbour sample yet
+	for (int attempt = 0; attempt < settings.attempts; attempt++) {
+		glm::dvec3 u(randomDouble(seed, counter, STREAM_POISSON_DISTANCE), randomDouble(seed, counter, STREAM_POISSON_ANGLE),
+			randomDouble(seed, counter, STREAM_POISSON_HEIGHT));
+		counter++;
+		glm::dvec3 candidate = tileMin + u * (tileMax - tileMin);
+		if (tryInsert(candidate))
+			break;
+	}
+
+	while (!active.empty()) {
+		size_t pick = (size_t)(randomDouble(seed, counter++, STREAM_POISSON_PICK) * active.size());
+		glm::dvec3 around = active[pick];
+		bool found = false;
+		for (int attempt = 0; attempt < settings.attempts && !found; attempt++)
+			found = tryInsert(candidateAround(around, tiles.spacing, tiles.dimensions, seed, counter++));
+		if (!found) {
+			active[pick] = active.back();
+			active.pop_back();
+		}
+	}
+}
+
+void poissonDiskLayoutTiled(Planet* planets, size_t count, const PoissonSettings& settings) {
+
+	if (count == 0)
+		return;
+	double maxRadius = 0.0;
+	for (size_t i = 0; i < count; i++)
+		maxRadius = std::max(maxRadius, planets[i].radius);
+
+	PoissonTiles tiles;
+	tiles.dimensions = settings.dimensions == 3 ? 3 : 2;
+	tiles.spacing = 2.0 * maxRadius + settings.gap;
+	tiles.cellSize = tiles.spacing / sqrt((double)tiles.dimensions);
+	// Two tiles of the same colour are one tile apart, which must be at least the 4 cells a tile reads around itself
+	tiles.tileCells = std::max(settings.tileCells, 4);
+	// Starting a bit too big is cheaper than filling every tile a second time, the extra samples are thrown away
+	tiles.bound = startingBound(count, tiles.spacing, tiles.dimensions) * poissonTiledMargin;
+	int colours = 1 << tiles.dimensions;
+
+	std::vector<glm::dvec3> samples;
+	for (uint64_t round = 0; ; round++) {
+		tiles.tilesPerSide = (int)ceil(2.0 * tiles.bound / (tiles.cellSize * tiles.tileCells));
+		tiles.side = tiles.tilesPerSide * tiles.tileCells;
+		tiles.origin = -0.5 * tiles.side * tiles.cellSize;
+		tiles.tileCapacity = (unsigned)pow((double)tiles.tileCells, tiles.dimensions);
+		size_t tileCount = (size_t)pow((double)tiles.tilesPerSide, tiles.dimensions);
+		tiles.cells.assign((size_t)pow((double)tiles.side, tiles.dimensions), emptyPoissonCell);
+		tiles.points.assign(tileCount, std::vector<glm::dvec3>());
+		uint64_t seed = splitMix64(settings.seed + round);
+
+		for (int colour = 0; colour < colours; colour++) {
+			std::vector<unsigned> colourTiles;
+			for (unsigned t = 0; t < tileCount; t++) {
+				glm::ivec3 coord(t % tiles.tilesPerSide, t / tiles.tilesPerSide % tiles.tilesPerSide, t / (tiles.tilesPerSide * tiles.tilesPerSide));
+				if ((coord.x & 1) + ((coord.y & 1) << 1) + ((coord.z & 1) << 2) == colour)
+					colourTiles.push_back(t);
+			}
+			parallelFor(colourTiles.size(), [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					unsigned t = colourTiles[i];
+					glm::ivec3 coord(t % tiles.tilesPerSide, t / tiles.tilesPerSide % tiles.tilesPerSide, t / (tiles.tilesPerSide * tiles.tilesPerSide));
+					if (tiles.dimensions == 2)
+						coord = glm::ivec3(coord.x, 0, coord.y);
+					fillPoissonTile(tiles, t, coord, settings, seed);
+				}
+			}, settings.threadCount);
+		}
+
+		samples.clear();
+		for (size_t t = 0; t < tileCount; t++)
+			samples.insert(samples.end(), tiles.points[t].begin(), tiles.points[t].end());
+		if (samples.size() >= count)
+			break;
+		tiles.bound *= poissonGrowth;
+	}
+
+	// The samples closest to the center are kept, sorted by distance so the first Planet is in the middle like the spiral
+	auto closer = [](const glm::dvec3& a, const glm::dvec3& b) { return glm::dot(a, a) < glm::dot(b, b); };
+	std::nth_element(samples.begin(), samples.begin() + (count - 1), samples.end(), closer);
+	std::sort(samples.begin(), samples.begin() + count, closer);
+	for (size_t i = 0; i < count; i++) {
+		planets[i].xpos = samples[i].x;
+		planets[i].ypos = samples[i].y;
+		planets[i].zpos = samples[i].z;
+	}
+}
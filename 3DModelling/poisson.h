@@ -0,0 +1,39 @@
+#ifndef poisson_H
+#define poisson_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "planet.h"
+
+/* Poisson Disk Settings
+*
+* Places the Planets so no two of them overlap, with Bridson "Fast Poisson Disk Sampling in Arbitrary Dimensions".
+* The samples grow outwards from the center until every Planet is placed, so the first Planet is always at the center.
+* @dimensions is 2 for a disc in the XZ plane or 3 for a ball
+* @gap is the smallest empty space between the surfaces of two Planets
+* @attempts is how many candidates are tried around a sample before it stops being active, Bridson uses 30
+* @tiled splits the space in tiles that are filled in parallel, it is meant for millions of Planets.
+* The tiles only support a single size, so every Planet is spaced for the biggest radius.
+* @tileCells is the size of a tile in cells of the grid
+* @threadCount is how many threads fill the tiles, 0 uses every core
+*
+*/
+struct PoissonSettings
+{
+	int dimensions = 2;
+	double gap = 0.5;
+	int attempts = 30;
+	uint64_t seed = 1;
+	bool tiled = false;
+	int tileCells = 32;
+	unsigned threadCount = 0;
+};
+
+// One Planet at a time, every candidate keeps the radius of the Planet it is for so the sizes can be mixed
+void poissonDiskLayout(Planet* planets, size_t count, const PoissonSettings& settings);
+
+// Tiles of the same colour of a checkerboard are filled at the same time, then the next colour fills the gaps next to them
+void poissonDiskLayoutTiled(Planet* planets, size_t count, const PoissonSettings& settings);
+
+#endif
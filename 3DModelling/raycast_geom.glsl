@@ -0,0 +1,73 @@
+#version 330 core
+layout (points) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+in vec3 CenterView[];
+in float Radius[];
+in vec3 ObjectColorIn[];
+in vec3 LightColorIn[];
+in vec3 LightPosIn[];
+
+out vec3 ViewRay;
+flat out vec3 SphereCenter;
+flat out float SphereRadius;
+flat out vec3 ObjectColor;
+flat out vec3 LightColor;
+flat out vec3 LightPos;
+
+uniform mat4 projection;
+
+const vec2 corners[4] = vec2[4](vec2(-1.0f, -1.0f), vec2(1.0f, -1.0f), vec2(-1.0f, 1.0f), vec2(1.0f, 1.0f));
+
+void emitCorner(vec3 viewPos)
+{
+    ViewRay = viewPos;
+    gl_Position = projection * vec4(viewPos, 1.0f);
+    SphereCenter = CenterView[0];
+    SphereRadius = Radius[0];
+    ObjectColor = ObjectColorIn[0];
+    LightColor = LightColorIn[0];
+    LightPos = LightPosIn[0];
+    EmitVertex();
+}
+
+void main()
+{
+    vec3 center = CenterView[0];
+    float radius = Radius[0];
+    float dist = length(center);
+    // The camera is inside the Sphere, there is nothing to draw
+    if (dist <= radius)
+        return;
+
+    // The square around the silhouette circle of the Sphere, see impostor_vert.glsl
+    vec3 forward = center / dist;
+    vec3 up = abs(forward.y) > 0.99f ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+    vec3 right = normalize(cross(forward, up));
+    up = cross(right, forward);
+    float halfSize = radius * dist / sqrt(dist * dist - radius * radius);
+
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    if (-center.z - halfSize * 1.5f <= nearPlane) {
+        // The square may cross the near plane where the projection breaks, use the camera facing square itself instead
+        for (int i = 0; i < 4; i++)
+            emitCorner(center + (right * corners[i].x + up * corners[i].y) * halfSize);
+        EndPrimitive();
+        return;
+    }
+
+    // Screen space bounds of the square, then the rectangle is rebuilt at the depth of the center so the rays stay exact
+    vec2 minimum = vec2(1.0e20f);
+    vec2 maximum = vec2(-1.0e20f);
+    for (int i = 0; i < 4; i++) {
+        vec4 clip = projection * vec4(center + (right * corners[i].x + up * corners[i].y) * halfSize, 1.0f);
+        minimum = min(minimum, clip.xy / clip.w);
+        maximum = max(maximum, clip.xy / clip.w);
+    }
+    for (int i = 0; i < 4; i++) {
+        vec2 ndc = mix(minimum, maximum, corners[i] * 0.5f + 0.5f);
+        vec3 viewPos = vec3(ndc.x * -center.z / projection[0][0], ndc.y * -center.z / projection[1][1], center.z);
+        emitCorner(viewPos);
+    }
+    EndPrimitive();
+}
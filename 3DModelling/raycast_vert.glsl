@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec4 centerRadius;
+layout (location = 1) in vec3 objectColor;
+layout (location = 2) in vec3 lightColor;
+layout (location = 3) in vec3 lightPos;
+
+out vec3 CenterView;
+out float Radius;
+out vec3 ObjectColorIn;
+out vec3 LightColorIn;
+out vec3 LightPosIn;
+
+uniform mat4 model;
+uniform mat4 view;
+
+// Every Sphere is a single point, raycast_geom.glsl turns it into the quad that covers it on the screen
+void main()
+{
+    CenterView = vec3(view * model * vec4(centerRadius.xyz, 1.0f));
+    Radius = centerRadius.w;
+    ObjectColorIn = objectColor;
+    LightColorIn = lightColor;
+    // frag.glsl compares lightPos with the rotated FragPos directly, so only the view matrix is applied here
+    LightPosIn = vec3(view * vec4(lightPos, 1.0f));
+    gl_Position = vec4(CenterView, 1.0f);
+}
@@ -0,0 +1,36 @@
+#ifndef rng_H
+#define rng_H
+
+#include <cstdint>
+
+/*
+* Counter based random numbers, every number is a pure function of a seed, a counter and a stream.
+* There is no state to share between threads, so work split in any way over any amount of threads gives the same numbers.
+* The mixing function is the finalizer of SplitMix64 from Steele et al. "Fast Splittable Pseudorandom Number Generators".
+* @stream separates the different properties of the same object, for example one stream per colour channel
+*
+*/
+
+inline uint64_t splitMix64(uint64_t x) {
+
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+inline uint64_t randomBits(uint64_t seed, uint64_t counter, uint64_t stream) {
+	return splitMix64(splitMix64(seed ^ splitMix64(stream)) + counter * 0x9E3779B97F4A7C15ull);
+}
+
+// Uniform in [0, 1) with every one of the 53 bits of the mantissa random
+inline double randomDouble(uint64_t seed, uint64_t counter, uint64_t stream) {
+	return (double)(randomBits(seed, counter, stream) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Uniform in [0, 1) with 24 random bits
+inline float randomFloat(uint64_t seed, uint64_t counter, uint64_t stream) {
+	return (float)(randomBits(seed, counter, stream) >> 40) * (1.0f / 16777216.0f);
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include <algorithm>
+
+#include "scenegraph.h"
+
+// glm.hpp has to come first, it sets up the macros this header uses
+#include <glm/simd/matrix.h>
+
+int addSceneNode(SceneGraph& scene, int parent, const glm::mat4& local) {
+
+	int handle = (int)scene.nodes.size();
+	int slot = (int)scene.parents.size();
+	// The parent already has a slot, so appending keeps parents before children even before sorting
+	scene.parents.push_back(parent >= 0 ? scene.slots[parent] : -1);
+	scene.locals.push_back(local);
+	scene.worlds.push_back(local);
+	scene.dirty.push_back(1);
+	scene.slots.push_back(slot);
+	scene.nodes.push_back(handle);
+	scene.sorted = false;
+	return handle;
+}
+
+void setLocalTransform(SceneGraph& scene, int node, const glm::mat4& local) {
+
+	int slot = scene.slots[node];
+	scene.locals[slot] = local;
+	scene.dirty[slot] = 1;
+}
+
+const glm::mat4& worldTransform(const SceneGraph& scene, int node) {
+	return scene.worlds[scene.slots[node]];
+}
+
+void clearSceneGraph(SceneGraph& scene) {
+
+	scene.parents.clear();
+	scene.locals.clear();
+	scene.worlds.clear();
+	scene.dirty.clear();
+	scene.slots.clear();
+	scene.nodes.clear();
+	scene.sorted = true;
+}
+
+void sortSceneGraph(SceneGraph& scene) {
+
+	size_t count = scene.parents.size();
+
+	// Children of every slot in a compressed list, in the order of their slots
+	std::vector<int> childStart(count + 1, 0);
+	for (size_t s = 0; s < count; s++) {
+		if (scene.parents[s] >= 0)
+			childStart[scene.parents[s] + 1]++;
+	}
+	for (size_t s = 0; s < count; s++)
+		childStart[s + 1] += childStart[s];
+	std::vector<int> children(childStart[count]);
+	std::vector<int> next(childStart.begin(), childStart.end() - 1);
+	for (size_t s = 0; s < count; s++) {
+		if (scene.parents[s] >= 0)
+			children[next[scene.parents[s]]++] = (int)s;
+	}
+
+	// The order itself is the queue of the breadth first search
+	std::vector<int> order;
+	order.reserve(count);
+	for (size_t s = 0; s < count; s++) {
+		if (scene.parents[s] < 0)
+			order.push_back((int)s);
+	}
+	for (size_t head = 0; head < order.size(); head++) {
+		int s = order[head];
+		order.insert(order.end(), children.begin() + childStart[s], children.begin() + childStart[s + 1]);
+	}
+
+	std::vector<int> newSlot(count);
+	for (size_t k = 0; k < count; k++)
+		newSlot[order[k]] = (int)k;
+
+	std::vector<int> parents(count);
+	std::vector<glm::mat4> locals(count), worlds(count);
+	std::vector<unsigned char> dirty(count);
+	std::vector<int> nodes(count);
+	for (size_t k = 0; k < count; k++) {
+		int s = order[k];
+		parents[k] = scene.parents[s] >= 0 ? newSlot[scene.parents[s]] : -1;
+		locals[k] = scene.locals[s];
+		worlds[k] = scene.worlds[s];
+		dirty[k] = scene.dirty[s];
+		nodes[k] = scene.nodes[s];
+		scene.slots[nodes[k]] = (int)k;
+	}
+	scene.parents.swap(parents);
+	scene.locals.swap(locals);
+	scene.worlds.swap(worlds);
+	scene.dirty.swap(dirty);
+	scene.nodes.swap(nodes);
+	scene.sorted = true;
+}
+
+/*
+* glm::mat4 isn't aligned so the columns are loaded unaligned into the SSE2 registers of glm_mat4_mul.
+* Siblings are next to each other after the breadth first sort, so the columns of their parent are only loaded once.
+*
+*/
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+static size_t updateWorldTransformsSSE2(SceneGraph& scene) {
+
+	size_t count = scene.parents.size();
+	size_t updated = 0;
+	int loadedParent = -1;
+	glm_vec4 parentColumns[4], local[4], world[4];
+	for (size_t s = 0; s < count; s++) {
+		int parent = scene.parents[s];
+		if (parent >= 0 && scene.dirty[parent])
+			scene.dirty[s] = 1;
+		if (!scene.dirty[s])
+			continue;
+		if (parent < 0) {
+			scene.worlds[s] = scene.locals[s];
+		}
+		else
+		{
+			if (parent != loadedParent) {
+				for (int c = 0; c < 4; c++)
+					parentColumns[c] = _mm_loadu_ps(&scene.worlds[parent][c][0]);
+				loadedParent = parent;
+			}
+			for (int c = 0; c < 4; c++)
+				local[c] = _mm_loadu_ps(&scene.locals[s][c][0]);
+			glm_mat4_mul(parentColumns, local, world);
+			for (int c = 0; c < 4; c++)
+				_mm_storeu_ps(&scene.worlds[s][c][0], world[c]);
+		}
+		updated++;
+	}
+	return updated;
+}
+#endif
+
+void updateWorldTransforms(SceneGraph& scene) {
+
+	if (!scene.sorted)
+		sortSceneGraph(scene);
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	if (scene.useSimd) {
+		scene.updatedCount = updateWorldTransformsSSE2(scene);
+		std::fill(scene.dirty.begin(), scene.dirty.end(), 0);
+		return;
+	}
+#endif
+
+	// A slot is recomputed when its own local changed or its parent was recomputed in this pass,
+	// the parent is always earlier in the arrays so its flag is already final
+	size_t count = scene.parents.size();
+	size_t updated = 0;
+	for (size_t s = 0; s < count; s++) {
+		int parent = scene.parents[s];
+		if (parent >= 0 && scene.dirty[parent])
+			scene.dirty[s] = 1;
+		if (!scene.dirty[s])
+			continue;
+		if (parent >= 0)
+			scene.worlds[s] = scene.worlds[parent] * scene.locals[s];
+		else
+			scene.worlds[s] = scene.locals[s];
+		updated++;
+	}
+	std::fill(scene.dirty.begin(), scene.dirty.end(), 0);
+	scene.updatedCount = updated;
+}
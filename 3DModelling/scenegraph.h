@@ -0,0 +1,47 @@
+#ifndef scenegraph_H
+#define scenegraph_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/* Scene Graph
+*
+* Hierarchy of transforms, like moons that orbit planets that orbit stars.
+* A node is referred to by the handle addSceneNode() returned, the arrays themselves are indexed by slot.
+* The slots are sorted breadth first so every parent comes before its children and siblings are next to each other,
+* that way the world matrices are all updated in one pass from the start to the end of the arrays.
+* @parents is the slot of the parent of every slot, -1 for the roots
+* @locals are the transforms relative to the parent and @worlds the transforms relative to the roots
+* @dirty marks the slots whose local transform changed since the last update
+* @slots is the slot of every handle and @nodes the handle of every slot
+* @sorted is false after nodes were added, the next update sorts the slots again
+* @useSimd multiplies the matrices with the SSE2 kernel of glm when it is available
+* @updatedCount is how many world matrices the last update computed, the subtrees that didn't move are skipped
+*
+*/
+struct SceneGraph
+{
+	std::vector<int> parents;
+	std::vector<glm::mat4> locals, worlds;
+	std::vector<unsigned char> dirty;
+	std::vector<int> slots;
+	std::vector<int> nodes;
+	bool sorted = true;
+	bool useSimd = true;
+	size_t updatedCount = 0;
+};
+
+// Adds a node under @parent (a handle or -1 for a root) and returns its handle
+int addSceneNode(SceneGraph& scene, int parent, const glm::mat4& local);
+void setLocalTransform(SceneGraph& scene, int node, const glm::mat4& local);
+const glm::mat4& worldTransform(const SceneGraph& scene, int node);
+void clearSceneGraph(SceneGraph& scene);
+
+// Moves the slots in breadth first order, the handles stay the same
+void sortSceneGraph(SceneGraph& scene);
+
+// Computes the world matrices of the dirty nodes and of everything below them
+void updateWorldTransforms(SceneGraph& scene);
+
+#endif
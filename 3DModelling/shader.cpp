@@ -4,83 +4,323 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 #define GLEW_STATIC
 #include <GL/glew.h>
 
 #include <GLFW/glfw3.h>
 
-GLuint initShader(const GLchar* vertexPath, const GLchar* fragmentPath){
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader.h"
+
+ShaderCache shaderCache;
+
+/*Shader cache variables
+*
+* @shaderCacheMagic starts every file of the cache so a file that is not a program binary is never given to the driver
+*
+*/
+const uint32_t shaderCacheMagic = 0x43524853;
 
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
+/*
+* Reads the whole file into a string, an empty string is returned if it can't be read
+*
+*/
+std::string readShaderFile(const GLchar* path) {
+
+	std::string code;
+	std::ifstream shaderFile;
 	// ensures ifstream objects can throw exceptions:
-	vShaderFile.exceptions(std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::badbit);
+	shaderFile.exceptions(std::ifstream::badbit);
 	try
 	{
-		// Open files
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
-		// Read file's buffer contents into streams
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-		// close file handlers
-		vShaderFile.close();
-		fShaderFile.close();
+		// Open file
+		shaderFile.open(path);
+		std::stringstream shaderStream;
+		// Read file's buffer contents into stream
+		shaderStream << shaderFile.rdbuf();
+		// close file handler
+		shaderFile.close();
 		// Convert stream into string
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
+		code = shaderStream.str();
 	}
 	catch (std::ifstream::failure e)
 	{
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 	}
+	return code;
+}
+
+/*Shader include variables
+*
+* @maxIncludeDepth stops an #include that includes itself, directly or through other files
+*
+*/
+const int maxIncludeDepth = 16;
+
+static std::string shaderDirectory(const std::string& path) {
+
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+/*
+* Copies the file line by line and replaces the #include lines by the file they name.
+* Every file gets its own source string number in the #line directives, so an error in an included file
+* is reported as "number(line)" where number is the position of the file in @files.
+*
+*/
+static void appendShaderFile(const std::string& path, const std::string& defines, std::string& code, std::vector<std::string>& files, int depth) {
+
+	int fileNumber = (int)files.size();
+	files.push_back(path);
+	std::istringstream source(readShaderFile(path.c_str()));
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(source, line)) {
+		lineNumber++;
+		size_t first = line.find_first_not_of(" \t");
+		if (first != std::string::npos && line.compare(first, 8, "#include") == 0) {
+			size_t open = line.find('"', first);
+			size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+			if (close == std::string::npos || depth >= maxIncludeDepth) {
+				std::cout << "ERROR::SHADER::INCLUDE " << path << "(" << lineNumber << ") " << line << std::endl;
+				continue;
+			}
+			code += "#line 1 " + std::to_string(files.size()) + "\n";
+			appendShaderFile(shaderDirectory(path) + line.substr(open + 1, close - open - 1), "", code, files, depth + 1);
+			code += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileNumber) + "\n";
+			continue;
+		}
+		code += line + "\n";
+		// The defines have to come after #version, which must be the first line of the shader
+		if (!defines.empty() && first != std::string::npos && line.compare(first, 8, "#version") == 0) {
+			code += defines;
+			code += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileNumber) + "\n";
+		}
+	}
+}
+
+std::string preprocessShader(const GLchar* path, const std::string& defines, std::vector<std::string>* files) {
+
+	std::string code;
+	std::vector<std::string> read;
+	appendShaderFile(path, defines, code, read, 0);
+	if (files != NULL)
+		*files = read;
+	return code;
+}
 
-	const GLchar* vertexShaderSource = vertexCode.c_str();
-	const GLchar * fragmentShaderSource = fragmentCode.c_str();
+static bool shaderCacheSupported() {
 
-	// Vertex shader
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	// Check for compile time errors
+	if (!shaderCache.enabled || !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+		return false;
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+static void hashText(uint64_t& hash, const char* text) {
+
+	// FNV-1a, the terminating zero is hashed too so the texts can't run into each other
+	for (const char* c = text != NULL ? text : ""; ; c++) {
+		hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+		if (*c == 0)
+			break;
+	}
+}
+
+static std::string shaderCachePath(const std::string& vertexCode, const std::string& geometryCode, const std::string& fragmentCode) {
+
+	uint64_t hash = 1469598103934665603ull;
+	hashText(hash, vertexCode.c_str());
+	hashText(hash, geometryCode.c_str());
+	hashText(hash, fragmentCode.c_str());
+	hashText(hash, (const char*)glGetString(GL_VENDOR));
+	hashText(hash, (const char*)glGetString(GL_RENDERER));
+	hashText(hash, (const char*)glGetString(GL_VERSION));
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+	return shaderCache.directory + "/" + name;
+}
+
+/*
+* Returns 0 when there is no file or the driver refuses the binary, the program is then compiled from the sources
+*
+*/
+static GLuint loadCachedProgram(const std::string& path) {
+
+	std::ifstream file(path.c_str(), std::ios::binary);
+	uint32_t magic = 0;
+	GLenum format = 0;
+	if (!file.read((char*)&magic, sizeof(magic)) || magic != shaderCacheMagic || !file.read((char*)&format, sizeof(format)))
+		return 0;
+	std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (binary.empty())
+		return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
 	GLint success;
-	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		glDeleteProgram(program);
+		return 0;
 	}
-	// Fragment shader
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	// Check for compile time errors
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+	return program;
+}
+
+static void storeCachedProgram(GLuint program, const std::string& path) {
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, NULL, &format, binary.data());
+
+#ifdef _WIN32
+	_mkdir(shaderCache.directory.c_str());
+#else
+	mkdir(shaderCache.directory.c_str(), 0755);
+#endif
+	std::ofstream file(path.c_str(), std::ios::binary);
+	file.write((const char*)&shaderCacheMagic, sizeof(shaderCacheMagic));
+	file.write((const char*)&format, sizeof(format));
+	file.write(binary.data(), binary.size());
+	if (file)
+		shaderCache.stores++;
+	else
+		std::cout << "ERROR::SHADER::CACHE::WRITE_FAILED " << path << std::endl;
+}
+
+void startProgram(PendingProgram& pending, const std::string code[3]) {
+
+	static const GLenum types[3] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+	pending.fromCache = false;
+	pending.cachePath.clear();
+	for (int s = 0; s < 3; s++)
+		pending.shaders[s] = 0;
+
+	if (shaderCacheSupported()) {
+		pending.cachePath = shaderCachePath(code[0], code[1], code[2]);
+		pending.program = loadCachedProgram(pending.cachePath);
+		if (pending.program != 0) {
+			shaderCache.hits++;
+			pending.fromCache = true;
+			return;
+		}
+		shaderCache.misses++;
 	}
 
-	// Link shaders
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
+	// Nothing here asks the driver for a result, so with parallel compiling the shaders are built while the caller goes on
+	pending.program = glCreateProgram();
+	for (int s = 0; s < 3; s++) {
+		if (code[s].empty())
+			continue;
+		const GLchar* shaderSource = code[s].c_str();
+		pending.shaders[s] = glCreateShader(types[s]);
+		glShaderSource(pending.shaders[s], 1, &shaderSource, NULL);
+		glCompileShader(pending.shaders[s]);
+		glAttachShader(pending.program, pending.shaders[s]);
+	}
+	if (!pending.cachePath.empty()) {
+		glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(pending.program);
+}
+
+bool programReady(const PendingProgram& pending) {
+
+	if (pending.fromCache || !GLEW_ARB_parallel_shader_compile)
+		return true;
+	GLint done = GL_FALSE;
+	glGetProgramiv(pending.program, GL_COMPLETION_STATUS_ARB, &done);
+	return done != GL_FALSE;
+}
+
+bool finishProgram(PendingProgram& pending, std::string& log) {
+
+	static const char* names[3] = { "VERTEX", "GEOMETRY", "FRAGMENT" };
+	if (pending.fromCache)
+		return true;
+	GLchar infoLog[512];
+	for (int s = 0; s < 3; s++) {
+		if (pending.shaders[s] == 0)
+			continue;
+		// Check for compile time errors
+		GLint compiled;
+		glGetShaderiv(pending.shaders[s], GL_COMPILE_STATUS, &compiled);
+		if (!compiled) {
+			glGetShaderInfoLog(pending.shaders[s], 512, NULL, infoLog);
+			log += std::string(names[s]) + "::COMPILATION_FAILED\n" + infoLog;
+		}
+		glDetachShader(pending.program, pending.shaders[s]);
+		glDeleteShader(pending.shaders[s]);
+		pending.shaders[s] = 0;
+	}
 	// Check for linking errors
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+	GLint success;
+	glGetProgramiv(pending.program, GL_LINK_STATUS, &success);
 	if (!success) {
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+		glGetProgramInfoLog(pending.program, 512, NULL, infoLog);
+		log += std::string("PROGRAM::LINKING_FAILED\n") + infoLog;
+		return false;
+	}
+	if (!pending.cachePath.empty()) {
+		storeCachedProgram(pending.program, pending.cachePath);
+	}
+	return true;
+}
+
+/*
+* The geometry shader is optional, pass NULL to build a program with only the vertex and fragment shaders
+* When the shader cache is on the program is loaded from its binary if the same sources were linked before
+*
+*/
+GLuint initShader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath){
+
+	std::string code[3];
+	code[0] = preprocessShader(vertexPath, "");
+	code[1] = geometryPath != NULL ? preprocessShader(geometryPath, "") : std::string();
+	code[2] = preprocessShader(fragmentPath, "");
+
+	PendingProgram pending;
+	startProgram(pending, code);
+	std::string log;
+	if (!finishProgram(pending, log)) {
+		std::cout << "ERROR::SHADER::" << log << std::endl;
 	}
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	return pending.program;
+}
+
+GLuint initShader(const GLchar* vertexPath, const GLchar* fragmentPath){
+
+	return initShader(vertexPath, NULL, fragmentPath);
+}
+
+/*
+* Uploads the model, view and projection matrices to a shader program, the program is left in use
+*
+*/
+void setCameraUniforms(GLuint shader, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
 
-	return shaderProgram;
-}
\ No newline at end of file
+	glUseProgram(shader);
+	GLint modelLoc = glGetUniformLocation(shader, "model");
+	GLint viewLoc = glGetUniformLocation(shader, "view");
+	GLint projLoc = glGetUniformLocation(shader, "projection");
+	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+}
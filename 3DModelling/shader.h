@@ -4,8 +4,67 @@
 #define GLEW_STATIC
 #include <GL/glew.h>
 
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/* Shader Cache
+*
+* Linked programs are saved with glGetProgramBinary and loaded back with glProgramBinary on the next runs,
+* which skips compiling the shaders. The file name is a hash of the sources and of the vendor, renderer and version
+* of the driver, so changing a shader or updating the driver makes a new file instead of loading a stale one.
+* @enabled turns the cache on, it is also off when the driver has no binary formats
+* @directory is where the binaries are stored, it is created when it doesn't exist
+* @hits, @misses and @stores count the programs loaded from the cache, compiled, and saved since the start.
+* They and @enabled are atomic because the shader reload thread can build programs at the same time as the render loop
+*
+*/
+struct ShaderCache
+{
+	std::atomic<bool> enabled{ true };
+	std::string directory = "shadercache";
+	std::atomic<unsigned> hits{ 0 };
+	std::atomic<unsigned> misses{ 0 };
+	std::atomic<unsigned> stores{ 0 };
+};
+
+extern ShaderCache shaderCache;
+
+/* Pending Program
+*
+* A program whose shaders were given to the driver but not checked yet, with GL_ARB_parallel_shader_compile
+* the driver compiles them in its own threads in the meantime.
+* @shaders are the shaders being compiled, all 0 when the program was loaded from the shader cache
+* @cachePath is the file of the program in the shader cache, empty when the cache is off
+*
+*/
+struct PendingProgram
+{
+	GLuint program = 0;
+	GLuint shaders[3] = { 0, 0, 0 };
+	std::string cachePath;
+	bool fromCache = false;
+};
+
 // This is the content of the .h file, which is where the declarations go
+std::string readShaderFile(const GLchar* path);
+
+// Reads a shader and replaces every #include "file" line by that file, the path is relative to the file that includes it.
+// @defines are put right after the #version line and @files gets every file that was read, the shader itself first
+std::string preprocessShader(const GLchar* path, const std::string& defines, std::vector<std::string>* files = NULL);
+
+// Starts building a program from the code of its vertex, geometry (empty for none) and fragment shaders, or loads it from the cache
+void startProgram(PendingProgram& pending, const std::string code[3]);
+// True when finishProgram() won't have to wait for the compiler
+bool programReady(const PendingProgram& pending);
+// Checks the result, saves the program in the cache and frees the shaders, the errors are added to @log
+bool finishProgram(PendingProgram& pending, std::string& log);
+
 GLuint initShader(const GLchar* vertexPath, const GLchar* fragmentPath);
+GLuint initShader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath);
+void setCameraUniforms(GLuint shader, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
 
 					   // This is the end of the header guard
 #endif
\ No newline at end of file
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ctime>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "shaderreload.h"
+#include "shader.h"
+
+/*Shader reload variables
+*
+* @shaderPollMilliseconds is how often the watcher checks the modification times when there is no inotify,
+* with inotify it is how long the watcher waits for an event before it checks if it has to stop
+* @fallbackWaitFrames is how many frames the render loop leaves a rebuild alone when there is neither parallel compiling
+* nor a shared context, the drivers that compile in the background are done by then and checking it doesn't wait
+*
+*/
+const int shaderPollMilliseconds = 250;
+const int fallbackWaitFrames = 2;
+
+/* Watched Program
+*
+* @target is where the caller keeps the program, the swap writes the new program there
+* @paths are the vertex, geometry and fragment files, the geometry path is empty when there is none
+* @defines are given to the shaders again when they are rebuilt, see preprocessShader()
+* @files are the shaders and every file they include, with @modified the modification times the watcher saw last
+* @changed is set by the watcher and cleared by the render loop when it starts the rebuild
+* @building is true while a rebuild is running, @pending is the rebuild done by the driver threads
+* @waitFrames counts down the frames before @pending is checked when the driver can't tell if it is done
+*
+*/
+struct WatchedProgram
+{
+	GLuint* target;
+	std::string paths[3];
+	std::string defines;
+	std::vector<std::string> files;
+	std::vector<time_t> modified;
+	bool changed;
+	bool building;
+	bool pendingStarted;
+	int waitFrames;
+	PendingProgram pending;
+};
+
+/*
+* A program built by the compile thread, the render loop swaps it in or deletes it
+*
+*/
+struct ReloadResult
+{
+	size_t watch;
+	GLuint program;
+	bool success;
+	std::string log;
+};
+
+struct ReloadSources
+{
+	size_t watch;
+	std::string code[3];
+};
+
+static std::vector<WatchedProgram> watchedPrograms;
+static std::mutex reloadMutex;
+static std::atomic<bool> reloadRunning(false);
+static std::thread watcherThread;
+static bool parallelCompile = false;
+
+static GLFWwindow* compileContext = NULL;
+static std::thread compileThread;
+static std::condition_variable compileWake;
+static std::deque<ReloadSources> compileJobs;
+static std::deque<ReloadResult> compileResults;
+
+static time_t modificationTime(const std::string& path) {
+
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+}
+
+static void finishReload(WatchedProgram& watch, GLuint program, bool success, const std::string& log) {
+
+	watch.building = false;
+	if (!success) {
+		std::cout << "ERROR::SHADER::RELOAD " << watch.paths[2] << " keeps the last program that worked\n" << log << std::endl;
+		glDeleteProgram(program);
+		return;
+	}
+	glDeleteProgram(*watch.target);
+	*watch.target = program;
+	std::cout << "SHADER::RELOADED " << watch.paths[0] << " " << watch.paths[2] << std::endl;
+}
+
+static void markChanged(const std::string& path) {
+
+	for (size_t w = 0; w < watchedPrograms.size(); w++) {
+		const std::vector<std::string>& files = watchedPrograms[w].files;
+		if (std::find(files.begin(), files.end(), path) != files.end())
+			watchedPrograms[w].changed = true;
+	}
+}
+
+static void pollModificationTimes() {
+
+	std::lock_guard<std::mutex> lock(reloadMutex);
+	for (size_t w = 0; w < watchedPrograms.size(); w++) {
+		WatchedProgram& watch = watchedPrograms[w];
+		for (size_t f = 0; f < watch.files.size(); f++) {
+			time_t modified = modificationTime(watch.files[f]);
+			if (modified != watch.modified[f]) {
+				watch.modified[f] = modified;
+				watch.changed = true;
+			}
+		}
+	}
+}
+
+static std::string directoryOf(const std::string& path) {
+
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+/*
+* Editors often save by writing a new file and renaming it over the old one, so the directories are watched instead of the files
+*
+*/
+static void watchFiles() {
+
+#ifdef __linux__
+	int notify = inotify_init1(IN_NONBLOCK);
+	if (notify >= 0) {
+		std::map<int, std::string> directories;
+		size_t watchedCount = 0;
+		while (reloadRunning) {
+			{
+				std::lock_guard<std::mutex> lock(reloadMutex);
+				for (size_t w = watchedCount; w < watchedPrograms.size(); w++) {
+					for (size_t f = 0; f < watchedPrograms[w].files.size(); f++) {
+						std::string directory = directoryOf(watchedPrograms[w].files[f]);
+						int handle = inotify_add_watch(notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+						if (handle >= 0)
+							directories[handle] = directory;
+					}
+				}
+				watchedCount = watchedPrograms.size();
+			}
+			struct pollfd waiting = { notify, POLLIN, 0 };
+			if (poll(&waiting, 1, shaderPollMilliseconds) <= 0)
+				continue;
+			alignas(struct inotify_event) char buffer[4096];
+			ssize_t length;
+			while ((length = read(notify, buffer, sizeof(buffer))) > 0) {
+				std::lock_guard<std::mutex> lock(reloadMutex);
+				for (char* at = buffer; at < buffer + length; ) {
+					const struct inotify_event* event = (const struct inotify_event*)at;
+					if (event->len > 0) {
+						std::string directory = directories[event->wd];
+						markChanged(directory == "." ? std::string(event->name) : directory + "/" + event->name);
+					}
+					at += sizeof(struct inotify_event) + event->len;
+				}
+			}
+		}
+		close(notify);
+		return;
+	}
+#endif
+	while (reloadRunning) {
+		pollModificationTimes();
+		std::this_thread::sleep_for(std::chrono::milliseconds(shaderPollMilliseconds));
+	}
+}
+
+/*
+* Builds the programs in the hidden context, it can wait for the compiler because the render loop doesn't wait for it
+*
+*/
+static void compileLoop() {
+
+	glfwMakeContextCurrent(compileContext);
+	while (true) {
+		ReloadSources job;
+		{
+			std::unique_lock<std::mutex> lock(reloadMutex);
+			compileWake.wait(lock, [] { return !compileJobs.empty() || !reloadRunning; });
+			if (!reloadRunning)
+				break;
+			job = compileJobs.front();
+			compileJobs.pop_front();
+		}
+		ReloadResult result;
+		result.watch = job.watch;
+		PendingProgram pending;
+		startProgram(pending, job.code);
+		result.success = finishProgram(pending, result.log);
+		result.program = pending.program;
+		// The program is only used by the other context after the commands are done
+		glFinish();
+		std::lock_guard<std::mutex> lock(reloadMutex);
+		compileResults.push_back(result);
+	}
+	glfwMakeContextCurrent(NULL);
+}
+
+void startShaderReload(GLFWwindow* window) {
+
+	if (reloadRunning)
+		return;
+	reloadRunning = true;
+	parallelCompile = GLEW_ARB_parallel_shader_compile != 0;
+	if (parallelCompile) {
+		// 0xFFFFFFFF lets the driver pick how many threads it uses
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+	}
+	else
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		compileContext = glfwCreateWindow(1, 1, "", NULL, window);
+		glfwDefaultWindowHints();
+		if (compileContext != NULL)
+			compileThread = std::thread(compileLoop);
+		else
+			std::cout << "ERROR::SHADER::RELOAD::NO_SHARED_CONTEXT the shaders are rebuilt in the render loop" << std::endl;
+	}
+	watcherThread = std::thread(watchFiles);
+}
+
+void watchShaderProgram(GLuint* program, const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath, const std::string& defines) {
+
+	WatchedProgram watch;
+	watch.target = program;
+	watch.paths[0] = vertexPath;
+	watch.paths[1] = geometryPath != NULL ? geometryPath : "";
+	watch.paths[2] = fragmentPath;
+	watch.defines = defines;
+	for (int s = 0; s < 3; s++) {
+		if (watch.paths[s].empty())
+			continue;
+		std::vector<std::string> files;
+		preprocessShader(watch.paths[s].c_str(), "", &files);
+		for (size_t f = 0; f < files.size(); f++) {
+			if (std::find(watch.files.begin(), watch.files.end(), files[f]) == watch.files.end())
+				watch.files.push_back(files[f]);
+		}
+	}
+	for (size_t f = 0; f < watch.files.size(); f++)
+		watch.modified.push_back(modificationTime(watch.files[f]));
+	watch.changed = false;
+	watch.building = false;
+	watch.pendingStarted = false;
+	watch.waitFrames = 0;
+	std::lock_guard<std::mutex> lock(reloadMutex);
+	watchedPrograms.push_back(watch);
+}
+
+void updateShaderReload() {
+
+	if (!reloadRunning)
+		return;
+
+	std::deque<ReloadResult> results;
+	std::vector<size_t> starting;
+	{
+		std::lock_guard<std::mutex> lock(reloadMutex);
+		results.swap(compileResults);
+		for (size_t w = 0; w < watchedPrograms.size(); w++) {
+			if (watchedPrograms[w].changed && !watchedPrograms[w].building) {
+				watchedPrograms[w].changed = false;
+				watchedPrograms[w].building = true;
+				starting.push_back(w);
+			}
+		}
+	}
+	for (size_t r = 0; r < results.size(); r++)
+		finishReload(watchedPrograms[results[r].watch], results[r].program, results[r].success, results[r].log);
+
+	// The driver threads report when they are done, until then the old program keeps drawing
+	for (size_t w = 0; w < watchedPrograms.size(); w++) {
+		WatchedProgram& watch = watchedPrograms[w];
+		if (!watch.pendingStarted)
+			continue;
+		if (parallelCompile ? !programReady(watch.pending) : watch.waitFrames-- > 0)
+			continue;
+		std::string log;
+		bool success = finishProgram(watch.pending, log);
+		watch.pendingStarted = false;
+		finishReload(watch, watch.pending.program, success, log);
+	}
+
+	for (size_t i = 0; i < starting.size(); i++) {
+		WatchedProgram& watch = watchedPrograms[starting[i]];
+		ReloadSources job;
+		job.watch = starting[i];
+		for (int s = 0; s < 3; s++)
+			job.code[s] = watch.paths[s].empty() ? std::string() : preprocessShader(watch.paths[s].c_str(), watch.defines);
+		if (parallelCompile) {
+			startProgram(watch.pending, job.code);
+			watch.pendingStarted = true;
+		}
+		else if (compileContext != NULL)
+		{
+			std::lock_guard<std::mutex> lock(reloadMutex);
+			compileJobs.push_back(job);
+			compileWake.notify_one();
+		}
+		else
+		{
+			// Only started here and checked a few frames later, a driver that compiles inside glCompileShader still
+			// stalls this frame but one that compiles in the background doesn't stall any
+			startProgram(watch.pending, job.code);
+			watch.pendingStarted = true;
+			watch.waitFrames = fallbackWaitFrames;
+		}
+	}
+}
+
+void stopShaderReload() {
+
+	if (!reloadRunning)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(reloadMutex);
+		reloadRunning = false;
+	}
+	compileWake.notify_all();
+	if (watcherThread.joinable())
+		watcherThread.join();
+	if (compileThread.joinable())
+		compileThread.join();
+	if (compileContext != NULL)
+		glfwDestroyWindow(compileContext);
+	compileContext = NULL;
+	for (size_t w = 0; w < watchedPrograms.size(); w++) {
+		if (watchedPrograms[w].pendingStarted) {
+			std::string log;
+			finishProgram(watchedPrograms[w].pending, log);
+			glDeleteProgram(watchedPrograms[w].pending.program);
+		}
+	}
+	for (size_t r = 0; r < compileResults.size(); r++)
+		glDeleteProgram(compileResults[r].program);
+	compileResults.clear();
+	compileJobs.clear();
+	watchedPrograms.clear();
+}
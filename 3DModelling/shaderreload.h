@@ -0,0 +1,33 @@
+#ifndef shaderreload_H
+#define shaderreload_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+/*
+* Shader hot reload, the programs made by initShader() can be watched so saving one of their files rebuilds them while the program runs.
+* A thread watches the files (with inotify on Linux and by checking the modification times elsewhere) and the render loop
+* starts the rebuild. With GL_ARB_parallel_shader_compile the driver compiles in its own threads and the render loop only checks
+* if it is done, otherwise a thread with a hidden shared context compiles the program. Either way the render loop never waits.
+* Without both, the render loop starts the rebuild and checks it a few frames later. A driver that compiles in the background
+* is done by then, one that compiles inside glCompileShader stalls the frame that starts the rebuild.
+* The new program replaces the old one only after it linked, if it fails the error is printed and the old program stays in use.
+*
+*/
+
+// Starts the watcher thread, @window is the one whose context draws, it is shared with the compile thread when it is needed
+void startShaderReload(GLFWwindow* window);
+
+// Watches the files of a program and the files they include, when they change the program at @program is replaced
+// by the new one and the old one is deleted. @defines are the ones the program was built with, see preprocessShader()
+void watchShaderProgram(GLuint* program, const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath, const std::string& defines = "");
+
+// Called once per frame from the render loop, starts the rebuilds and swaps the programs that are done
+void updateShaderReload();
+
+void stopShaderReload();
+
+#endif
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <iostream>
+
+#include "shadervariants.h"
+#include "shaderreload.h"
+
+void initShaderVariants(ShaderVariants& variants, const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath,
+	const std::vector<std::string>& features) {
+
+	deleteShaderVariants(variants);
+	variants.paths[0] = vertexPath;
+	variants.paths[1] = geometryPath != NULL ? geometryPath : "";
+	variants.paths[2] = fragmentPath;
+	variants.features = features;
+}
+
+std::string shaderVariantDefines(const ShaderVariants& variants, unsigned key) {
+
+	std::string defines;
+	for (size_t f = 0; f < variants.features.size(); f++)
+		defines += "#define " + variants.features[f] + ((key >> f) & 1 ? " 1\n" : " 0\n");
+	defines += "#define LIGHT_COUNT " + std::to_string(std::max(key >> variantLightShift, 1u)) + "\n";
+	return defines;
+}
+
+static void variantSources(const ShaderVariants& variants, unsigned key, std::string code[3]) {
+
+	std::string defines = shaderVariantDefines(variants, key);
+	for (int s = 0; s < 3; s++)
+		code[s] = variants.paths[s].empty() ? std::string() : preprocessShader(variants.paths[s].c_str(), defines);
+}
+
+// Starts building the variant and returns its sources one after the other
+static std::string startVariant(const ShaderVariants& variants, unsigned key, PendingProgram& pending) {
+
+	std::string code[3];
+	variantSources(variants, key, code);
+	startProgram(pending, code);
+	return code[0] + code[1] + code[2];
+}
+
+/*
+* A variant that doesn't link is deleted and its key stays unset. Its sources are kept in @failed so it is only built again
+* once a file changed, fixing the file is enough to get it
+*
+*/
+static bool finishVariant(ShaderVariants& variants, unsigned key, PendingProgram& pending, const std::string& sources) {
+
+	std::string log;
+	if (!finishProgram(pending, log)) {
+		std::cout << "ERROR::SHADER::VARIANT " << variants.paths[2] << " key " << key << "\n" << log << std::endl;
+		glDeleteProgram(pending.program);
+		pending.program = 0;
+		variants.failed[key] = sources;
+		return false;
+	}
+	variants.failed.erase(key);
+	// The map keeps its values in place, so the shader reload can write the rebuilt program straight into it
+	GLuint& program = variants.programs[key];
+	program = pending.program;
+	if (variants.hotReload) {
+		watchShaderProgram(&program, variants.paths[0].c_str(), variants.paths[1].empty() ? NULL : variants.paths[1].c_str(),
+			variants.paths[2].c_str(), shaderVariantDefines(variants, key));
+	}
+	return true;
+}
+
+GLuint getShaderVariant(ShaderVariants& variants, unsigned key) {
+
+	std::map<unsigned, GLuint>::iterator found = variants.programs.find(key);
+	if (found != variants.programs.end())
+		return found->second;
+	std::map<unsigned, std::string>::iterator failed = variants.failed.find(key);
+	if (failed != variants.failed.end()) {
+		std::string code[3];
+		variantSources(variants, key, code);
+		if (code[0] + code[1] + code[2] == failed->second)
+			return 0;
+	}
+	PendingProgram pending;
+	std::string sources = startVariant(variants, key, pending);
+	if (!finishVariant(variants, key, pending, sources))
+		return 0;
+	return variants.programs[key];
+}
+
+void precompileShaderVariants(ShaderVariants& variants, const std::vector<unsigned>& keys) {
+
+	if (GLEW_ARB_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+	}
+	// Every compile is started before any result is asked for, otherwise the driver would finish them one by one
+	std::vector<unsigned> started;
+	std::vector<PendingProgram> pending;
+	std::vector<std::string> sources;
+	for (size_t k = 0; k < keys.size(); k++) {
+		if (variants.programs.count(keys[k]) > 0 || std::find(started.begin(), started.end(), keys[k]) != started.end())
+			continue;
+		started.push_back(keys[k]);
+		pending.push_back(PendingProgram());
+		sources.push_back(startVariant(variants, keys[k], pending.back()));
+	}
+	for (size_t k = 0; k < started.size(); k++)
+		finishVariant(variants, started[k], pending[k], sources[k]);
+}
+
+void deleteShaderVariants(ShaderVariants& variants) {
+
+	for (std::map<unsigned, GLuint>::iterator it = variants.programs.begin(); it != variants.programs.end(); ++it)
+		glDeleteProgram(it->second);
+	variants.programs.clear();
+	variants.failed.clear();
+}
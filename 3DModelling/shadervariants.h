@@ -0,0 +1,64 @@
+#ifndef shadervariants_H
+#define shadervariants_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "shader.h"
+
+/*
+* Features of the lighting shaders, a variant is picked by a key that has one bit per feature
+* and the amount of lights in the bits from variantLightShift up.
+* SHADER_INSTANCED reads the center and radius of the Sphere from an instanced attribute instead of the uniforms
+* SHADER_SPECULAR adds the specular highlight
+* SHADER_CLUSTERED adds the lights of the cluster of every fragment, see cluster.h
+* SHADER_DEFERRED writes the G-buffer instead, the clusters are then added by deferred_frag.glsl, see deferred.h
+* SHADER_SHADOWS adds the directional light and its cascaded shadow maps, see shadow.h
+* SHADER_SSAO takes the screen space ambient occlusion away from the ambient light, see ssao.h
+*
+*/
+enum ShaderFeature { SHADER_INSTANCED = 1, SHADER_SPECULAR = 2, SHADER_CLUSTERED = 4, SHADER_DEFERRED = 8, SHADER_SHADOWS = 16, SHADER_SSAO = 32 };
+const int variantLightShift = 8;
+
+/* Shader Variants
+*
+* The same shader files built with different #define blocks, every feature of the key becomes "#define NAME 1" or "#define NAME 0"
+* and the amount of lights "#define LIGHT_COUNT n", so the shaders use #if to keep only the code of their variant.
+* The programs are kept by key, so after the first time changing the variant is only binding another program.
+* @paths are the vertex, geometry (empty for none) and fragment files
+* @features are the names of the defines of the bits of the key, from the lowest bit up
+* @hotReload watches the files of every variant that is built, see shaderreload.h
+* @programs are the variants built so far by key
+* @failed are the sources of the variants that failed to build by key, they are built again when their sources change
+*
+*/
+struct ShaderVariants
+{
+	std::string paths[3];
+	std::vector<std::string> features;
+	bool hotReload = false;
+	std::map<unsigned, GLuint> programs;
+	std::map<unsigned, std::string> failed;
+};
+
+inline unsigned shaderVariantKey(unsigned features, unsigned lights) {
+	return features | (lights << variantLightShift);
+}
+
+void initShaderVariants(ShaderVariants& variants, const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath,
+	const std::vector<std::string>& features);
+
+// The #define block of a key
+std::string shaderVariantDefines(const ShaderVariants& variants, unsigned key);
+
+// Returns the program of the key, it is built the first time it is asked for. It is 0 while the variant fails to build
+GLuint getShaderVariant(ShaderVariants& variants, unsigned key);
+
+// Builds the variants that are not built yet all at once, the driver compiles them in parallel when it supports it
+void precompileShaderVariants(ShaderVariants& variants, const std::vector<unsigned>& keys);
+
+// With @hotReload on the watcher writes into the programs, so stopShaderReload() has to be called first
+void deleteShaderVariants(ShaderVariants& variants);
+
+#endif
@@ -0,0 +1,168 @@
+// Cascade splits from Zhang et al. "Parallel-Split Shadow Maps", the cascades are kept from shimmering as in
+// Valient "Stable Rendering of Cascaded Shadow Maps" by fitting a sphere and moving the maps in whole texels
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shadow.h"
+
+/*Shadow variables
+*
+* @shadowTextureUnit is the texture unit of the shadow maps, the units before it hold the clusters and the G-buffer
+*
+*/
+const int shadowTextureUnit = 8;
+
+void updateShadowCascades(ShadowCascades& shadows, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
+
+	shadows.cascades = std::max(1, std::min(shadows.cascades, maxShadowCascades));
+	float nearPlane = projectionNearPlane(projection);
+	float farPlane = std::min(projectionFarPlane(projection), shadows.shadowDistance);
+	float tanX = 1.0f / projection[0][0];
+	float tanY = 1.0f / projection[1][1];
+	glm::mat4 inverseView = glm::inverse(view);
+	glm::vec3 up = fabs(shadows.lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+	float previous = nearPlane;
+	for (int c = 0; c < shadows.cascades; c++) {
+		float t = (float)(c + 1) / shadows.cascades;
+		float logarithmic = nearPlane * pow(farPlane / nearPlane, t);
+		float uniform = nearPlane + (farPlane - nearPlane) * t;
+		float split = shadows.splitLambda * logarithmic + (1.0f - shadows.splitLambda) * uniform;
+
+		// The sphere around the 8 corners of the slice has the same size whichever way the camera turns
+		glm::vec3 corners[8];
+		glm::vec3 center(0.0f);
+		for (int k = 0; k < 8; k++) {
+			float depth = k < 4 ? previous : split;
+			glm::vec4 corner(((k & 1) ? 1.0f : -1.0f) * depth * tanX, ((k & 2) ? 1.0f : -1.0f) * depth * tanY, -depth, 1.0f);
+			corners[k] = glm::vec3(inverseView * corner);
+			center += corners[k] / 8.0f;
+		}
+		float radius = 0.0f;
+		for (int k = 0; k < 8; k++)
+			radius = std::max(radius, glm::length(corners[k] - center));
+		radius = ceil(radius * 16.0f) / 16.0f;
+
+		float depthRange = 2.0f * radius + shadows.casterDistance;
+		glm::mat4 lightView = glm::lookAt(center - shadows.lightDirection * (radius + shadows.casterDistance), center, up);
+		glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, depthRange);
+
+		// Moving the map only by whole texels keeps the edges of the shadows still while the camera moves
+		glm::vec4 origin = lightProjection * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) * (shadows.resolution * 0.5f);
+		glm::vec2 offset = (glm::round(glm::vec2(origin)) - glm::vec2(origin)) * (2.0f / shadows.resolution);
+		lightProjection[3][0] += offset.x;
+		lightProjection[3][1] += offset.y;
+
+		shadows.matrices[c] = lightProjection * lightView;
+		shadows.frustums[c] = extractFrustum(shadows.matrices[c] * model);
+		shadows.splits[c] = split;
+		shadows.depthRanges[c] = depthRange;
+		previous = split;
+	}
+}
+
+void beginShadowCascade(ShadowCascades& shadows, int cascade) {
+
+	if (shadows.texture == 0 || shadows.textureResolution != shadows.resolution) {
+		deleteShadowCascades(shadows);
+		glGenTextures(1, &shadows.texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, shadows.texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, shadows.resolution, shadows.resolution, maxShadowCascades, 0,
+			GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		// The comparison with linear filtering gives a 2x2 percentage closer filter for every lookup
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glGenFramebuffers(1, &shadows.fbo);
+		shadows.textureResolution = shadows.resolution;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, shadows.fbo);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadows.texture, 0, cascade);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glViewport(0, 0, shadows.resolution, shadows.resolution);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void bindShadows(const ShadowCascades& shadows, GLuint shader, const glm::mat4& fragmentSpace) {
+
+	glUseProgram(shader);
+	glActiveTexture(GL_TEXTURE0 + shadowTextureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, shadows.texture);
+	glUniform1i(glGetUniformLocation(shader, "shadowMap"), shadowTextureUnit);
+	glActiveTexture(GL_TEXTURE0);
+
+	// From clip space [-1, 1] to texture coordinates and depth [0, 1]
+	glm::mat4 bias = glm::scale(glm::translate(glm::mat4(), glm::vec3(0.5f)), glm::vec3(0.5f));
+	glm::mat4 sampling[maxShadowCascades];
+	GLfloat splits[maxShadowCascades];
+	GLfloat depthBias[maxShadowCascades];
+	for (int c = 0; c < maxShadowCascades; c++) {
+		bool used = c < shadows.cascades;
+		sampling[c] = used ? bias * shadows.matrices[c] * fragmentSpace : glm::mat4();
+		splits[c] = used ? shadows.splits[c] : 0.0f;
+		depthBias[c] = used ? shadows.depthBias / shadows.depthRanges[c] : 0.0f;
+	}
+	glUniformMatrix4fv(glGetUniformLocation(shader, "shadowMatrices"), maxShadowCascades, GL_FALSE, glm::value_ptr(sampling[0]));
+	glUniform4fv(glGetUniformLocation(shader, "shadowSplits"), 1, splits);
+	glUniform4fv(glGetUniformLocation(shader, "shadowBias"), 1, depthBias);
+	glUniform1i(glGetUniformLocation(shader, "shadowCascades"), shadows.cascades);
+	glUniform1f(glGetUniformLocation(shader, "shadowTexelSize"), 1.0f / shadows.resolution);
+
+	glm::vec3 direction = glm::normalize(glm::mat3(glm::inverse(fragmentSpace)) * shadows.lightDirection);
+	glUniform3f(glGetUniformLocation(shader, "shadowLightDir"), direction.x, direction.y, direction.z);
+	glUniform3f(glGetUniformLocation(shader, "shadowLightColor"), shadows.lightColor.r, shadows.lightColor.g, shadows.lightColor.b);
+	glUniform1f(glGetUniformLocation(shader, "shadowStrength"), shadows.strength);
+}
+
+void drawShadowCasters(ShadowCascades& shadows, GLuint shader, const glm::mat4& model, const Mesh& mesh, const std::vector<SphereInstance>& casters) {
+
+	GLint viewport[4];
+	GLint framebuffer;
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+
+	glUseProgram(shader);
+	glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
+	GLint lightViewProjectionLoc = glGetUniformLocation(shader, "lightViewProjection");
+	// The slope of the Spheres towards their edges needs more bias than depthBias, the depth clamp keeps
+	// the casters between the light and the near plane of a cascade instead of clipping them
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 2.0f);
+	glEnable(GL_DEPTH_CLAMP);
+
+	static std::vector<SphereInstance> visible;
+	for (int c = 0; c < shadows.cascades; c++) {
+		visible.clear();
+		for (size_t i = 0; i < casters.size(); i++) {
+			if (sphereInFrustum(shadows.frustums[c], glm::vec3(casters[i].centerRadius), casters[i].centerRadius.w))
+				visible.push_back(casters[i]);
+		}
+		shadows.casters[c] = (unsigned)visible.size();
+		beginShadowCascade(shadows, c);
+		glUniformMatrix4fv(lightViewProjectionLoc, 1, GL_FALSE, glm::value_ptr(shadows.matrices[c]));
+		drawMeshInstanced(mesh, visible);
+	}
+
+	glDisable(GL_DEPTH_CLAMP);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void deleteShadowCascades(ShadowCascades& shadows) {
+
+	glDeleteTextures(1, &shadows.texture);
+	glDeleteFramebuffers(1, &shadows.fbo);
+	shadows.texture = shadows.fbo = 0;
+	shadows.textureResolution = 0;
+}
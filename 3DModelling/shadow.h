@@ -0,0 +1,76 @@
+#ifndef shadow_H
+#define shadow_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "cull.h"
+#include "mesh.h"
+
+const int maxShadowCascades = 4;
+
+/* Shadow Cascades
+*
+* Cascaded shadow maps of one directional light. The view frustum is cut in depth into @cascades slices and every slice
+* gets its own shadow map, so the shadows close to the camera get as many texels as the ones far away.
+* @resolution is the width and height of every shadow map, they are the layers of one texture array
+* @splitLambda blends the split distances between uniform (0) and logarithmic (1)
+* @shadowDistance is where the last cascade ends, nothing further away gets a shadow
+* @casterDistance is how far towards the light a Sphere can be from a cascade and still throw a shadow into it
+* @depthBias is in world units, it keeps a surface from shadowing itself
+* @lightDirection is the direction the light travels, in the space of FragPos of frag.glsl
+* @strength is how much of the ambient light a shadow takes away
+* @matrices are the light view projection of every cascade and @frustums their planes before the model matrix, for the culling
+* @splits are the view depths where the cascades end
+* @casters is how many Spheres were drawn into every cascade in the last frame
+*
+*/
+struct ShadowCascades
+{
+	int cascades = 4;
+	int resolution = 1024;
+	float splitLambda = 0.75f;
+	float shadowDistance = 80.0f;
+	float casterDistance = 40.0f;
+	float depthBias = 0.05f;
+	glm::vec3 lightDirection = glm::normalize(glm::vec3(-0.3f, -1.0f, -0.4f));
+	glm::vec3 lightColor = glm::vec3(0.5f);
+	float strength = 0.5f;
+
+	glm::mat4 matrices[maxShadowCascades];
+	Frustum frustums[maxShadowCascades];
+	float splits[maxShadowCascades];
+	float depthRanges[maxShadowCascades];
+	unsigned casters[maxShadowCascades];
+
+	GLuint texture = 0;
+	GLuint fbo = 0;
+	int textureResolution = 0;
+};
+
+// Fits every cascade to its slice of the view frustum, the model matrix only changes the frustums used for the culling
+void updateShadowCascades(ShadowCascades& shadows, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
+
+// Binds the shadow map of a cascade to draw into it, the texture array is created the first time or when the resolution changed
+void beginShadowCascade(ShadowCascades& shadows, int cascade);
+
+/*
+* Binds the shadow maps to texture unit 8 and sets the uniforms of a program built with SHADOWS
+* @fragmentSpace moves the fragPos of the shader into the space of FragPos of frag.glsl, the impostors pass the inverse view matrix
+*
+*/
+void bindShadows(const ShadowCascades& shadows, GLuint shader, const glm::mat4& fragmentSpace);
+
+/*
+* Draws the Spheres into every cascade with one instanced call each, only the ones inside the frustum of the cascade.
+* @shader is built from shadow_vert.glsl and shadow_frag.glsl, @casters only need their centerRadius.
+* The framebuffer and the viewport are given back as they were
+*
+*/
+void drawShadowCasters(ShadowCascades& shadows, GLuint shader, const glm::mat4& model, const Mesh& mesh, const std::vector<SphereInstance>& casters);
+
+void deleteShadowCascades(ShadowCascades& shadows);
+
+#endif
@@ -0,0 +1,6 @@
+#version 330 core
+
+// Only the depth is written, the shadow maps have no colour
+void main()
+{
+}
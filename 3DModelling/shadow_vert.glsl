@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 2) in vec4 centerRadius;  //the instanced attribute of vert.glsl, only the depth is needed
+
+uniform mat4 model;
+uniform mat4 lightViewProjection;  //of the cascade that is drawn, see shadow.h
+
+void main()
+{
+    gl_Position = lightViewProjection * model * vec4(centerRadius.w * position + centerRadius.xyz, 1.0f);
+}
@@ -0,0 +1,15 @@
+// The colour of the translucent shells, shared by shell_frag.glsl and shell_list_frag.glsl (see oit.h)
+
+uniform vec3 viewPos;
+uniform mat4 view;
+uniform float shellOpacity;
+
+// The view goes through more of the shell towards its edge, so it is more opaque there. The alpha is 0 on the back of the shell
+vec4 shellColor(vec3 fragPos, vec3 normal, vec3 objectColor, vec3 lightColor)
+{
+    float facing = dot(normalize(normal), normalize(viewPos - fragPos));
+    if (facing <= 0.0f)
+        return vec4(0.0f);
+    float alpha = shellOpacity * (0.2f + 0.8f * pow(1.0f - facing, 3.0f));
+    return vec4(mix(objectColor, vec3(1.0f), 0.5f) * lightColor, alpha);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+
+#ifndef SORTED
+#define SORTED 0
+#endif
+
+layout (location = 0) out vec4 accumulation;
+#if !SORTED
+layout (location = 1) out float weight;
+#endif
+
+in vec3 FragPos;
+in vec3 Normal;
+flat in vec3 ObjectColor;
+flat in vec3 LightColor;
+flat in vec3 LightPos;
+
+#include "shell.glsl"
+
+void main()
+{
+    vec4 shell = shellColor(FragPos, Normal, ObjectColor, LightColor);
+    if (shell.a <= 0.0f)
+        discard;
+#if SORTED
+    // Premultiplied, blended over what is behind it
+    accumulation = vec4(shell.rgb * shell.a, shell.a);
+#else
+    // The weight of McGuire and Bavoil, the closer shells count more. Its top is lower than theirs so the sums fit in half floats
+    float viewDepth = -(view * vec4(FragPos, 1.0f)).z;
+    float w = shell.a * clamp(0.03f / (1e-5f + pow(viewDepth / 200.0f, 4.0f)), 1e-2f, 300.0f);
+    accumulation = vec4(shell.rgb * w, shell.a);
+    weight = w;
+#endif
+}
@@ -0,0 +1,42 @@
+#version 430 core
+// The shells behind the opaque Spheres never reach the lists
+layout (early_fragment_tests) in;
+
+in vec3 FragPos;
+in vec3 Normal;
+flat in vec3 ObjectColor;
+flat in vec3 LightColor;
+flat in vec3 LightPos;
+
+// The linked list of the fragments of every pixel, see oit.h. The colour is kept in half floats so it stays HDR
+struct ListNode
+{
+    uint redGreen;
+    uint blueAlpha;
+    float depth;
+    uint next;
+};
+layout (binding = 0, r32ui) uniform coherent uimage2D listHeads;
+layout (binding = 0, offset = 0) uniform atomic_uint listCounter;
+layout (std430, binding = 0) buffer ListNodes
+{
+    ListNode nodes[];
+};
+uniform uint nodeCapacity;
+
+#include "shell.glsl"
+
+void main()
+{
+    vec4 shell = shellColor(FragPos, Normal, ObjectColor, LightColor);
+    if (shell.a <= 0.0f)
+        return;
+    // The node 0 is the end of the lists, when the buffer is full the fragment is lost
+    uint node = atomicCounterIncrement(listCounter) + 1u;
+    if (node > nodeCapacity)
+        return;
+    nodes[node].redGreen = packHalf2x16(shell.rg);
+    nodes[node].blueAlpha = packHalf2x16(shell.ba);
+    nodes[node].depth = -(view * vec4(FragPos, 1.0f)).z;
+    nodes[node].next = imageAtomicExchange(listHeads, ivec2(gl_FragCoord.xy), node);
+}
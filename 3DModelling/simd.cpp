@@ -0,0 +1,73 @@
+#include "simd.h"
+
+#if SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+/*
+* Checks both that the CPU has the instructions and that the operating system saves the wider registers (XGETBV)
+*
+*/
+static void cpuid(int leaf, int subleaf, unsigned registers[4]) {
+#if defined(_MSC_VER)
+	int values[4];
+	__cpuidex(values, leaf, subleaf);
+	for (int r = 0; r < 4; r++)
+		registers[r] = (unsigned)values[r];
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static unsigned long long xgetbv0() {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+SimdISA detectSimdISA() {
+
+#if SIMD_X86
+	unsigned basic[4];
+	unsigned extended[4];
+	cpuid(0, 0, basic);
+	if (basic[0] < 7)
+		return SIMD_SSE;
+	cpuid(1, 0, basic);
+	cpuid(7, 0, extended);
+
+	bool osxsave = (basic[2] & (1u << 27)) != 0;
+	unsigned long long xcr0 = osxsave ? xgetbv0() : 0;
+	bool avxState = (xcr0 & 0x6) == 0x6;
+	bool avx512State = (xcr0 & 0xE6) == 0xE6;
+	bool fma = (basic[2] & (1u << 12)) != 0;
+	bool avx2 = (extended[1] & (1u << 5)) != 0;
+	bool avx512f = (extended[1] & (1u << 16)) != 0;
+
+	if (avx512f && avx512State)
+		return SIMD_AVX512;
+	if (avx2 && fma && avxState)
+		return SIMD_AVX2;
+	return SIMD_SSE;
+#else
+	return SIMD_SCALAR;
+#endif
+}
+
+const char* simdISAName(SimdISA isa) {
+
+	switch (isa) {
+	case SIMD_SSE: return "SSE";
+	case SIMD_AVX2: return "AVX2";
+	case SIMD_AVX512: return "AVX-512";
+	default: return "scalar";
+	}
+}
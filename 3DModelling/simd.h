@@ -0,0 +1,32 @@
+#ifndef simd_H
+#define simd_H
+
+/*
+* Instruction sets of the SIMD kernels and the runtime detection that picks between them.
+* The kernels are compiled for every instruction set and only the ones the CPU supports are called.
+*
+*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+// MSVC lets every function use the intrinsics, the runtime dispatch makes sure only the supported ones run
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+// From the slowest to the fastest, a kernel that is missing an instruction set uses the next slower one
+enum SimdISA { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2, SIMD_AVX512 };
+
+// Best instruction set supported by the CPU and the operating system
+SimdISA detectSimdISA();
+const char* simdISAName(SimdISA isa);
+
+#endif
@@ -0,0 +1,163 @@
+// The hemisphere kernel follows the SSAO of www.learnopengl.com, the blur and the upsample keep the depth edges
+// like the bilateral filters of Tomasi and Manduchi "Bilateral Filtering for Gray and Color Images"
+
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "ssao.h"
+#include "rng.h"
+
+/*SSAO variables
+*
+* @aoTextureUnit is the texture unit of the occlusion, the units before it hold the clusters, the G-buffer and the shadow maps
+* @aoKernelSeed gives the same kernel on every run
+*
+*/
+const int aoTextureUnit = 9;
+const uint64_t aoKernelSeed = 0x55A0;
+
+AOPreset aoPreset(AOQuality quality) {
+
+	switch (quality) {
+	case AO_LOW:
+		return { 2, 8, 2 };
+	case AO_HIGH:
+		return { 1, 32, 4 };
+	default:
+		return { 2, 16, 4 };
+	}
+}
+
+const char* aoQualityName(AOQuality quality) {
+
+	static const char* names[] = { "low", "medium", "high" };
+	return names[quality];
+}
+
+/*
+* Points in the hemisphere around +z, more of them close to the center so the nearby Spheres count more
+*
+*/
+static void buildKernel(AmbientOcclusion& ao, int samples) {
+
+	for (int i = 0; i < samples; i++) {
+		glm::vec3 direction(randomFloat(aoKernelSeed, i, 0) * 2.0f - 1.0f, randomFloat(aoKernelSeed, i, 1) * 2.0f - 1.0f,
+			randomFloat(aoKernelSeed, i, 2));
+		float length = randomFloat(aoKernelSeed, i, 3);
+		float scale = (float)i / samples;
+		scale = 0.1f + 0.9f * scale * scale;
+		ao.kernel[i] = glm::normalize(direction + glm::vec3(0.0f, 0.0f, 1e-3f)) * length * scale;
+	}
+	ao.kernelSamples = samples;
+}
+
+/*
+* Reads the timer of two frames ago, which had a whole frame to finish, and lowers the preset when the average is over the budget
+*
+*/
+static void readTimer(AmbientOcclusion& ao, GLuint query) {
+
+	GLint available = 0;
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+	ao.cost = nanoseconds / 1e6;
+	ao.averageCost = ao.averageCost == 0.0 ? ao.cost : ao.averageCost * 0.9 + ao.cost * 0.1;
+
+	ao.framesOverBudget = ao.averageCost > ao.budget ? ao.framesOverBudget + 1 : 0;
+	if (ao.adaptQuality && ao.quality > AO_LOW && ao.framesOverBudget >= ao.overBudgetFrames) {
+		ao.quality = (AOQuality)(ao.quality - 1);
+		std::cout << "SSAO::QUALITY " << aoQualityName(ao.quality) << ", " << ao.averageCost << " ms is over the budget of "
+			<< ao.budget << " ms" << std::endl;
+		ao.averageCost = 0.0;
+		ao.framesOverBudget = 0;
+	}
+}
+
+void beginDepthPrepass(AmbientOcclusion& ao, int width, int height) {
+
+	if (ao.queries[0] == 0)
+		glGenQueries(2, ao.queries);
+	GLuint query = ao.queries[ao.frame % 2];
+	if (ao.frame >= 2)
+		readTimer(ao, query);
+	glBeginQuery(GL_TIME_ELAPSED, query);
+
+	resizeFramebuffer(ao.depth, width, height, {}, true);
+	bindFramebuffer(ao.depth);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void drawAmbientOcclusion(AmbientOcclusion& ao, const glm::mat4& projection) {
+
+	AOPreset preset = aoPreset(ao.quality);
+	if (ao.kernelSamples != preset.samples)
+		buildKernel(ao, preset.samples);
+	int width = ao.depth.width / preset.divisor;
+	int height = ao.depth.height / preset.divisor;
+	for (int b = 0; b < 2; b++)
+		resizeFramebuffer(ao.occlusion[b], width, height, { GL_RG16F }, false);
+
+	// Every pass writes every pixel once
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	glUseProgram(ao.program);
+	glActiveTexture(GL_TEXTURE0 + aoTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, ao.depth.depth);
+	glUniform1i(glGetUniformLocation(ao.program, "depthTexture"), aoTextureUnit);
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	glUniformMatrix4fv(glGetUniformLocation(ao.program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	glUniformMatrix4fv(glGetUniformLocation(ao.program, "inverseProjection"), 1, GL_FALSE, glm::value_ptr(inverseProjection));
+	glUniform3fv(glGetUniformLocation(ao.program, "kernel"), preset.samples, glm::value_ptr(ao.kernel[0]));
+	glUniform1i(glGetUniformLocation(ao.program, "sampleCount"), preset.samples);
+	glUniform1i(glGetUniformLocation(ao.program, "divisor"), preset.divisor);
+	glUniform1f(glGetUniformLocation(ao.program, "radius"), ao.radius);
+	glUniform1f(glGetUniformLocation(ao.program, "intensity"), ao.intensity);
+	bindFramebuffer(ao.occlusion[0]);
+	drawFullscreenTriangle();
+
+	// Horizontal into the second target, then vertical back into the first
+	glUseProgram(ao.blurProgram);
+	glUniform1i(glGetUniformLocation(ao.blurProgram, "occlusionTexture"), aoTextureUnit);
+	glUniform1i(glGetUniformLocation(ao.blurProgram, "blurRadius"), preset.blurRadius);
+	glUniform1f(glGetUniformLocation(ao.blurProgram, "sharpness"), ao.sharpness);
+	GLint directionLoc = glGetUniformLocation(ao.blurProgram, "direction");
+	for (int pass = 0; pass < 2; pass++) {
+		glBindTexture(GL_TEXTURE_2D, ao.occlusion[pass].colors[0]);
+		glUniform2i(directionLoc, 1 - pass, pass);
+		bindFramebuffer(ao.occlusion[1 - pass]);
+		drawFullscreenTriangle();
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+	glEndQuery(GL_TIME_ELAPSED);
+	ao.frame++;
+}
+
+void bindAmbientOcclusion(const AmbientOcclusion& ao, GLuint shader) {
+
+	glUseProgram(shader);
+	glActiveTexture(GL_TEXTURE0 + aoTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, ao.occlusion[0].colors[0]);
+	glUniform1i(glGetUniformLocation(shader, "ssaoTexture"), aoTextureUnit);
+	glUniform1f(glGetUniformLocation(shader, "ssaoScale"), (GLfloat)ao.occlusion[0].width / ao.depth.width);
+	glUniform1f(glGetUniformLocation(shader, "ssaoSharpness"), ao.sharpness);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void deleteAmbientOcclusion(AmbientOcclusion& ao) {
+
+	deleteFramebuffer(ao.depth);
+	for (int b = 0; b < 2; b++)
+		deleteFramebuffer(ao.occlusion[b]);
+	glDeleteQueries(2, ao.queries);
+	ao.queries[0] = ao.queries[1] = 0;
+	ao.kernelSamples = 0;
+}
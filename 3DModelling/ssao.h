@@ -0,0 +1,82 @@
+#ifndef ssao_H
+#define ssao_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "framebuffer.h"
+
+const int maxAOSamples = 32;
+
+/*
+* Quality presets of the ambient occlusion, from the cheapest to the best looking
+* AO_LOW computes it at half the resolution with 8 samples and a small blur
+* AO_MEDIUM computes it at half the resolution with 16 samples
+* AO_HIGH computes it at the full resolution with 32 samples
+*
+*/
+enum AOQuality { AO_LOW, AO_MEDIUM, AO_HIGH };
+
+struct AOPreset
+{
+	int divisor;
+	int samples;
+	int blurRadius;
+};
+
+AOPreset aoPreset(AOQuality quality);
+const char* aoQualityName(AOQuality quality);
+
+/* Ambient Occlusion
+*
+* Screen space ambient occlusion from a depth prepass. The Spheres are drawn into @depth before the lighting, the occlusion of
+* every pixel is computed from it at the resolution of the preset, blurred in two passes that don't blur across depth edges,
+* and the lighting shaders read it back at their own resolution with the same depth test (see lighting.glsl).
+* @radius is how far from a surface, in world units, the Spheres around it take away its ambient light
+* @intensity darkens the occlusion, 1 keeps the fraction of the samples that were hidden
+* @sharpness is how much a depth difference lowers the weight of a neighbour in the blur and the upsample
+* @budget is the GPU time in milliseconds the prepass and the occlusion may take,
+* with @adaptQuality the preset is lowered when they take longer for @overBudgetFrames frames in a row
+* @program is built from deferred_vert.glsl and ssao_frag.glsl, @blurProgram from deferred_vert.glsl and ssao_blur_frag.glsl
+* @occlusion holds the occlusion and the view depth of every pixel, the blur goes from the first to the second and back
+* @cost is the GPU time of the last frame that was measured, the timer is read a frame later so the CPU never waits for it
+*
+*/
+struct AmbientOcclusion
+{
+	AOQuality quality = AO_MEDIUM;
+	float radius = 1.0f;
+	float intensity = 1.5f;
+	float sharpness = 20.0f;
+	float budget = 1.5f;
+	bool adaptQuality = true;
+	int overBudgetFrames = 30;
+
+	GLuint program = 0;
+	GLuint blurProgram = 0;
+	Framebuffer depth;
+	Framebuffer occlusion[2];
+	glm::vec3 kernel[maxAOSamples];
+	int kernelSamples = 0;
+
+	GLuint queries[2] = { 0, 0 };
+	unsigned frame = 0;
+	double cost = 0.0;
+	double averageCost = 0.0;
+	int framesOverBudget = 0;
+};
+
+// Binds the depth framebuffer and starts the GPU timer, the caller draws the Spheres into it with a depth only program
+void beginDepthPrepass(AmbientOcclusion& ao, int width, int height);
+
+// Computes and blurs the occlusion from the prepass, stops the timer and lowers the preset when it is over the budget
+void drawAmbientOcclusion(AmbientOcclusion& ao, const glm::mat4& projection);
+
+// Binds the occlusion to texture unit 9 and sets the uniforms of a program built with SSAO
+void bindAmbientOcclusion(const AmbientOcclusion& ao, GLuint shader);
+
+void deleteAmbientOcclusion(AmbientOcclusion& ao);
+
+#endif
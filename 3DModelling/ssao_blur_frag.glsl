@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) out vec2 occlusion;
+
+// One direction of the separable bilateral blur of the occlusion of ssao_frag.glsl
+uniform sampler2D occlusionTexture;
+uniform ivec2 direction;
+uniform int blurRadius;
+uniform float sharpness;    //how much a relative depth difference lowers the weight of a neighbour
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(occlusionTexture, 0);
+    vec2 center = texelFetch(occlusionTexture, pixel, 0).rg;
+    float sigma = 0.5f * float(blurRadius) + 0.5f;
+
+    float total = center.r;
+    float weight = 1.0f;
+    for (int i = -blurRadius; i <= blurRadius; i++)
+    {
+        if (i == 0)
+            continue;
+        vec2 neighbour = texelFetch(occlusionTexture, clamp(pixel + direction * i, ivec2(0), size - 1), 0).rg;
+        float w = exp(-float(i * i) / (2.0f * sigma * sigma)) * exp(-abs(neighbour.g - center.g) / center.g * sharpness);
+        total += neighbour.r * w;
+        weight += w;
+    }
+    occlusion = vec2(total / weight, center.g);
+}
@@ -0,0 +1,58 @@
+#version 330 core
+layout (location = 0) out vec2 occlusion;  //the ambient light that is left and the view depth, for the blur and the upsample
+
+// The depth prepass of the Spheres, see ssao.h
+uniform sampler2D depthTexture;
+uniform mat4 projection;
+uniform mat4 inverseProjection;
+uniform vec3 kernel[32];
+uniform int sampleCount;
+uniform int divisor;        //how many pixels of the depth go into one pixel of the occlusion on every axis
+uniform float radius;
+uniform float intensity;
+
+vec3 viewPosition(vec2 uv)
+{
+    float depth = texture(depthTexture, uv).r;
+    vec4 position = inverseProjection * vec4(uv * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+    return position.xyz / position.w;
+}
+
+void main()
+{
+    vec2 size = vec2(textureSize(depthTexture, 0));
+    vec2 uv = (floor(gl_FragCoord.xy) * float(divisor) + 0.5f) / size;
+    // The background is lit and far behind everything, the upsample never mixes it with a Sphere
+    if (texture(depthTexture, uv).r >= 1.0f)
+    {
+        occlusion = vec2(1.0f, 60000.0f);
+        return;
+    }
+    vec3 position = viewPosition(uv);
+
+    // The normal from the neighbour with the smaller depth difference on every axis, so the edges of the Spheres don't bend it
+    vec2 texel = 1.0f / size;
+    vec3 right = viewPosition(uv + vec2(texel.x, 0.0f)) - position;
+    vec3 left = position - viewPosition(uv - vec2(texel.x, 0.0f));
+    vec3 up = viewPosition(uv + vec2(0.0f, texel.y)) - position;
+    vec3 down = position - viewPosition(uv - vec2(0.0f, texel.y));
+    vec3 normal = normalize(cross(abs(right.z) < abs(left.z) ? right : left, abs(up.z) < abs(down.z) ? up : down));
+
+    // Interleaved gradient noise turns the kernel differently in every pixel, the blur removes the pattern
+    float angle = 6.2831853f * fract(52.9829189f * fract(dot(gl_FragCoord.xy, vec2(0.06711056f, 0.00583715f))));
+    vec3 random = vec3(cos(angle), sin(angle), 0.0f);
+    vec3 tangent = normalize(random - normal * dot(random, normal));
+    mat3 TBN = mat3(tangent, cross(normal, tangent), normal);
+
+    float hidden = 0.0f;
+    for (int i = 0; i < sampleCount; i++)
+    {
+        vec3 samplePos = position + TBN * kernel[i] * radius;
+        vec4 offset = projection * vec4(samplePos, 1.0f);
+        float sceneDepth = viewPosition(offset.xy / offset.w * 0.5f + 0.5f).z;
+        // A Sphere much closer to the camera than the radius doesn't hide this one
+        float range = smoothstep(0.0f, 1.0f, radius / abs(position.z - sceneDepth));
+        hidden += (sceneDepth >= samplePos.z + 0.02f * radius ? 1.0f : 0.0f) * range;
+    }
+    occlusion = vec2(pow(1.0f - hidden / float(sampleCount), intensity), -position.z);
+}
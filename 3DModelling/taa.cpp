@@ -0,0 +1,96 @@
+// The resolve follows Karis "High Quality Temporal Supersampling" (SIGGRAPH 2014) and the clamping in YCoCg of
+// Salvi "An Excursion in Temporal Supersampling" (GDC 2016)
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "taa.h"
+
+/*TAA variables
+*
+* @taaTextureUnit is the texture unit of the frame, the depth and the history are the next two, the units before it hold the
+* lighting inputs, the bloom and the shells
+*
+*/
+const int taaTextureUnit = 14;
+
+// The radical inverse of @index in @base, the Halton sequence starts at 1 since 0 would give 0 in every base
+static float radicalInverse(unsigned index, unsigned base) {
+
+	float result = 0.0f;
+	float fraction = 1.0f / base;
+	while (index > 0) {
+		result += (index % base) * fraction;
+		index /= base;
+		fraction /= base;
+	}
+	return result;
+}
+
+glm::vec2 jitterOffset(unsigned frame, int sequenceLength) {
+
+	unsigned index = frame % (unsigned)sequenceLength + 1;
+	return glm::vec2(radicalInverse(index, 2), radicalInverse(index, 3)) - 0.5f;
+}
+
+glm::mat4 jitterProjection(const TemporalAA& taa, const glm::mat4& projection, int width, int height) {
+
+	glm::vec2 offset = jitterOffset(taa.frame, taa.sequenceLength);
+	// The third column is multiplied by the depth and divided by it again, so it moves every point by the same amount in clip space
+	glm::mat4 jittered = projection;
+	jittered[2][0] += offset.x * 2.0f / width;
+	jittered[2][1] += offset.y * 2.0f / height;
+	return jittered;
+}
+
+const Framebuffer& resolveTemporalAA(TemporalAA& taa, const Framebuffer& scene, const glm::mat4& model, const glm::mat4& viewProjection) {
+
+	Framebuffer& history = taa.history[taa.current];
+	Framebuffer& target = taa.history[1 - taa.current];
+	if (history.width != scene.width || history.height != scene.height)
+		taa.valid = false;
+	resizeFramebuffer(history, scene.width, scene.height, { GL_RGBA16F }, false);
+	resizeFramebuffer(target, scene.width, scene.height, { GL_RGBA16F }, false);
+
+	// From this frame's pixels to the last frame's clip space, inverted in double precision since the depth is close to 1.
+	// Both ends are without the jitter, so a still camera samples the history at the same pixel and not at pixel - jitter
+	glm::mat4 current = viewProjection * model;
+	glm::mat4 reprojection = taa.previousViewProjection * glm::mat4(glm::inverse(glm::dmat4(current)));
+
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	bindFramebuffer(target);
+	glUseProgram(taa.program);
+	glActiveTexture(GL_TEXTURE0 + taaTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, scene.colors[0]);
+	glActiveTexture(GL_TEXTURE0 + taaTextureUnit + 1);
+	glBindTexture(GL_TEXTURE_2D, scene.depth);
+	glActiveTexture(GL_TEXTURE0 + taaTextureUnit + 2);
+	glBindTexture(GL_TEXTURE_2D, history.colors[0]);
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(glGetUniformLocation(taa.program, "scene"), taaTextureUnit);
+	glUniform1i(glGetUniformLocation(taa.program, "sceneDepth"), taaTextureUnit + 1);
+	glUniform1i(glGetUniformLocation(taa.program, "history"), taaTextureUnit + 2);
+	glUniformMatrix4fv(glGetUniformLocation(taa.program, "reprojection"), 1, GL_FALSE, glm::value_ptr(reprojection));
+	glUniform1f(glGetUniformLocation(taa.program, "feedback"), taa.feedback);
+	glUniform1i(glGetUniformLocation(taa.program, "historyValid"), taa.valid);
+	drawFullscreenTriangle();
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+
+	taa.previousViewProjection = current;
+	taa.current = 1 - taa.current;
+	taa.frame++;
+	taa.valid = true;
+	return target;
+}
+
+void resetTemporalAA(TemporalAA& taa) {
+	taa.valid = false;
+}
+
+void deleteTemporalAA(TemporalAA& taa) {
+
+	deleteFramebuffer(taa.history[0]);
+	deleteFramebuffer(taa.history[1]);
+	taa.valid = false;
+}
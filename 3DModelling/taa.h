@@ -0,0 +1,58 @@
+#ifndef taa_H
+#define taa_H
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "framebuffer.h"
+
+/* Temporal Anti-Aliasing
+*
+* Every frame is drawn with the projection moved by a different fraction of a pixel, the Halton (2, 3) sequence, and blended with
+* the frames before it, so over @sequenceLength frames every pixel gathers that many samples for the cost of one.
+* The resolve reprojects the history with the depth of the frame: a pixel is taken back to the model space with this frame's
+* matrices and forward with the last frame's ones, which follows the camera and the model rotation. The Planets moving on their
+* own aren't followed, the history is clamped to the colours around the pixel in this frame, which also hides what was disoccluded.
+* @sequenceLength is how many jitter positions there are before the sequence repeats
+* @feedback is how much of the history is kept every frame, the higher the smoother but the slower it reacts. The alpha of the
+* history counts its frames, until there are 1 / (1 - @feedback) of them they all weigh the same, which is 2 jitter sequences
+* @program is built from deferred_vert.glsl and taa_frag.glsl
+* @history holds the last resolved frame and gets the next one, the two are swapped after every resolve
+* @previousViewProjection is the last frame's projection * view * model without the jitter
+* @valid is false when there is no history yet, the next resolve gives the frame as it is
+*
+*/
+struct TemporalAA
+{
+	int sequenceLength = 16;
+	float feedback = 0.97f;
+
+	GLuint program = 0;
+	Framebuffer history[2];
+	int current = 0;
+	unsigned frame = 0;
+	glm::mat4 previousViewProjection;
+	bool valid = false;
+};
+
+// Offset of the frame @frame in pixels, both coordinates are between -0.5 and 0.5
+glm::vec2 jitterOffset(unsigned frame, int sequenceLength);
+
+// @projection moved by the jitter of this frame for a target of @width by @height pixels
+glm::mat4 jitterProjection(const TemporalAA& taa, const glm::mat4& projection, int width, int height);
+
+/*
+* Blends @scene, drawn with the jittered projection, with the history and returns the framebuffer of the result.
+* @viewProjection is projection * view without the jitter, the motion of the pixels leaves the jitter out
+*
+*/
+const Framebuffer& resolveTemporalAA(TemporalAA& taa, const Framebuffer& scene, const glm::mat4& model, const glm::mat4& viewProjection);
+
+// Drops the history, for when the frame changed so much that it would only smear, or TAA was off
+void resetTemporalAA(TemporalAA& taa);
+
+void deleteTemporalAA(TemporalAA& taa);
+
+#endif
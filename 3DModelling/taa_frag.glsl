@@ -0,0 +1,87 @@
+#version 330 core
+out vec4 color;
+
+// The temporal anti-aliasing resolve, see taa.h
+uniform sampler2D scene;            //drawn with the jittered projection
+uniform sampler2D sceneDepth;
+uniform sampler2D history;
+uniform mat4 reprojection;          //from this frame's normalized device coordinates to the last frame's clip space
+uniform float feedback;
+uniform bool historyValid;
+
+// The clamping is done in YCoCg, the box of the neighbours follows the brightness and the colour apart
+vec3 toYCoCg(vec3 c)
+{
+    return vec3(0.25f * c.r + 0.5f * c.g + 0.25f * c.b, 0.5f * c.r - 0.5f * c.b, -0.25f * c.r + 0.5f * c.g - 0.25f * c.b);
+}
+
+vec3 fromYCoCg(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// The history with a Catmull-Rom filter from 5 bilinear taps, a bilinear history would get blurrier every frame the camera moves
+vec3 sampleHistory(vec2 uv)
+{
+    vec2 size = vec2(textureSize(history, 0));
+    vec2 position = uv * size;
+    vec2 center = floor(position - 0.5f) + 0.5f;
+    vec2 f = position - center;
+    vec2 w0 = f * (-0.5f + f * (1.0f - 0.5f * f));
+    vec2 w1 = 1.0f + f * f * (-2.5f + 1.5f * f);
+    vec2 w2 = f * (0.5f + f * (2.0f - 1.5f * f));
+    vec2 w3 = f * f * (-0.5f + 0.5f * f);
+    vec2 w12 = w1 + w2;
+    vec2 uv0 = (center - 1.0f) / size;
+    vec2 uv3 = (center + 2.0f) / size;
+    vec2 uv12 = (center + w2 / w12) / size;
+
+    vec3 sum = texture(history, vec2(uv12.x, uv0.y)).rgb * w12.x * w0.y;
+    sum += texture(history, vec2(uv0.x, uv12.y)).rgb * w0.x * w12.y;
+    sum += texture(history, uv12).rgb * w12.x * w12.y;
+    sum += texture(history, vec2(uv3.x, uv12.y)).rgb * w3.x * w12.y;
+    sum += texture(history, vec2(uv12.x, uv3.y)).rgb * w12.x * w3.y;
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    // The negative lobes can overshoot below 0 next to a bright edge
+    return max(sum / weight, 0.0f);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(scene, 0) - 1;
+    vec3 current = texelFetch(scene, pixel, 0).rgb;
+    if (!historyValid)
+    {
+        color = vec4(current, 1.0f);
+        return;
+    }
+
+    vec3 minimum = toYCoCg(current);
+    vec3 maximum = minimum;
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+        {
+            vec3 neighbour = toYCoCg(texelFetch(scene, clamp(pixel + ivec2(x, y), ivec2(0), last), 0).rgb);
+            minimum = min(minimum, neighbour);
+            maximum = max(maximum, neighbour);
+        }
+
+    // The motion of the pixel, from where its point was last frame. The background has the depth 1, it is reprojected as
+    // if it was on the far plane, which is right for the rotations
+    vec2 uv = gl_FragCoord.xy / vec2(textureSize(scene, 0));
+    float depth = texelFetch(sceneDepth, pixel, 0).r;
+    vec4 previous = reprojection * vec4(uv * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+    vec2 previousUV = previous.xy / previous.w * 0.5f + 0.5f;
+    if (previous.w <= 0.0f || any(lessThan(previousUV, vec2(0.0f))) || any(greaterThan(previousUV, vec2(1.0f))))
+    {
+        color = vec4(current, 1.0f);
+        return;
+    }
+    vec3 past = fromYCoCg(clamp(toYCoCg(sampleHistory(previousUV)), minimum, maximum));
+
+    // The alpha counts the frames in the history. Until there are 1 / (1 - feedback) of them every frame gets the same weight,
+    // so a pixel that just came on screen averages all the jitter positions instead of keeping its first frame longest
+    float frames = min(texture(history, previousUV).a + 1.0f, 1.0f / (1.0f - feedback));
+    color = vec4(mix(past, current, 1.0f / frames), frames);
+}
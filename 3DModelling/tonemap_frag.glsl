@@ -0,0 +1,23 @@
+#version 330 core
+out vec4 color;
+
+// The HDR frame and its bloom, see bloom.h
+uniform sampler2D scene;
+uniform sampler2D bloom;
+uniform float bloomStrength;
+uniform float exposure;
+
+// The filmic curve of ACES fitted by Narkowicz, it maps any brightness into [0, 1] with a soft shoulder
+vec3 filmic(vec3 x)
+{
+    return clamp((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f), 0.0f, 1.0f);
+}
+
+void main()
+{
+    vec3 hdr = texelFetch(scene, ivec2(gl_FragCoord.xy), 0).rgb;
+    if (bloomStrength > 0.0f)
+        hdr += texture(bloom, gl_FragCoord.xy / vec2(textureSize(scene, 0))).rgb * bloomStrength;
+    // The colours of the program were always picked for the screen as they are, so no gamma curve is added
+    color = vec4(filmic(hdr * exposure), 1.0f);
+}
@@ -2,16 +2,39 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
+#if INSTANCED
+layout (location = 2) in vec4 centerRadius;  //one per Sphere, the mesh is drawn once for all of them
+layout (location = 3) in vec3 instanceObjectColor;
+layout (location = 4) in vec3 instanceLightColor;
+
+flat out vec3 ObjectColor;
+flat out vec3 LightColor;
+flat out vec3 LightPos;  //the light of a Sphere is at its center
+#endif
+
 out vec3 Normal;
 out vec3 FragPos;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec3 center;
+uniform float radius;
 
 void main()
 {
-    gl_Position = projection * view *  model * vec4(position, 1.0f);
-    FragPos = vec3(model * vec4(position, 1.0f));
+#if INSTANCED
+    vec3 center = centerRadius.xyz;
+    float radius = centerRadius.w;
+    ObjectColor = instanceObjectColor;
+    LightColor = instanceLightColor;
+    LightPos = center;
+#endif
+    vec3 worldPos = radius * position + center;  //the cached Sphere mesh is a unit Sphere, the Grid uses radius 1 and center 0
+    gl_Position = projection * view *  model * vec4(worldPos, 1.0f);
+    FragPos = vec3(model * vec4(worldPos, 1.0f));
     Normal = mat3(transpose(inverse(model))) * normal;  //generate normal matrix (3 by 3) from model matrix (4 by 4)
 } 
\ No newline at end of file